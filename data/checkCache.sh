@@ -0,0 +1,30 @@
+#!/bin/bash
+#
+#   Check that a noisy robustness map gives identical results against a warm result cache,
+#   and that the second run is served from the cache without adding entries.
+#   Run from the build directory: ../data/checkCache.sh [executable]
+#
+
+BIN=${1:-./ControlSoftware}
+CACHE=../data/cacheCheck_cache.csv
+OUTPUT=../data/cache_check_deviations.csv
+
+rm -f $CACHE
+
+$BIN ../data/cacheCheck.ini > /dev/null || exit 1
+cp $OUTPUT $OUTPUT.cold
+ENTRIES=$(wc -l < $CACHE)
+
+$BIN ../data/cacheCheck.ini > /dev/null || exit 1
+
+if ! cmp -s $OUTPUT $OUTPUT.cold; then
+    echo "Warm cache run differs from cold run"
+    exit 1
+fi
+if [ "$(wc -l < $CACHE)" -ne "$ENTRIES" ]; then
+    echo "Warm cache run added entries to the cache"
+    exit 1
+fi
+
+rm -f $OUTPUT.cold
+echo "Cache check passed ($ENTRIES entries)"
@@ -0,0 +1,25 @@
+#!/bin/bash
+#
+#   Check that a robustness map computed by sharded workers and merged is identical to the
+#   map of a single process.
+#   Run from the build directory: ../data/checkShards.sh [executable]
+#
+
+BIN=${1:-./ControlSoftware}
+N=3
+
+$BIN --shard 0 1 > /dev/null || exit 1
+cp ../data/deviations.csv ../data/deviations.csv.single
+cp ../data/stateOffsets.csv ../data/stateOffsets.csv.single
+
+"$(dirname "$0")"/runShards.sh $N $BIN > /dev/null || exit 1
+
+for f in deviations stateOffsets; do
+    if ! cmp -s ../data/$f.csv ../data/$f.csv.single; then
+        echo "Merged $f.csv differs from single-process map"
+        exit 1
+    fi
+    rm -f ../data/$f.csv.single
+done
+
+echo "Shard check passed ($N shards)"
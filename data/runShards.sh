@@ -0,0 +1,30 @@
+#!/bin/bash
+#
+#   Compute the robustness map with N local worker processes and merge the shards.
+#   Run from the build directory: ../data/runShards.sh [N] [executable]
+#   Workers on other hosts can run "ControlSoftware --shard <i> <N>" on a shared
+#   file system instead, followed by a single "ControlSoftware --merge <N>".
+#
+
+N=${1:-4}
+BIN=${2:-./ControlSoftware}
+PIDS=()
+
+for ((i=0; i<N; i++)); do
+    $BIN --shard $i $N > /dev/null &
+    PIDS+=($!)
+done
+
+# Merge only if every worker completed its shard
+FAILED=0
+for ((i=0; i<N; i++)); do
+    if ! wait ${PIDS[$i]}; then
+        echo "Worker $i of $N failed"
+        FAILED=1
+    fi
+done
+if [ $FAILED -ne 0 ]; then
+    exit 1
+fi
+
+$BIN --merge $N
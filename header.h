@@ -11,12 +11,40 @@
 #include <fstream>
 #include <math.h>
 #include <string>
+#include <sstream>
+#include <algorithm>
+#include <array>
+#include <map>
+#include <cstring>
 
+#include "include/logger.h"         // #include src code
+#include "include/logger.ipp"
+#include "include/cache.h"          // #include src code
+#include "include/reference.h"      // #include src code
 #include "include/saturator.h"      // #include src code
 #include "include/controller.h"     // #include src code
 #include "include/controller.ipp"
+#include "include/plantModel.h"     // #include src code
+#include "include/integrator.h"     // #include src code
+#include "include/rocketModel.h"    // #include src code
+#include "include/rocketModel.ipp"
+#include "include/poweredAscentModel.h"     // #include src code
+#include "include/poweredAscentModel.ipp"
 #include "include/dynamics.h"       // #include src code
+#include "include/linearization.h"  // #include src code
+#include "include/identification.h" // #include src code
+#include "include/metrics.h"        // #include src code
+#include "include/resultStore.h"    // #include src code
+#include "include/trajectoryCodec.h"    // #include src code
+#include "include/surrogate.h"      // #include src code
+#include "include/surrogate.ipp"
+#include "include/journal.h"        // #include src code
+#include "include/scheduler.h"      // #include src code
+#include "include/sampler.h"        // #include src code
+#include "include/pareto.h"         // #include src code
 #include "include/simulator.h"      // #include src coude
+#include "include/scenario.h"       // #include src code
+#include "include/capi.h"           // #include src code
 
 #include "include/helpers.h"        // #include src coude
 
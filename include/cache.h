@@ -0,0 +1,130 @@
+/**
+ *	\file include/cache.h
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#pragma once
+
+#include <Eigen/Dense>              // #include module
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace Eigen;              // using namespace of module
+
+class configHash
+{
+    //
+	// PUBLIC MEMBER FUNCTIONS:
+	//
+    public:
+        /** Default constructor (empty configuration)
+         */
+        configHash(  );
+
+        /** Add raw bytes to the hash (FNV-1a, 64 bit)
+         *
+         * @param[in] data          Pointer to data
+         * @param[in] size          Number of bytes
+         */
+        void add( const void* data, size_t size );
+
+        /** Add configuration values to the hash
+         */
+        void add( float value );
+        void add( double value );
+        void add( unsigned int value );
+        void add( const std::string& value );
+        void add( const VectorXf& value );
+        void add( const VectorXd& value );
+        void add( const MatrixXf& value );
+        void add( const MatrixXd& value );
+
+        /** Returns hash of the configuration
+         */
+        uint64_t value(  ) const;
+
+    //
+	// PRIVATE DATA MEMBER:
+	//
+    private:
+        uint64_t state;                 // Current hash value
+};
+
+
+class resultCache
+{
+    //
+	// PUBLIC MEMBER FUNCTIONS:
+	//
+    public:
+        /** Default constructor (inactive cache)
+         */
+        resultCache(  );
+
+        /** Constructor which opens (or creates) an on-disk cache
+         *
+         * @param[in] _fileName     Cache file, one line per run: key,result...[;state...]#checksum
+         */
+        resultCache( std::string _fileName );
+
+        /** Destructor
+         */
+        virtual ~resultCache(  );
+
+
+        /** Look up result of a run
+         *
+         * @param[in] key           Configuration hash of the run
+         * @param[out] result       Cached result
+         *
+         * \return True if the run was found in the cache
+         */
+        bool lookup( uint64_t key, VectorXf& result ) const;
+
+        /** Look up result of a run and the noise generator states after it
+         *
+         * @param[in] key           Configuration hash of the run
+         * @param[out] result       Cached result
+         * @param[out] states       Generator states after the run (empty for noise-free runs)
+         *
+         * \return True if the run was found in the cache
+         */
+        bool lookup( uint64_t key, VectorXf& result, std::vector<std::string>& states ) const;
+
+        /** Store result of a run (in memory and appended to the cache file)
+         *
+         * @param[in] key           Configuration hash of the run
+         * @param[in] result        Result of the run
+         */
+        void store( uint64_t key, const VectorXf& result );
+
+        /** Store result of a run with the noise generator states after it, so that a later
+         *  lookup can continue the noise streams as if the run had been simulated
+         *
+         * @param[in] key           Configuration hash of the run
+         * @param[in] result        Result of the run
+         * @param[in] states        Generator states after the run
+         */
+        void store( uint64_t key, const VectorXf& result, const std::vector<std::string>& states );
+
+
+        /** Returns if a cache file was configured
+         */
+        bool isActive(  ) const;
+
+        /** Returns number of cached runs
+         */
+        unsigned int size(  ) const;
+
+
+    //
+	// PRIVATE DATA MEMBER:
+	//
+    private:
+        std::string fileName;                                   // Cache file name
+        std::unordered_map<uint64_t, VectorXf> entries;         // Cached results
+        std::unordered_map<uint64_t, std::vector<std::string> > generatorStates;    // States after noisy runs
+};
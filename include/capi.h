@@ -0,0 +1,87 @@
+/**
+ *	\file include/capi.h
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Version of the batch simulation ABI (incremented on incompatible changes) */
+#define ROCKETSIM_API_VERSION 1
+
+
+/** Batch of closed-loop runs. All arrays are contiguous, row-major and owned by the caller;
+ *  they are read in place and must stay valid during the call.
+ */
+typedef struct
+{
+    unsigned int nRuns;                 /* Number of runs */
+    unsigned int nThreads;              /* Number of threads (0: number of hardware threads) */
+
+    float simulationTime;               /* Simulation time of each run */
+    float samplingTime;                 /* Sampling time of controller and plant */
+    float initTime;                     /* Initial time */
+
+    const float* initStates;            /* Initial states (nRuns x 4: x, y, Vx, Vy) */
+    const float* gains;                 /* PID gains (nRuns x 6: p0 p1 i0 i1 d0 d1) */
+
+    unsigned int nParameters;           /* Number of model parameters varied per run (may be 0) */
+    const char* const* parameterNames;  /* Model parameter names (nParameters, see rocketModel) */
+    const float* parameters;            /* Model parameter values (nRuns x nParameters) */
+
+    float limits[4];                    /* Airbrake lower, upper, lower rate and upper rate limit */
+
+    unsigned int nReference;            /* Number of reference samples (0: zero reference) */
+    const float* referenceTime;         /* Reference sample times (nReference, strictly increasing) */
+    const float* referenceData;         /* Altitude and velocity reference (2 x nReference) */
+    unsigned int referenceOrder;        /* Order of the Chebyshev fit of the reference */
+
+    unsigned int nMetrics;              /* Number of metrics per run (may be 0) */
+    const char* const* metricNames;     /* Metric names (nMetrics, see metricSet::add) */
+
+    unsigned int decimation;            /* Store state every decimation-th step (0: no trajectories) */
+} rocketsim_batch;
+
+
+/** Caller-owned outputs of a batch
+ */
+typedef struct
+{
+    float* apogee;                      /* Apogee of each run (nRuns) */
+    float* metrics;                     /* Metrics of each run (nRuns x nMetrics), may be NULL */
+    float* trajectories;                /* States of each run (nRuns x samples x 4), may be NULL,
+                                           samples as returned by rocketsim_trajectory_samples */
+} rocketsim_results;
+
+
+/** Returns ABI version of the library (ROCKETSIM_API_VERSION it was built with)
+ */
+int rocketsim_api_version( void );
+
+/** Returns number of trajectory samples per run of a batch
+ *
+ * @param[in] batch         Batch description
+ */
+unsigned int rocketsim_trajectory_samples( const rocketsim_batch* batch );
+
+/** Simulate a batch of closed-loop runs
+ *
+ * @param[in] batch         Batch description
+ * @param[out] results      Caller-owned output arrays
+ * @param[out] error        Error message buffer (may be NULL)
+ * @param[in] errorSize     Size of error message buffer
+ *
+ * \return 0 on success, non-zero on error (message in error)
+ */
+int rocketsim_simulate_batch( const rocketsim_batch* batch, rocketsim_results* results, char* error, size_t errorSize );
+
+#ifdef __cplusplus
+}
+#endif
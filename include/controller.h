@@ -8,17 +8,25 @@
 #pragma once
 
 #include <Eigen/Dense>              // #include module
+#include <memory>
 using namespace Eigen;              // using namespace of module
 
-class PIDcontroller : public saturator
+/** PID control law with reference trajectory and saturation. Templated on the scalar type
+ *  of the signals: the control law is evaluated entirely in Scalar (gains are configured in
+ *  float and rounded once).
+ */
+template <class Scalar>
+class scalarPIDcontroller : public scalarSaturator<Scalar>
 {
+    template <class Other> friend class scalarPIDcontroller;
+
 	//
 	// PUBLIC MEMBER FUNCTIONS:
 	//
     public:
 		/** Default constructor. 
 		 */
-        PIDcontroller(  );
+        scalarPIDcontroller(  );
 
         /** Constructor which takes the number of inputs and outputs of the
 		 *	PID controller as well as the sampling time.
@@ -27,17 +35,30 @@ class PIDcontroller : public saturator
          * @param[in] _nOuputs          Number of inputs
          * @param[in] _samplingTime     Sampling time
 		 */
-        PIDcontroller( unsigned int _nInputs, unsigned int _nOuputs, float _sampleTime );
+        scalarPIDcontroller( unsigned int _nInputs, unsigned int _nOuputs, float _sampleTime );
         
         /** Copy constructor
 		 *
 		 *	@param[in] rhs	Right-hand side object.
 		 */
-		PIDcontroller( const PIDcontroller& rhs );
+		scalarPIDcontroller( const scalarPIDcontroller& rhs );
+
+        /** Copy assignment (same members as the copy constructor)
+		 *
+		 *	@param[in] rhs	Right-hand side object.
+		 */
+		scalarPIDcontroller& operator=( const scalarPIDcontroller& rhs ) = default;
+
+        /** Converting constructor (same configuration and state in another precision)
+		 *
+		 *	@param[in] rhs	Right-hand side object.
+		 */
+        template <class Other>
+		explicit scalarPIDcontroller( const scalarPIDcontroller<Other>& rhs );
 
 		/** Destructor
 		 */
-		virtual ~PIDcontroller( );
+		virtual ~scalarPIDcontroller( );
 
 
         /** Assign proportional gains to input components
@@ -58,6 +79,27 @@ class PIDcontroller : public saturator
          */
         void setDerivativeGains( const VectorXf& _dGains );
 
+        /** Assign proportional gain to one input component
+         * 
+         * @param[in] idx         Index of input component
+         * @param[in] _pGain      New proportional weight
+         */
+        void setProportionalGains( unsigned int idx, float _pGain );
+
+        /** Assign integral gain to one input component
+         * 
+         * @param[in] idx         Index of input component
+         * @param[in] _iGain      New integral weight
+         */
+        void setIntegralGains( unsigned int idx, float _iGain );
+
+        /** Assign derivative gain to one input component
+         * 
+         * @param[in] idx         Index of input component
+         * @param[in] _dGain      New derivative weight
+         */
+        void setDerivativeGains( unsigned int idx, float _dGain );
+
 
         /** Set reference trajectory using polynomial coefficients
          * 
@@ -66,6 +108,18 @@ class PIDcontroller : public saturator
          */
         void setPolynomialReference( const MatrixXf& _refCoeff );
 
+        /** Set reference trajectory from a fitted reference (Chebyshev, spline or monomial)
+         * 
+         * @param[in] _reference    Reference trajectory, one signal per input
+         */
+        void setReference( const referenceTrajectory& _reference );
+
+        /** Set reference trajectory shared with other controllers (read-only)
+         * 
+         * @param[in] _reference    Shared reference trajectory, one signal per input
+         */
+        void setReference( std::shared_ptr<const referenceTrajectory> _reference );
+
 
         /** Initilizes the control law with given start values and performs consitency checks
          * 
@@ -73,14 +127,14 @@ class PIDcontroller : public saturator
          * @param[in] _x                Initial value for differential states
          * @param[in] _yRef             Initial value for reference trajectory
          */
-        void init( const VectorXf& _x0, const VectorXf& _yRef, double startTime );
+        void init( const VectorX<Scalar>& _x0, const VectorX<Scalar>& _yRef, double startTime );
 
         /** Initilizes the control law with given start values and performs consitency checks
          * 
          * @param[in] _startTime        Start time
          * @param[in] _x                Initial value for differential states
          */
-        void init( const VectorXf& _x0, double startTime );
+        void init( const VectorX<Scalar>& _x0, double startTime );
 
         /** Perform step of control law based on inputs
          * @param[in] currentTime   Current time
@@ -88,14 +142,14 @@ class PIDcontroller : public saturator
          * @param[in] _yRef         Current reference trajectory
          * 
          */
-        void step( double currentTime, const VectorXf& _x, const VectorXf& _yRef );
+        void step( double currentTime, const VectorX<Scalar>& _x, const VectorX<Scalar>& _yRef );
 
         /** Perform step of control law based on inputs and predefined reference
          * @param[in] currentTime   Current time
          * @param[in] _x            Current value of differential states
          * 
          */
-        void step( double currentTime, const VectorXf& _x );
+        void step( double currentTime, const VectorX<Scalar>& _x );
 
 
         /** Returns control signal as determined by control law
@@ -103,13 +157,41 @@ class PIDcontroller : public saturator
          * @param[out] _u   Control signal
          * 
          */
-        inline void getU( VectorXf& _u );
+        inline void getU( VectorX<Scalar>& _u );
+
+        /** Returns tracking error (reference - output) of the last step of the control law
+         * 
+         * @param[out] _e   Tracking error
+         * 
+         */
+        inline void getError( VectorX<Scalar>& _e ) const;
 
 
         /** Reset controller to inital state
          */
         void resetController(  );
 
+
+        /** Add configuration to hash identifying a simulation run
+         * 
+         * @param[in,out] hash          Configuration hash
+         */
+        void hashConfiguration( configHash& hash ) const;
+
+
+        /** Generate a standalone C header implementing this controller (reference, PID law,
+         *  position and rate limits) for the flight computer. All constants are baked in as
+         *  exact literals and the signals have the scalar type of this controller (float or
+         *  double); the code uses no heap, no exceptions and only floor() from math.h.
+         *  Actuator bias and noise are simulation artefacts and are not generated.
+         *  The header defines <name>_state, <name>_init( state, y0, t ) and
+         *  <name>_step( state, t, y, u ), which reproduce init and step of this controller.
+         * 
+         * @param[in] fileName          Header file to write
+         * @param[in] name              Prefix of the generated identifiers
+         */
+        void generateCode( const std::string& fileName, const std::string& name ) const;
+
     //
 	// PRIVATE DATA MEMBER:
 	//
@@ -117,17 +199,17 @@ class PIDcontroller : public saturator
         unsigned int nInputs;           // Number of inputs
         unsigned int nOutputs;          // Number of Outputs
 
-        VectorXf pGains;                // Proportional gains for all input components
-        VectorXf iGains;                // Integral gains for all input components
-        VectorXf dGains;                // Derivative gains for all input components
+        VectorX<Scalar> pGains;         // Proportional gains for all input components
+        VectorX<Scalar> iGains;         // Integral gains for all input components
+        VectorX<Scalar> dGains;         // Derivative gains for all input components
 
-        VectorXf iValue;                // Integrated value for all input components
-        VectorXf lastError;             // Last error input
+        VectorX<Scalar> iValue;         // Integrated value for all input components
+        VectorX<Scalar> lastError;      // Last error input
 
         float samplingTime;             // Sampling time
 
-        MatrixXf refCoeff;              // Reference using polynomial coefficients
-        VectorXf u;                     // Control input
+        std::shared_ptr<const referenceTrajectory> reference;   // Reference trajectory (shared, read-only)
+        VectorX<Scalar> u;              // Control input
     
 
     //
@@ -139,5 +221,8 @@ class PIDcontroller : public saturator
          * @param[in] error     Current error
          * @param[out] output   Current control action
          */
-        void determineControlAction( const VectorXf& error, VectorXf& output );
+        void determineControlAction( const VectorX<Scalar>& error, VectorX<Scalar>& output );
 };
+
+
+typedef scalarPIDcontroller<float> PIDcontroller;   // PID controller on single-precision signals
@@ -8,7 +8,15 @@
 #include "../header.h"    // #include header
 
 
-inline void PIDcontroller::getU(   VectorXf& _u    )
+template <class Scalar>
+inline void scalarPIDcontroller<Scalar>::getU(   VectorX<Scalar>& _u    )
 {
     _u = u;
-}
\ No newline at end of file
+}
+
+
+template <class Scalar>
+inline void scalarPIDcontroller<Scalar>::getError(   VectorX<Scalar>& _e    ) const
+{
+    _e = lastError;
+}
@@ -1,24 +1,50 @@
 /**
  *	\file include/dynamics.h
  *	\author Mike Timmerman
- *	\version 4.1
+ *	\version 5.0
  *	\date 2022
  */
 
 #pragma once
 
 #include <Eigen/Dense>              // #include module
+#include <memory>
+#include <random>
+#include <string>
+#include <type_traits>
 using namespace Eigen;              // using namespace of module
 
-class dynamics
+
+/** State of a single run: plain data, so it can be snapshotted and cloned with memcpy
+ */
+template <class Model, class Scalar = float>
+struct runState
+{
+    Scalar state[Model::NX];        // System state
+    Scalar time;                    // Current time
+    Scalar lastU[Model::NU];        // Previous control input
+    Scalar omega;                   // Stepper motor rotational speed (of first input)
+};
+
+
+/** Dynamics of a plant model (see plantModel): integration, run state, sensor noise and bias.
+ *  Templated on the model, so the model equations are inlined into the integrator, and on the
+ *  scalar type in which the state is integrated (noise and bias are configured in float).
+ */
+template <class Model, class Scalar = float>
+class plantDynamics
 {
+    template <class, class> friend class plantDynamics;
+
+    static_assert( std::is_trivially_copyable< runState<Model, Scalar> >::value, "runState must be trivially copyable" );
+
     //
 	// PUBLIC MEMBER FUNCTIONS:
 	//
     public:
         /** Default onstructor
          */
-        dynamics();
+        plantDynamics();
 
         /** Constructor which takes the number of states and outputs, initial state and time and sampling time
          * 
@@ -29,22 +55,35 @@ class dynamics
          * @param[in] _samplingTime Sampling time
          * @param[in] _initTime     Initial time
          */
-        dynamics(   unsigned int _nx,
-                    unsigned int _nu, 
-                    unsigned int _ny,
-                    VectorXf _initState,
-                    float _samplingTime, 
-                    float _initTime);
+        plantDynamics(  unsigned int _nx,
+                        unsigned int _nu, 
+                        unsigned int _ny,
+                        VectorXf _initState,
+                        float _samplingTime, 
+                        float _initTime);
         
         /** Copy constructor
 		 *
 		 *	@param[in] rhs	Right-hand side object.
 		 */
-		dynamics( const dynamics& rhs );
+		plantDynamics( const plantDynamics& rhs );
+
+        /** Copy assignment (same members as the copy constructor)
+		 *
+		 *	@param[in] rhs	Right-hand side object.
+		 */
+		plantDynamics& operator=( const plantDynamics& rhs ) = default;
+
+        /** Converting constructor (same configuration and run state in another precision)
+		 *
+		 *	@param[in] rhs	Right-hand side object.
+		 */
+        template <class Other>
+		explicit plantDynamics( const plantDynamics<Model, Other>& rhs );
 
 		/** Destructor
 		 */
-		virtual ~dynamics( );
+		~plantDynamics( );
 
 
         /** Set bias on control signals
@@ -59,13 +98,114 @@ class dynamics
          */
         void setNoise( const VectorXf& _noiseLevel );
 
+        /** Set bias on given component of output signal
+         * 
+         * @param[in] idx               Index of output signal component
+         * @param[in] _bias             New bias
+         */
+        void setBias( unsigned int idx, float _bias );
+
+        /** Set noise level on given component of output signal
+         * 
+         * @param[in] idx               Index of output signal component
+         * @param[in] _noiseLevel       New noise level
+         */
+        void setNoise( unsigned int idx, float _noiseLevel );
+
+        /** Seed the noise generator
+         * 
+         * @param[in] _seed             Seed of the random number generator
+         */
+        void setSeed( unsigned int _seed );
+
+        /** Mirror every noise draw about zero (antithetic stream): with the same seed, the
+         *  noise of a mirrored run is the negative of the noise of the unmirrored run
+         * 
+         * @param[in] _antithetic       Mirror noise draws
+         */
+        void setAntithetic( bool _antithetic );
+
+        /** Returns true if noise is added to the signals (the result depends on the generator)
+         */
+        bool isNoisy(  ) const;
+
+        /** Returns complete state of the noise generator (for checkpointing)
+         */
+        std::string getGeneratorState(  ) const;
+
+        /** Restore state of the noise generator from a checkpoint
+         * 
+         * @param[in] _state            Generator state as returned by getGeneratorState
+         */
+        void setGeneratorState( const std::string& _state );
+
+        /** Set model parameter by name. The shared model is copied first (copy-on-write),
+         *  other runs sharing the model are not affected.
+         * 
+         * @param[in] name              Parameter name (see model)
+         * @param[in] value             New value
+         */
+        void setParameter( const std::string& name, double value );
+
+        /** Returns model parameter by name
+         * 
+         * @param[in] name              Parameter name (see model)
+         */
+        double getParameter( const std::string& name ) const;
+
+        /** Share an immutable model between runs
+         * 
+         * @param[in] _model            Plant model
+         */
+        void setModel( std::shared_ptr<const Model> _model );
+
+        /** Returns the (shared) model
+         */
+        std::shared_ptr<const Model> getModel(  ) const;
+
+        /** Select the explicit Runge-Kutta scheme of the integration (see integrator.h). The
+         *  step of every scheme is compiled with its stages unrolled; selecting one stores a
+         *  pointer to it.
+         * 
+         * @param[in] name              Scheme: "euler", "heun", "rk3", "rk4" (default) or "dopri5"
+         */
+        void setIntegrator( const std::string& name );
+
+        /** Returns name of the integration scheme
+         */
+        const std::string& getIntegrator(  ) const;
+
+        /** Returns number of model evaluations per integration step
+         */
+        unsigned int getIntegratorEvaluations(  ) const;
+
+        /** Add configuration to hash identifying a simulation run
+         * 
+         * @param[in,out] hash          Configuration hash
+         */
+        void hashConfiguration( configHash& hash ) const;
+
 
         /** Update system state given an input and return output
          * 
          * @param[in] _u        Control input
          * @param[in] _y        System output
          */
-        void step( const VectorXf& _u, VectorXf& _y );
+        void step( const VectorX<Scalar>& _u, VectorX<Scalar>& _y );
+
+        /** Update system state over one sampling time given an input, without sampling the output
+         * 
+         * @param[in] _u        Control input
+         */
+        void integrate( const VectorX<Scalar>& _u );
+
+        /** Sample one output component (with sensor noise and bias) at the current state
+         * 
+         * @param[in] idx       Index of output signal component
+         * 
+         * \return Measured output
+         */
+        Scalar measure( unsigned int idx );
 
 
         /** Reset system to initial state
@@ -73,14 +213,37 @@ class dynamics
         void resetDynamics( const VectorXf& offsets=VectorXf::Zero( 100 ) );
 
 
+        /** Returns current system state
+         */
+        VectorX<Scalar> getState(  ) const;
+
+        /** Returns output of the model at the current state (without sensor noise and bias)
+         */
+        VectorX<Scalar> getOutput(  ) const;
+
+        /** Returns current time
+         */
+        Scalar getTime(  ) const;
+
+        /** Returns stepper motor rotational speed
+         */
+        Scalar getOmega(  ) const;
+
+        /** Returns snapshot of the run state
+         */
+        const runState<Model, Scalar>& getRunState(  ) const;
+
+        /** Continue from a snapshot of the run state
+         * 
+         * @param[in] _run              Run state
+         */
+        void setRunState( const runState<Model, Scalar>& _run );
+
+
     //
 	// PUBLIC DATA MEMBERS:
 	//
-        float time;             // Current time
         float samplingTime;     // Sampling time
-
-        VectorXf state;         // System state
-        float omega;            // Steppr motor rotational speed
         
 
 
@@ -88,22 +251,16 @@ class dynamics
 	// PRIVATE MEMBER FUNCTIONS:
 	//
     private:
-        /** Update system state using RK45
+        /** Update system state using the selected integration scheme
          * 
          * @param[in] _u        Control input
          */
-        void updateState( const VectorXf& _u );
+        void updateState( const VectorX<Scalar>& _u );
 
-        
-        /** Calculate state derivatives (rhs of equations of motion)
-         * 
-         * @param[in] _t        Current time
-         * @param[in] _state    Current state
-         * @param[in] _u        Control input
-         * 
-         * \return stateDerivative
+        /** Select the integration scheme of a Butcher tableau
          */
-        VectorXf rocketDynamics( float _t, VectorXf _state, const VectorXf& _u );
+        template <class Tableau>
+        void useIntegrator(  );
 
 
     //
@@ -115,34 +272,20 @@ class dynamics
 
         VectorXf bias;                  // bias on system output 
         VectorXf noiseLevel;            // Noise on system output
+        std::mt19937 generator;         // Noise generator
+        bool antithetic = false;        // Mirror noise draws
+
+        std::shared_ptr<const Model> model;             // Immutable model, shared between runs
+        runState<Model, Scalar> run;                    // State of the run
+
+        void (*integrator)( const plantModel<Model>&, Scalar, Scalar, Scalar*, const Scalar* )
+            = &explicitRungeKutta<classicalRungeKutta4, Model, Scalar>;     // Step of the integration scheme
+        std::string integratorName = classicalRungeKutta4::NAME;            // Integration scheme
+        unsigned int integratorEvaluations = 4;                             // Model evaluations per step
 
-        double p00 = 0.4165;			// Cd surface fit power coefficient
-        double p10 = 8.886;				// Cd = p00       + p10 * x     + p01 * y     + p20 * x^2 + p11 * x*y
-        double p01 = 0.3778;			//      p02 * y^2 + p21 * x^2*y + p12 * x*y^2 + p03 * y^3
-        double p20 = 43.25;				// with x: airbrake extension, y: mach number
-        double p11 = -10.48;
-        double p02 = -0.9093;
-        double p21 = 21.67;
-        double p12 = 22.7;
-        double p03 = 0.5587;
-
-        float g = 9.81;                 // Gravitational constant
-        float density_sea = 1.225;      // Sea-level density
-        float A = 0.0191;               // Cross-sectional area
-        float mass = 20.1;              // Mass at burn-out
-
-        float V;                        // Velocity magnitude
-        float M;                        // Mach number
-        float Cd_val;                   // Drag coefficient
-        float density;                  // Atmospheric density
         float initTime;                 // Initial time
         VectorXf initState;             // Initial state
-        VectorXf lastU;                 // Previous control input
-
-        // Runge-Kutta 45 integration
-        VectorXf k1;
-        VectorXf k2;
-        VectorXf k3;
-        VectorXf k4;
-        VectorXf stateDerivative;    
-};
\ No newline at end of file
+};
+
+
+typedef plantDynamics<rocketModel> dynamics;       // Dynamics of the 2-D point-mass rocket
@@ -8,6 +8,8 @@
 #pragma once
 
 #include <Eigen/Dense>            // #include module
+#include <functional>
+#include <string>
 using namespace Eigen;            // using namespace
 using namespace std;
 
@@ -24,6 +26,17 @@ using namespace std;
 MatrixXf loadFromFile(string FileName, int row, int col);
 
 
+/** Load grid data from csv file, dimensions are determined from the file. Encoded
+ *  trajectories (see trajectoryCodec) are decoded instead.
+ * 
+ * @param[in] FileName      File name from which to load in the data
+ * 
+ * \returns Matrix with all data from file
+ * 
+ */
+MatrixXf loadFromFile(string FileName);
+
+
 
 /** Upload grid data to csv file
  * 
@@ -34,3 +47,15 @@ MatrixXf loadFromFile(string FileName, int row, int col);
  * 
  */
 void saveToFile(MatrixXf &data, int rows, int cols, string FileName);
+
+
+/** Run fn(k) for k = 0, ..., n-1 on a pool of threads which take the indices in turn. All items
+ *  are run, then the first error is rethrown.
+ * 
+ * @param[in] n             Number of work items
+ * @param[in] nThreads      Number of threads (0 for one per hardware thread), at most n are started
+ * @param[in] fn            Work item, called with its index
+ * @param[in] item          Name of a work item in the error message, e.g. "Run 3: ..."
+ * 
+ */
+void parallelFor(unsigned int n, unsigned int nThreads, const std::function<void(unsigned int)>& fn, const string& item = "Item");
@@ -0,0 +1,187 @@
+/**
+ *	\file include/identification.h
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#pragma once
+
+#include <Eigen/Dense>              // #include module
+#include <memory>
+#include <string>
+#include <vector>
+using namespace Eigen;              // using namespace of module
+
+
+/** Identification of plant model parameters (see plantModel::setParameter, e.g. the Cd surface
+ *  coefficients, A and mass of the rocket) from recorded flights. Every flight log is replayed
+ *  open loop: the model is integrated from the logged initial state under the logged control
+ *  inputs, and the residuals are the differences between the simulated and the recorded outputs.
+ *
+ *  The parameters minimize the sum of squared (weighted) residuals by Levenberg-Marquardt, with
+ *  Marquardt's scaling of the damping by the diagonal of J'J, so the step does not depend on the
+ *  units of the parameters. The Jacobian of the residuals follows from the forward sensitivities
+ *  S = d(state)/d(parameters), integrated alongside the state:
+ *
+ *      dS/dt = df/dx S + df/dp,    S(0) = 0,     dy/dp = dh/dx S
+ *
+ *  with the same explicit Runge-Kutta scheme as the state, so they are the exact derivatives of
+ *  the discrete trajectory. The partial derivatives of the equations of motion are taken by
+ *  central differences, as in linearAnalysis. The logs are replayed in parallel, and the normal
+ *  equations are summed in log order, so the result does not depend on the number of threads.
+ *
+ *  Note that the drag of the rocket depends on A/mass times Cd only: A, mass and a common scale
+ *  of all Cd coefficients cannot be identified together (fix one of them).
+ */
+template <class Model>
+class parameterIdentification
+{
+    //
+	// PUBLIC MEMBER FUNCTIONS:
+	//
+    public:
+        /** Constructor
+         *
+         * @param[in] _model            Plant model (initial guess of the parameters)
+         * @param[in] _integrator       Integration scheme (see plantDynamics::setIntegrator)
+         */
+        parameterIdentification( std::shared_ptr<const Model> _model, const std::string& _integrator="rk4" );
+
+        /** Destructor
+         */
+        ~parameterIdentification(  );
+
+
+        /** Add a flight log. Columns as written by simulate: column 0 holds the initial sample,
+         *  column k+1 the input applied over step k and the output measured after it. Missing
+         *  measurements (NaN) are skipped.
+         *
+         * @param[in] initState         State at the first sample (Model::NX values)
+         * @param[in] initTime          Time of the first sample
+         * @param[in] samplingTime      Sampling time
+         * @param[in] outputs           Recorded outputs (Model::NY rows)
+         * @param[in] inputs            Applied control inputs (Model::NU rows)
+         */
+        void addLog( const VectorXd& initState, double initTime, double samplingTime,
+                     const MatrixXd& outputs, const MatrixXd& inputs );
+
+        /** Add a flight log from the files written by simulate (prefix + state, output and input,
+         *  CSV or encoded trajectories). The initial state is the first column of the state file.
+         *
+         * @param[in] prefix            File prefix, e.g. "../data/"
+         * @param[in] initTime          Time of the first sample
+         * @param[in] samplingTime      Sampling time
+         * @param[in] extension         File extension: ".csv" or ".trj"
+         */
+        void addLogFromFiles( const std::string& prefix, double initTime, double samplingTime,
+                              const std::string& extension=".csv" );
+
+        /** Returns number of flight logs
+         */
+        unsigned int getNumLogs(  ) const;
+
+        /** Set weights of the output residuals, e.g. the inverse of the measurement noise
+         *
+         * @param[in] _weights          Weight of every output (Model::NY values, default 1)
+         */
+        void setOutputWeights( const VectorXd& _weights );
+
+
+        /** Fit model parameters to all flight logs
+         *
+         * @param[in] names             Names of the fitted parameters
+         * @param[in] maxIterations     Maximum number of Levenberg-Marquardt iterations
+         * @param[in] nThreads          Number of threads (0: one per hardware thread)
+         *
+         * \return Fitted values of the parameters
+         */
+        VectorXd fit( const std::vector<std::string>& names, unsigned int maxIterations=50, unsigned int nThreads=0 );
+
+        /** Returns standard errors of the fitted parameters, from the residual variance and the
+         *  Jacobian at the solution
+         */
+        const VectorXd& getStandardErrors(  ) const;
+
+        /** Returns weighted root-mean-square residual at the solution
+         */
+        double getResidual(  ) const;
+
+        /** Returns model with the fitted parameters (to be shared with plantDynamics::setModel)
+         */
+        std::shared_ptr<const Model> getModel(  ) const;
+
+
+    //
+	// PRIVATE MEMBER FUNCTIONS:
+	//
+    private:
+        /** Recorded flight
+         */
+        struct flightLog
+        {
+            VectorXd initState;
+            double initTime;
+            double samplingTime;
+            MatrixXd outputs;
+            MatrixXd inputs;
+        };
+
+        /** Model at the current parameters and perturbed in every fitted parameter
+         */
+        struct fitModels
+        {
+            Model nominal;
+            std::vector<Model> plus;
+            std::vector<Model> minus;
+            VectorXd steps;             // Perturbation of every parameter
+        };
+
+        /** Build models for a set of parameter values
+         */
+        fitModels createModels( const std::vector<std::string>& names, const VectorXd& values ) const;
+
+        /** Sum of squared residuals of all logs (halved) and, if requested, the normal equations
+         *
+         * @param[out] JtJ              J'J of the residuals
+         * @param[out] Jtr              J'r of the residuals
+         * @param[out] nResiduals       Number of residuals
+         */
+        double evaluate( const fitModels& models, bool jacobian, unsigned int nThreads,
+                         MatrixXd& JtJ, VectorXd& Jtr, unsigned int& nResiduals ) const;
+
+        /** Replay one log, residuals and their Jacobian (one row per residual)
+         */
+        void replay( const fitModels& models, const flightLog& log, bool jacobian,
+                     VectorXd& residuals, MatrixXd& J ) const;
+
+        /** Derivative of state (column 0) and sensitivities (further columns)
+         */
+        void augmentedRhs( const fitModels& models, double t, const MatrixXd& Z, const double* u, MatrixXd& dZ ) const;
+
+        /** Select the integration scheme of a Butcher tableau
+         */
+        template <class Tableau>
+        void useScheme(  );
+
+        /** Advance state and sensitivities over one step with the scheme of a Butcher tableau
+         */
+        template <class Tableau>
+        void augmentedStep( const fitModels& models, double t, double h, const double* u, MatrixXd& Z,
+                            std::vector<MatrixXd>& k, MatrixXd& tmp ) const;
+
+
+    //
+	// PRIVATE DATA MEMBER:
+	//
+        std::shared_ptr<const Model> model;     // Plant model
+        std::vector<flightLog> logs;            // Recorded flights
+        VectorXd weights;                       // Weight of every output residual
+
+        void (parameterIdentification::*stepper)( const fitModels&, double, double, const double*, MatrixXd&,
+                                                  std::vector<MatrixXd>&, MatrixXd& ) const;    // Selected scheme
+        unsigned int stages;                    // Stages of the selected scheme
+
+        VectorXd standardErrors;                // Result of the last fit
+        double residual = 0.0;
+};
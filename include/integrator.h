@@ -0,0 +1,192 @@
+/**
+ *	\file include/integrator.h
+ *	\author Mike Timmerman
+ *	\version 2.0
+ *	\date 2022
+ */
+
+#pragma once
+
+#include <utility>
+
+
+/** Explicit Runge-Kutta schemes as constexpr Butcher tableaus: STAGES stages with coupling
+ *  coefficients a (strictly lower triangular), weights b and nodes c
+ */
+struct forwardEuler
+{
+    static constexpr const char* NAME = "euler";
+    static constexpr unsigned int STAGES = 1;
+    static constexpr unsigned int ORDER = 1;
+    static constexpr double a[1][1] = { { 0.0 } };
+    static constexpr double b[1] = { 1.0 };
+    static constexpr double c[1] = { 0.0 };
+};
+
+struct heun
+{
+    static constexpr const char* NAME = "heun";
+    static constexpr unsigned int STAGES = 2;
+    static constexpr unsigned int ORDER = 2;
+    static constexpr double a[2][2] = { { 0.0, 0.0 },
+                                        { 1.0, 0.0 } };
+    static constexpr double b[2] = { 0.5, 0.5 };
+    static constexpr double c[2] = { 0.0, 1.0 };
+};
+
+struct kutta3
+{
+    static constexpr const char* NAME = "rk3";
+    static constexpr unsigned int STAGES = 3;
+    static constexpr unsigned int ORDER = 3;
+    static constexpr double a[3][3] = { {  0.0, 0.0, 0.0 },
+                                        {  0.5, 0.0, 0.0 },
+                                        { -1.0, 2.0, 0.0 } };
+    static constexpr double b[3] = { 1.0/6.0, 2.0/3.0, 1.0/6.0 };
+    static constexpr double c[3] = { 0.0, 0.5, 1.0 };
+};
+
+struct classicalRungeKutta4
+{
+    static constexpr const char* NAME = "rk4";
+    static constexpr unsigned int STAGES = 4;
+    static constexpr unsigned int ORDER = 4;
+    static constexpr double a[4][4] = { { 0.0, 0.0, 0.0, 0.0 },
+                                        { 0.5, 0.0, 0.0, 0.0 },
+                                        { 0.0, 0.5, 0.0, 0.0 },
+                                        { 0.0, 0.0, 1.0, 0.0 } };
+    static constexpr double b[4] = { 1.0/6.0, 1.0/3.0, 1.0/3.0, 1.0/6.0 };
+    static constexpr double c[4] = { 0.0, 0.5, 0.5, 1.0 };
+};
+
+/** Dormand-Prince 5(4), fifth-order solution. The seventh stage only serves the embedded
+ *  error estimate (zero weight), so it is never evaluated.
+ */
+struct dormandPrince5
+{
+    static constexpr const char* NAME = "dopri5";
+    static constexpr unsigned int STAGES = 7;
+    static constexpr unsigned int ORDER = 5;
+    static constexpr double a[7][7] = { { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 },
+                                        { 1.0/5.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 },
+                                        { 3.0/40.0, 9.0/40.0, 0.0, 0.0, 0.0, 0.0, 0.0 },
+                                        { 44.0/45.0, -56.0/15.0, 32.0/9.0, 0.0, 0.0, 0.0, 0.0 },
+                                        { 19372.0/6561.0, -25360.0/2187.0, 64448.0/6561.0, -212.0/729.0, 0.0, 0.0, 0.0 },
+                                        { 9017.0/3168.0, -355.0/33.0, 46732.0/5247.0, 49.0/176.0, -5103.0/18656.0, 0.0, 0.0 },
+                                        { 35.0/384.0, 0.0, 500.0/1113.0, 125.0/192.0, -2187.0/6784.0, 11.0/84.0, 0.0 } };
+    static constexpr double b[7] = { 35.0/384.0, 0.0, 500.0/1113.0, 125.0/192.0, -2187.0/6784.0, 11.0/84.0, 0.0 };
+    static constexpr double c[7] = { 0.0, 1.0/5.0, 3.0/10.0, 4.0/5.0, 8.0/9.0, 1.0, 1.0 };
+};
+
+
+/** Coefficient of stage j in the increment of row i of a tableau (row STAGES: the weights b)
+ */
+template <class Tableau>
+constexpr double butcherCoefficient( unsigned int i, unsigned int j )
+{
+    return ( i < Tableau::STAGES ) ? Tableau::a[i][j] : Tableau::b[j];
+}
+
+
+/** Returns true if stage j contributes to the solution, directly or through a later stage
+ */
+template <class Tableau>
+constexpr bool butcherStageUsed( unsigned int j )
+{
+    if ( Tableau::b[j] != 0.0 )
+        return true;
+    for ( unsigned int i=j+1; i<Tableau::STAGES; i++ )
+        if ( Tableau::a[i][j] != 0.0 && butcherStageUsed<Tableau>( i ) )
+            return true;
+    return false;
+}
+
+
+/** Returns number of right-hand side evaluations per step
+ */
+template <class Tableau>
+constexpr unsigned int butcherEvaluations(  )
+{
+    unsigned int n = 0;
+    for ( unsigned int j=0; j<Tableau::STAGES; j++ )
+        n += butcherStageUsed<Tableau>( j );
+    return n;
+}
+
+
+/** Add the contribution of stage J to row I (I = STAGES: solution), nothing for zero coefficients
+ */
+template <class Tableau, unsigned int I, unsigned int J, unsigned int NX, class Scalar>
+inline void rungeKuttaIncrement( Scalar* _sum, const Scalar (&_k)[Tableau::STAGES][NX], Scalar _h )
+{
+    if constexpr ( butcherCoefficient<Tableau>( I, J ) != 0.0 )
+    {
+        const Scalar weight = _h*Scalar( butcherCoefficient<Tableau>( I, J ) );
+        for ( unsigned int i=0; i<NX; i++ )
+            _sum[i] += weight*_k[J][i];
+    }
+}
+
+
+/** Evaluate stage I from the previous stages J = 0 ... I-1 (unused stages are skipped)
+ */
+template <class Tableau, unsigned int I, class Model, class Scalar, unsigned int... J>
+inline void rungeKuttaStage( const plantModel<Model>& model, Scalar _t, Scalar _h, const Scalar* _state, const Scalar* _u,
+                             Scalar (&_k)[Tableau::STAGES][Model::NX], std::integer_sequence<unsigned int, J...> )
+{
+    if constexpr ( butcherStageUsed<Tableau>( I ) )
+    {
+        Scalar tmp[Model::NX];
+        for ( unsigned int i=0; i<Model::NX; i++ )
+            tmp[i] = _state[i];
+
+        ( rungeKuttaIncrement<Tableau, I, J>( tmp, _k, _h ), ... );
+        model.rhs( _t + Scalar( Tableau::c[I] )*_h, tmp, _u, _k[I] );
+    }
+}
+
+
+/** All stages in order, then the weighted update of the state
+ */
+template <class Tableau, class Model, class Scalar, unsigned int... I>
+inline void rungeKuttaStages( const plantModel<Model>& model, Scalar _t, Scalar _h, Scalar* _state, const Scalar* _u,
+                              Scalar (&_k)[Tableau::STAGES][Model::NX], std::integer_sequence<unsigned int, I...> )
+{
+    ( rungeKuttaStage<Tableau, I>( model, _t, _h, _state, _u, _k, std::make_integer_sequence<unsigned int, I>() ), ... );
+    ( rungeKuttaIncrement<Tableau, Tableau::STAGES, I>( _state, _k, _h ), ... );
+}
+
+
+/** Advance the state of a plant model over one step with the explicit Runge-Kutta scheme of a
+ *  Butcher tableau, evaluated in the precision of Scalar. The stage loop is unrolled at compile
+ *  time: stage buffers are fixed-size, zero coefficients generate no code and stages that do not
+ *  contribute to the solution are not evaluated.
+ *
+ * @param[in] model         Plant model
+ * @param[in] _t            Time at start of step
+ * @param[in] _h            Step size
+ * @param[in,out] _state    State (Model::NX values)
+ * @param[in] _u            Control input, held over the step (Model::NU values)
+ */
+template <class Tableau, class Model, class Scalar>
+inline void explicitRungeKutta( const plantModel<Model>& model, Scalar _t, Scalar _h, Scalar* _state, const Scalar* _u )
+{
+    Scalar k[Tableau::STAGES][Model::NX];
+    rungeKuttaStages<Tableau>( model, _t, _h, _state, _u, k, std::make_integer_sequence<unsigned int, Tableau::STAGES>() );
+}
+
+
+/** Advance the state of a plant model over one step using classical Runge-Kutta 4,
+ *  evaluated in the precision of Scalar
+ *
+ * @param[in] model         Plant model
+ * @param[in] _t            Time at start of step
+ * @param[in] _h            Step size
+ * @param[in,out] _state    State (Model::NX values)
+ * @param[in] _u            Control input, held over the step (Model::NU values)
+ */
+template <class Model, class Scalar>
+inline void rungeKutta4( const plantModel<Model>& model, Scalar _t, Scalar _h, Scalar* _state, const Scalar* _u )
+{
+    explicitRungeKutta<classicalRungeKutta4>( model, _t, _h, _state, _u );
+}
@@ -0,0 +1,82 @@
+/**
+ *	\file include/journal.h
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#pragma once
+
+#include <Eigen/Dense>              // #include module
+#include <cstdint>
+#include <string>
+#include <vector>
+using namespace Eigen;              // using namespace of module
+
+class journal
+{
+    //
+	// PUBLIC MEMBER FUNCTIONS:
+	//
+    public:
+        /** Default constructor
+         */
+        journal(  );
+
+        /** Constructor which takes the journal file name. Campaign progress is
+         *  checkpointed next to it in <fileName>.chk
+         *
+         * @param[in] _fileName     Journal file to which results are appended
+         */
+        journal( std::string _fileName );
+
+        /** Destructor
+         */
+        virtual ~journal(  );
+
+
+        /** Load results of a previous (interrupted) campaign. Records written after the
+         *  last checkpoint are discarded from the journal so they are recomputed exactly.
+         *  The checkpoint records the identity of its campaign: resuming a different campaign
+         *  (other configuration, shard or metrics) throws, and the journal is left untouched.
+         *
+         * @param[in] _campaign     Configuration hash identifying the campaign
+         * @param[out] records      Completed records, one row per point (in campaign order)
+         * @param[out] rngState     Generator states stored with the last checkpoint
+         *
+         * \return Number of completed points
+         */
+        unsigned int resume( uint64_t _campaign, MatrixXf& records, std::vector<std::string>& rngState );
+
+        /** Durably append the result of the next point and checkpoint progress
+         *
+         * @param[in] record        Result record of the point
+         * @param[in] rngState      Generator states after the point
+         */
+        void append( const VectorXf& record, const std::vector<std::string>& rngState );
+
+
+        /** Returns if a journal file was configured
+         */
+        bool isActive(  ) const;
+
+
+    //
+	// PRIVATE MEMBER FUNCTIONS:
+	//
+    private:
+        /** Write checkpoint file atomically (write temporary file, then rename)
+         *
+         * @param[in] rngState      Generator states after the last completed point
+         */
+        void writeCheckpoint( const std::vector<std::string>& rngState );
+
+
+    //
+	// PRIVATE DATA MEMBER:
+	//
+        std::string fileName;           // Journal file name
+        std::string checkpointName;     // Checkpoint file name
+        unsigned int nRecords;          // Number of completed points
+        uint64_t campaign;              // Configuration hash of the campaign
+};
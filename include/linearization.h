@@ -0,0 +1,138 @@
+/**
+ *	\file include/linearization.h
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#pragma once
+
+#include <Eigen/Dense>              // #include module
+#include <complex>
+#include <memory>
+#include <string>
+#include <vector>
+using namespace Eigen;              // using namespace of module
+
+
+/** Linearized closed-loop analysis of a PID-controlled plant model (see plantModel) with a single
+ *  control input, used to pre-screen controller gains without nonlinear simulations.
+ *
+ *  At every operating point (time, state and input on the nominal trajectory) the model is
+ *  linearized by central differences. This gives the Jacobians of the equations of motion and
+ *  of one step of the selected integration scheme over one sampling time, which is the discrete
+ *  plant the controller actually sees in the simulation. Modes that do not reach the outputs (e.g. downrange position) are removed.
+ *  The loop is closed with the discrete PID law of scalarPIDcontroller, with the limits
+ *  inactive:
+ *
+ *      u_k = sum_i  Kp_i e_k,i + Ki_i I_k,i + Kd_i ( e_k,i - e_k-1,i )/h,    I_k = I_k-1 + h e_k
+ *
+ *  For each gain combination the analysis returns the closed-loop spectral radius (stable below
+ *  one), the gain and phase margin of the loop broken at the actuator, and the closed-loop
+ *  bandwidth. Each result is the worst case over the operating points. The frequency response
+ *  of the plant does not depend on the gains, so it is computed once per operating point and the
+ *  loop response of all gain combinations follows from one matrix product.
+ */
+template <class Model>
+class linearAnalysis
+{
+    //
+	// PUBLIC MEMBER FUNCTIONS:
+	//
+    public:
+        /** Constructor
+         *
+         * @param[in] _model            Plant model
+         * @param[in] _samplingTime     Sampling time of controller and plant
+         * @param[in] _integrator       Integration scheme of the plant (see plantDynamics::setIntegrator)
+         * @param[in] _nFrequencies     Number of frequencies (logarithmic, up to the Nyquist frequency)
+         */
+        linearAnalysis( std::shared_ptr<const Model> _model, double _samplingTime, const std::string& _integrator="rk4",
+                        unsigned int _nFrequencies=200 );
+
+        /** Destructor
+         */
+        ~linearAnalysis(  );
+
+
+        /** Linearize the model about an operating point and add it to the analysis
+         *
+         * @param[in] time              Time of the operating point
+         * @param[in] state             State (Model::NX values)
+         * @param[in] input             Control input (Model::NU values)
+         */
+        void addOperatingPoint( double time, const VectorXd& state, const VectorXd& input );
+
+        /** Returns number of operating points
+         */
+        unsigned int getNumOperatingPoints(  ) const;
+
+        /** Returns Jacobians of the equations of motion at an operating point:
+         *  d(state)/dt = A state + B u, y = C state
+         *
+         * @param[in] k                 Operating point
+         * @param[out] A                State Jacobian (NX x NX)
+         * @param[out] B                Input Jacobian (NX x NU)
+         * @param[out] C                Output Jacobian (NY x NX)
+         */
+        void getJacobians( unsigned int k, MatrixXd& A, MatrixXd& B, MatrixXd& C ) const;
+
+        /** Returns closed-loop system matrix at an operating point: the reduced plant state,
+         *  followed by the integrator states of outputs with an integral gain and the previous
+         *  errors of outputs with a derivative gain
+         *
+         * @param[in] k                 Operating point
+         * @param[in] gains             Proportional, integral and derivative gain of every output (3 NY values)
+         */
+        MatrixXd closedLoopMatrix( unsigned int k, const VectorXd& gains ) const;
+
+        /** Analyze gain combinations over all operating points
+         *
+         * @param[in] gains             One row per combination: proportional, integral and
+         *                              derivative gain of every output (3 NY columns)
+         *
+         * \return One row per combination: largest closed-loop spectral radius, smallest gain
+         *         margin [dB], smallest phase margin [deg] and smallest bandwidth [rad/s]
+         *         (infinite margins if the loop gain never crosses)
+         */
+        MatrixXf analyze( const MatrixXf& gains ) const;
+
+
+    //
+	// PRIVATE MEMBER FUNCTIONS:
+	//
+    private:
+        /** Gain and phase margin and bandwidth from the loop response of one combination
+         *
+         * @param[in] re                Real part of the loop response at every frequency
+         * @param[in] im                Imaginary part of the loop response at every frequency
+         * @param[out] gainMargin       Gain margin [dB]
+         * @param[out] phaseMargin      Phase margin [deg]
+         * @param[out] bandwidth        Closed-loop bandwidth [rad/s]
+         */
+        void margins( const double* re, const double* im, double& gainMargin, double& phaseMargin, double& bandwidth ) const;
+
+        /** Select the integration scheme of a Butcher tableau
+         */
+        template <class Tableau>
+        void useScheme(  );
+
+
+    //
+	// PRIVATE DATA MEMBER:
+	//
+        struct operatingPoint
+        {
+            double time;
+            MatrixXd A, B, C;           // Continuous Jacobians
+            MatrixXd Ad, Bd, Cd;        // Discrete plant, reduced to the observable modes
+            MatrixXcd response;         // Loop response per unit gain (3 NY x nFrequencies)
+        };
+
+        std::shared_ptr<const Model> model;     // Plant model
+        double samplingTime;                    // Sampling time
+        VectorXd frequencies;                   // Frequencies of the loop response [rad/s]
+        std::vector<operatingPoint> points;     // Operating points
+
+        void (*stepper)( const plantModel<Model>&, double, double, double*, const double* );    // Selected scheme
+};
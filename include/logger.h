@@ -0,0 +1,128 @@
+/**
+ *	\file include/logger.h
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+
+
+/** Asynchronous logger for the simulation campaigns. Records are only captured when their
+ *  level is enabled, and they are formatted later by a background thread. Each thread
+ *  appends to its own lock-free ring buffer. The background thread drains the buffers,
+ *  orders the records by time and writes them to the console. Warnings and errors go to
+ *  std::cerr, everything else to std::cout. When a buffer is full, debug and info records
+ *  are dropped and counted instead of blocking the simulation; warnings and errors wait
+ *  until the buffer has been drained.
+ *
+ *  Progress of long campaigns is aggregated with progressCounter and reported at most
+ *  once per progress interval, e.g. "Robustness map: 412/441 done, 35 runs/s, ETA 1 s".
+ */
+class logger
+{
+    //
+	// PUBLIC MEMBER FUNCTIONS:
+	//
+    public:
+        enum level { DEBUG = 0, INFO = 1, WARNING = 2, ERROR = 3, OFF = 4 };
+
+        /** Set the lowest level that is logged (default INFO)
+         *
+         * @param[in] lowest        Lowest logged level
+         */
+        static void setLevel( level lowest );
+
+        /** Returns whether records of a level are logged
+         */
+        static bool enabled( level lvl );
+
+        /** Set the shortest time between two progress reports of one counter (default 1 s)
+         *
+         * @param[in] seconds       Progress interval [s]
+         */
+        static void setProgressInterval( float seconds );
+
+        /** Log a record. The arguments are copied and only written to the console (with
+         *  operator<<) by the background thread.
+         *
+         * @param[in] lvl           Level of the record
+         * @param[in] args          Parts of the message
+         */
+        template <class... Args>
+        static void log( level lvl, const Args&... args );
+
+        template <class... Args>
+        static void debug( const Args&... args );
+
+        template <class... Args>
+        static void info( const Args&... args );
+
+        template <class... Args>
+        static void warning( const Args&... args );
+
+        template <class... Args>
+        static void error( const Args&... args );
+
+        /** Block until every record logged so far has been written
+         */
+        static void flush(  );
+
+
+    //
+	// PRIVATE MEMBER FUNCTIONS:
+	//
+    private:
+        /** Append a record to the buffer of the calling thread
+         */
+        static void append( level lvl, std::function<void( std::ostream& )>&& format );
+
+        static std::atomic<int> lowestLevel;    // Lowest logged level
+};
+
+
+/** Progress of a campaign with a known (or unknown, total = 0) number of runs. advance is
+ *  a single atomic increment; the logger's background thread reports the progress. The
+ *  final count, run time and rate are reported when the counter is destroyed.
+ */
+class progressCounter
+{
+    //
+	// PUBLIC MEMBER FUNCTIONS:
+	//
+    public:
+        /** Constructor
+         *
+         * @param[in] task          Name of the campaign
+         * @param[in] total         Number of runs (0 if unknown)
+         */
+        progressCounter( const std::string& task, unsigned int total );
+
+        /** Destructor (reports the final count)
+         */
+        ~progressCounter(  );
+
+        progressCounter( const progressCounter& ) = delete;
+        progressCounter& operator=( const progressCounter& ) = delete;
+
+        /** Count completed runs
+         *
+         * @param[in] n             Number of runs completed
+         */
+        void advance( unsigned int n=1 );
+
+        struct state;
+
+
+    //
+	// PRIVATE DATA MEMBER:
+	//
+    private:
+        std::shared_ptr<state> progress;        // Shared with the logger's background thread
+};
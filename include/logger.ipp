@@ -0,0 +1,47 @@
+/**
+ *	\file include/logger.ipp
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#include "../header.h"    // #include header
+
+
+template <class... Args>
+void logger::log( level lvl, const Args&... args )
+{
+    if ( !enabled( lvl ) )
+        return;
+
+    // Copies of the arguments, formatted by the background thread
+    append( lvl, [=]( std::ostream& stream ) { ( stream << ... << args ); } );
+}
+
+
+template <class... Args>
+void logger::debug( const Args&... args )
+{
+    log( DEBUG, args... );
+}
+
+
+template <class... Args>
+void logger::info( const Args&... args )
+{
+    log( INFO, args... );
+}
+
+
+template <class... Args>
+void logger::warning( const Args&... args )
+{
+    log( WARNING, args... );
+}
+
+
+template <class... Args>
+void logger::error( const Args&... args )
+{
+    log( ERROR, args... );
+}
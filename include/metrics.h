@@ -0,0 +1,264 @@
+/**
+ *	\file include/metrics.h
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#pragma once
+
+#include <Eigen/Dense>              // #include module
+#include <memory>
+#include <string>
+#include <vector>
+using namespace Eigen;              // using namespace of module
+
+
+/** Closed-loop signals of one simulation step, as seen by the metric reducers
+ */
+struct metricSample
+{
+    float time;                     // Time at end of step
+    float dt;                       // Step length (zero for the initial sample)
+    const VectorXf& y;              // Output at end of step
+    const VectorXf& u;              // Control input applied over the step
+    const VectorXf& error;          // Tracking error (reference - output) at start of step
+    float omega;                    // Stepper motor rotational speed over the step
+    bool saturated;                 // Control input was limited over the step
+};
+
+
+/** Streaming reducer of a closed-loop run to a single figure of merit. Reducers are
+ *  updated every step of the simulation loop, so no trajectory has to be stored.
+ */
+class metricReducer
+{
+    //
+	// PUBLIC MEMBER FUNCTIONS:
+	//
+    public:
+        /** Destructor
+         */
+        virtual ~metricReducer(  ) {}
+
+        /** Reset to the start of a run
+         */
+        virtual void reset(  ) = 0;
+
+        /** Update with the signals of the next step
+         *
+         * @param[in] sample        Signals of the step
+         */
+        virtual void update( const metricSample& sample ) = 0;
+
+        /** Returns value of the metric over the steps seen since reset
+         */
+        virtual float value(  ) const = 0;
+
+        /** Returns copy of the reducer (including its current value)
+         */
+        virtual metricReducer* clone(  ) const = 0;
+
+        /** Add parameters of the reducer to hash identifying a simulation run (reducers
+         *  with parameters, e.g. a target value, must override this)
+         *
+         * @param[in,out] hash      Configuration hash
+         */
+        virtual void hashConfiguration( configHash& hash ) const {}
+};
+
+
+/** Apogee: maximum of the measured altitude (output 0)
+ */
+class apogeeMetric : public metricReducer
+{
+    public:
+        void reset(  ) { apogee = -INFINITY; time = 0.0; }
+        void update( const metricSample& sample ) { if ( sample.y(0) > apogee ) { apogee = sample.y(0); time = sample.time; } }
+        float value(  ) const { return apogee; }
+        float timeOfApogee(  ) const { return time; }
+        metricReducer* clone(  ) const { return new apogeeMetric( *this ); }
+
+    private:
+        float apogee = -INFINITY;       // Highest altitude so far
+        float time = 0.0;               // Time of highest altitude (first occurrence)
+};
+
+
+/** Time of apogee
+ */
+class apogeeTimeMetric : public apogeeMetric
+{
+    public:
+        float value(  ) const { return timeOfApogee(); }
+        metricReducer* clone(  ) const { return new apogeeTimeMetric( *this ); }
+};
+
+
+/** Deviation from a target apogee (target - apogee)
+ */
+class apogeeDeviationMetric : public apogeeMetric
+{
+    public:
+        apogeeDeviationMetric( float _target=3500.0 ) : target( _target ) {}
+        float value(  ) const { return target - apogeeMetric::value(); }
+        metricReducer* clone(  ) const { return new apogeeDeviationMetric( *this ); }
+        void hashConfiguration( configHash& hash ) const { hash.add( target ); }
+
+    private:
+        float target;                   // Target apogee
+};
+
+
+/** Peak absolute stepper motor speed
+ */
+class peakOmegaMetric : public metricReducer
+{
+    public:
+        void reset(  ) { peak = 0.0; }
+        void update( const metricSample& sample ) { if ( sample.dt > 0.0f ) peak = std::max( peak, std::abs( sample.omega ) ); }
+        float value(  ) const { return peak; }
+        metricReducer* clone(  ) const { return new peakOmegaMetric( *this ); }
+
+    private:
+        float peak = 0.0;               // Peak absolute speed so far
+};
+
+
+/** Total actuator travel: sum of absolute changes of all control inputs
+ */
+class actuatorTravelMetric : public metricReducer
+{
+    public:
+        void reset(  );
+        void update( const metricSample& sample );
+        float value(  ) const { return travel; }
+        metricReducer* clone(  ) const { return new actuatorTravelMetric( *this ); }
+
+    private:
+        float travel = 0.0;             // Travel so far
+        VectorXf lastU;                 // Previous control input (empty before the first step)
+};
+
+
+/** Time during which the control input was limited by the saturator
+ */
+class saturationTimeMetric : public metricReducer
+{
+    public:
+        void reset(  ) { time = 0.0; }
+        void update( const metricSample& sample ) { if ( sample.saturated ) time += sample.dt; }
+        float value(  ) const { return time; }
+        metricReducer* clone(  ) const { return new saturationTimeMetric( *this ); }
+
+    private:
+        float time = 0.0;               // Saturated time so far
+};
+
+
+/** Root mean square (over time) of the tracking error of one output component
+ */
+class rmsTrackingErrorMetric : public metricReducer
+{
+    public:
+        rmsTrackingErrorMetric( unsigned int _idx=0 ) : idx( _idx ) {}
+        void reset(  ) { sum = 0.0; duration = 0.0; }
+        void update( const metricSample& sample );
+        float value(  ) const { return ( duration > 0.0 ) ? sqrt( sum/duration ) : 0.0; }
+        metricReducer* clone(  ) const { return new rmsTrackingErrorMetric( *this ); }
+        void hashConfiguration( configHash& hash ) const { hash.add( idx ); }
+
+    private:
+        unsigned int idx;               // Output component
+        double sum = 0.0;               // Integral of squared error
+        double duration = 0.0;          // Integration time
+};
+
+
+/** Composable set of metric reducers, evaluated together on each step of a run
+ */
+class metricSet
+{
+    //
+	// PUBLIC MEMBER FUNCTIONS:
+	//
+    public:
+        /** Default constructor (empty set)
+         */
+        metricSet(  );
+
+        /** Constructor which takes the names of built-in metrics (see add)
+         *
+         * @param[in] _names        Metric names
+         */
+        metricSet( const std::vector<std::string>& _names );
+
+        /** Copy constructor (reducers are cloned)
+		 *
+		 *	@param[in] rhs	Right-hand side object.
+		 */
+        metricSet( const metricSet& rhs );
+
+        /** Assignment operator (reducers are cloned)
+		 *
+		 *	@param[in] rhs	Right-hand side object.
+		 */
+        metricSet& operator=( const metricSet& rhs );
+
+        /** Destructor
+         */
+        ~metricSet(  );
+
+
+        /** Add built-in metric by name: apogee, apogeeTime, apogeeDeviation, peakOmega,
+         *  actuatorTravel, saturationTime, rmsAltitudeError, rmsVelocityError
+         *
+         * @param[in] name          Metric name
+         */
+        void add( const std::string& name );
+
+        /** Add user-defined metric
+         *
+         * @param[in] name          Metric name
+         * @param[in] reducer       Reducer, owned by the set
+         */
+        void add( const std::string& name, metricReducer* reducer );
+
+        /** Reset all metrics to the start of a run
+         */
+        void reset(  );
+
+        /** Update all metrics with the signals of the next step
+         *
+         * @param[in] sample        Signals of the step
+         */
+        void update( const metricSample& sample );
+
+        /** Returns values of all metrics
+         *
+         * @param[out] values       Metric values, in order of adding
+         */
+        void getValues( VectorXf& values ) const;
+
+        /** Returns names of all metrics
+         */
+        const std::vector<std::string>& getNames(  ) const;
+
+        /** Returns number of metrics
+         */
+        unsigned int size(  ) const;
+
+        /** Add metric names and reducer parameters to hash identifying a simulation run
+         *
+         * @param[in,out] hash      Configuration hash
+         */
+        void hashConfiguration( configHash& hash ) const;
+
+
+    //
+	// PRIVATE DATA MEMBER:
+	//
+    private:
+        std::vector<std::string> names;                             // Metric names
+        std::vector<std::unique_ptr<metricReducer> > reducers;      // Metric reducers
+};
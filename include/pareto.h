@@ -0,0 +1,134 @@
+/**
+ *	\file include/pareto.h
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#pragma once
+
+#include <Eigen/Dense>              // #include module
+#include <random>
+#include <vector>
+using namespace Eigen;              // using namespace of module
+
+
+/** Multi-objective optimizer after NSGA-II (Deb et al., 2002), used through an ask/tell
+ *  interface so that the caller evaluates each generation (e.g. in parallel):
+ *
+ *      paretoOptimizer optimizer( lower, upper, 64, seed );
+ *      for ( generation ... )
+ *      {
+ *          const MatrixXf& candidates = optimizer.getCandidates();    // one row per candidate
+ *          ... evaluate objectives (minimized) and constraint violations ...
+ *          optimizer.update( objectives, violations );
+ *      }
+ *      optimizer.getFront( variables, objectives );
+ *
+ *  Candidates are ranked by constrained domination: a feasible candidate (violation 0)
+ *  dominates an infeasible one, and of two infeasible candidates the smaller violation
+ *  dominates. The next population is filled front by front, and the last front is truncated
+ *  by crowding distance. Offspring are created by binary tournaments, simulated binary
+ *  crossover and polynomial mutation within the bounds. The initial population is a Latin
+ *  hypercube. Every feasible, non-dominated candidate evaluated so far is kept in an archive,
+ *  which is thinned by crowding distance when it exceeds its capacity.
+ */
+class paretoOptimizer
+{
+    //
+	// PUBLIC MEMBER FUNCTIONS:
+	//
+    public:
+        /** Constructor
+         *
+         * @param[in] _lower            Lower bound of every variable
+         * @param[in] _upper            Upper bound of every variable
+         * @param[in] _populationSize   Population size (even, at least 4)
+         * @param[in] seed              Seed of the random number generator
+         * @param[in] _archiveSize      Capacity of the archive of non-dominated solutions
+         */
+        paretoOptimizer( const VectorXf& _lower, const VectorXf& _upper, unsigned int _populationSize,
+                         unsigned int seed=0, unsigned int _archiveSize=1000 );
+
+        /** Destructor
+         */
+        ~paretoOptimizer(  );
+
+
+        /** Returns candidates to be evaluated, one row per candidate
+         */
+        const MatrixXf& getCandidates(  ) const;
+
+        /** Report the evaluation of the candidates, select the next population and create
+         *  the next candidates
+         *
+         * @param[in] objectives        Objectives of every candidate (minimized), one row per candidate
+         * @param[in] violations        Constraint violation of every candidate (0: feasible)
+         */
+        void update( const MatrixXf& objectives, const VectorXf& violations );
+
+        /** Returns archive of feasible non-dominated solutions
+         *
+         * @param[out] variables        Variables, one row per solution
+         * @param[out] objectives       Objectives, one row per solution
+         */
+        void getFront( MatrixXf& variables, MatrixXf& objectives ) const;
+
+        /** Returns number of completed generations
+         */
+        unsigned int getGeneration(  ) const;
+
+
+    //
+	// PRIVATE MEMBER FUNCTIONS:
+	//
+    private:
+        /** Constrained domination of candidate a over candidate b
+         */
+        static bool dominates( const float* fa, float va, const float* fb, float vb, unsigned int nObjectives );
+
+        /** Sort candidates into fronts of equal rank (fast non-dominated sort)
+         */
+        static std::vector<std::vector<unsigned int> > sortFronts( const MatrixXf& objectives, const VectorXf& violations );
+
+        /** Crowding distance of the members of one front
+         */
+        static VectorXf crowding( const MatrixXf& objectives, const std::vector<unsigned int>& front );
+
+        /** Add feasible, non-dominated candidates to the archive
+         */
+        void updateArchive( const MatrixXf& objectives, const VectorXf& violations );
+
+        /** Create the next candidates from the population
+         */
+        void createOffspring(  );
+
+        /** Returns index of the winner of a binary tournament in the population
+         */
+        unsigned int tournament(  );
+
+
+    //
+	// PRIVATE DATA MEMBER:
+	//
+        VectorXf lower;                 // Variable bounds
+        VectorXf upper;
+        unsigned int populationSize;
+        unsigned int archiveSize;
+        unsigned int generation = 0;
+
+        std::mt19937 generator;         // Random numbers of selection and variation
+
+        MatrixXf candidates;            // Candidates to be evaluated (variables)
+        MatrixXf population;            // Current population: variables, objectives,
+        MatrixXf populationObjectives;  // constraint violation, rank and crowding distance
+        VectorXf populationViolations;
+        VectorXi populationRank;
+        VectorXf populationCrowding;
+
+        MatrixXf archiveVariables;      // Feasible non-dominated solutions
+        MatrixXf archiveObjectives;
+
+        float crossoverIndex = 15.0;    // Distribution index of simulated binary crossover
+        float mutationIndex = 20.0;     // Distribution index of polynomial mutation
+};
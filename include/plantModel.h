@@ -0,0 +1,56 @@
+/**
+ *	\file include/plantModel.h
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#pragma once
+
+/** Static (CRTP) interface of a plant model. A model derives from plantModel<Model> and supplies
+ *
+ *      static constexpr unsigned int NX, NU, NY;                     state, input and output dimension
+ *      template <class Scalar>
+ *      void derivative( Scalar t, const Scalar* state,
+ *                       const Scalar* u, Scalar* stateDerivative ) const;  rhs of equations of motion
+ *      template <class Scalar>
+ *      void output( const Scalar* state, Scalar* y ) const;        output map
+ *      void setParameter( const std::string& name, double value );
+ *      double getParameter( const std::string& name ) const;
+ *      void hashConfiguration( configHash& hash ) const;
+ *
+ *  The integrator, dynamics and simulator are templated on the model, so derivative evaluations
+ *  are resolved at compile time and can be inlined into the integration loop. The equations are
+ *  templated on the scalar type and evaluated entirely in that precision (float or double).
+ */
+template <class Model>
+class plantModel
+{
+    //
+	// PUBLIC MEMBER FUNCTIONS:
+	//
+    public:
+        /** Calculate state derivatives of the model
+         *
+         * @param[in] _t                Current time
+         * @param[in] _state            Current state (NX values)
+         * @param[in] _u                Control input (NU values)
+         * @param[out] _stateDerivative State derivatives (NX values)
+         */
+        template <class Scalar>
+        inline void rhs( Scalar _t, const Scalar* _state, const Scalar* _u, Scalar* _stateDerivative ) const
+        {
+            static_cast<const Model*>( this )->derivative( _t, _state, _u, _stateDerivative );
+        }
+
+        /** Calculate output of the model (noise-free)
+         *
+         * @param[in] _state            Current state (NX values)
+         * @param[out] _y               Output (NY values)
+         */
+        template <class Scalar>
+        inline void outputMap( const Scalar* _state, Scalar* _y ) const
+        {
+            static_cast<const Model*>( this )->output( _state, _y );
+        }
+};
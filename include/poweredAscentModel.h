@@ -0,0 +1,101 @@
+/**
+ *	\file include/poweredAscentModel.h
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#pragma once
+
+#include <string>
+
+/** Variable-mass 2-D point-mass rocket during powered ascent and coast. Constant thrust
+ *  along the velocity vector (gravity turn) until burn-out, mass flow T/(Isp*g), drag
+ *  from the same Cd surface fit as rocketModel.
+ */
+class poweredAscentModel : public plantModel<poweredAscentModel>
+{
+    //
+	// PUBLIC MEMBER FUNCTIONS:
+	//
+    public:
+        static constexpr unsigned int NX = 5;   // Number of states (x, y, Vx, Vy, m)
+        static constexpr unsigned int NU = 1;   // Number of inputs (airbrake extension)
+        static constexpr unsigned int NY = 2;   // Number of outputs (altitude, vertical velocity)
+
+        /** Default constructor
+         */
+        poweredAscentModel(  );
+
+        /** Destructor
+         */
+        ~poweredAscentModel(  );
+
+
+        /** Calculate state derivatives (rhs of equations of motion)
+         *
+         * @param[in] _t                Current time (since ignition)
+         * @param[in] _state            Current state (NX values)
+         * @param[in] _u                Control input (NU values)
+         * @param[out] _stateDerivative State derivatives (NX values)
+         */
+        template <class Scalar>
+        inline void derivative( Scalar _t, const Scalar* _state, const Scalar* _u, Scalar* _stateDerivative ) const;
+
+        /** Calculate output (altitude, vertical velocity)
+         *
+         * @param[in] _state            Current state (NX values)
+         * @param[out] _y               Output (NY values)
+         */
+        template <class Scalar>
+        inline void output( const Scalar* _state, Scalar* _y ) const;
+
+
+        /** Set model parameter by name
+         *
+         * @param[in] name              Parameter name (p00 ... p03, g, density_sea, A, dryMass,
+         *                              thrust, burnTime, Isp, launchAngle)
+         * @param[in] value             New value
+         */
+        void setParameter( const std::string& name, double value );
+
+        /** Returns model parameter by name
+         *
+         * @param[in] name              Parameter name (see setParameter)
+         */
+        double getParameter( const std::string& name ) const;
+
+
+        /** Add model to hash identifying a simulation run
+         *
+         * @param[in,out] hash          Configuration hash
+         */
+        void hashConfiguration( configHash& hash ) const;
+
+
+    //
+	// PRIVATE DATA MEMBER:
+	//
+    private:
+        double p00 = 0.4165;			// Cd surface fit (see rocketModel)
+        double p10 = 8.886;
+        double p01 = 0.3778;
+        double p20 = 43.25;
+        double p11 = -10.48;
+        double p02 = -0.9093;
+        double p21 = 21.67;
+        double p12 = 22.7;
+        double p03 = 0.5587;
+
+        double g = 9.81;                // Gravitational constant
+        double density_sea = 1.225;     // Sea-level density
+        double A = 0.0191;              // Cross-sectional area
+        double dryMass = 20.1;          // Mass at burn-out
+
+        double thrust = 4000.0;         // Average motor thrust
+        double burnTime = 5.5;          // Burn time
+        double Isp = 200.0;             // Specific impulse
+        double launchAngle = 1.41;      // Launch rail angle from horizontal (thrust direction at rest)
+
+        std::string modelVersion = "powered-ascent-2d-v1.0";   // Model version tag (change when equations change)
+};
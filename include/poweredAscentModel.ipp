@@ -0,0 +1,43 @@
+/**
+ *	\file include/poweredAscentModel.ipp
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#include "../header.h"    // #include header
+
+
+template <class Scalar>
+inline void poweredAscentModel::derivative( Scalar _t, const Scalar* _state, const Scalar* _u, Scalar* _stateDerivative ) const
+{
+    Scalar xbr = _u[0];
+    Scalar m = _state[4];
+
+    Scalar density = Scalar( density_sea ) * std::exp( -_state[1] / Scalar( 8000 ) );
+    Scalar V = std::sqrt( _state[2]*_state[2] + _state[3]*_state[3] );
+    Scalar M = V / Scalar( sqrt( 1.4*287*278 ) );
+    Scalar Cd_val = Scalar( p00 ) + Scalar( p10 )*xbr + Scalar( p01 )*M + Scalar( p20 )*xbr*xbr + Scalar( p11 )*M*xbr
+                  + Scalar( p02 )*M*M + Scalar( p21 )*xbr*xbr*M + Scalar( p12 )*xbr*M*M + Scalar( p03 )*M*M*M;
+
+    // Thrust along velocity vector (along launch rail at rest) until burn-out
+    Scalar T = ( _t < Scalar( burnTime ) && m > Scalar( dryMass ) ) ? Scalar( thrust ) : Scalar( 0 );
+    Scalar ex = ( V > Scalar( 1e-3 ) ) ? _state[2]/V : Scalar( cos( launchAngle ) );
+    Scalar ey = ( V > Scalar( 1e-3 ) ) ? _state[3]/V : Scalar( sin( launchAngle ) );
+
+    Scalar drag = Scalar( 0.5 ) * density * Scalar( A ) * Cd_val * V;
+
+    _stateDerivative[0] = _state[2];                                        // x_dot = Vx
+    _stateDerivative[1] = _state[3];                                        // y_dot = Vy
+    _stateDerivative[2] = ( T*ex - drag * _state[2] ) / m;                  // Vx_dot
+    _stateDerivative[3] = - Scalar( g ) + ( T*ey - drag * _state[3] ) / m;  // Vy_dot
+    _stateDerivative[4] = -T / Scalar( Isp*g );                             // m_dot
+}
+
+
+template <class Scalar>
+inline void poweredAscentModel::output( const Scalar* _state, Scalar* _y ) const
+{
+    _y[0] = _state[1];
+    _y[1] = _state[3];
+}
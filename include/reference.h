@@ -0,0 +1,115 @@
+/**
+ *	\file include/reference.h
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#pragma once
+
+#include <Eigen/Dense>              // #include module
+using namespace Eigen;              // using namespace of module
+
+class referenceTrajectory
+{
+    //
+	// PUBLIC MEMBER FUNCTIONS:
+	//
+    public:
+        /** Type of representation used for the reference signals
+         */
+        enum representation { NONE, MONOMIAL, CHEBYSHEV, SPLINE };
+
+        /** Default constructor (empty reference, evaluates to zero)
+         */
+        referenceTrajectory(  );
+
+        /** Destructor
+         */
+        virtual ~referenceTrajectory(  );
+
+
+        /** Set reference from monomial coefficients (as returned by polyfit)
+         *
+         * @param[in] _coeff        Matrix containing nth order polynomial coefficients, one row per signal
+         *                          p = p_1*t^n + p_2*t^(n-1) + ... + p_n*t + p_{n+1}
+         */
+        void setMonomial( const MatrixXf& _coeff );
+
+        /** Least-squares fit of a Chebyshev series on the normalized data interval using QR
+         *
+         * @param[in] _t            Sample times (strictly increasing)
+         * @param[in] _data         Sampled signals, one row per signal, one column per sample time
+         * @param[in] _order        Order of the Chebyshev series
+         */
+        void fitChebyshev( const VectorXf& _t, const MatrixXf& _data, unsigned int _order );
+
+        /** Fit a natural cubic spline through the data on uniformly spaced knots
+         *
+         * @param[in] _t            Sample times (strictly increasing)
+         * @param[in] _data         Sampled signals, one row per signal, one column per sample time
+         * @param[in] _nSegments    Number of spline segments
+         */
+        void fitSpline( const VectorXf& _t, const MatrixXf& _data, unsigned int _nSegments );
+
+
+        /** Evaluate all reference signals at a given time (in double, rounded to Scalar)
+         *
+         * @param[in] _t            Evaluation time
+         * @param[out] _y           Reference signals
+         */
+        template <class Scalar>
+        void evaluate( double _t, VectorX<Scalar>& _y ) const;
+
+        /** Largest absolute deviation between the reference and sampled data
+         *
+         * @param[in] _t            Sample times
+         * @param[in] _data         Sampled signals, one row per signal
+         *
+         * \return Maximum absolute fit error per signal
+         */
+        VectorXf maxError( const VectorXf& _t, const MatrixXf& _data ) const;
+
+
+        /** Returns number of reference signals
+         */
+        unsigned int getNumSignals(  ) const;
+
+        /** Returns type of representation
+         */
+        representation getType(  ) const;
+
+        /** Returns coefficients of the representation (layout depends on type)
+         */
+        const MatrixXd& getCoefficients(  ) const;
+
+        /** Returns interval [t0, t1] on which the reference was fitted
+         */
+        double getStartTime(  ) const;
+        double getEndTime(  ) const;
+
+
+        /** Add configuration to hash identifying a simulation run
+         * 
+         * @param[in,out] hash          Configuration hash
+         */
+        void hashConfiguration( configHash& hash ) const;
+
+
+    //
+	// PRIVATE DATA MEMBER:
+	//
+    private:
+        representation type;            // Type of representation
+        unsigned int nSignals;          // Number of reference signals
+
+        double t0;                      // Start of fitted interval
+        double t1;                      // End of fitted interval
+
+        unsigned int nSegments;         // Number of spline segments
+        double h;                       // Spline knot spacing
+
+        MatrixXd coeff;                 // MONOMIAL:  (nSignals x n+1), highest power first
+                                        // CHEBYSHEV: (nSignals x n+1), c_0 ... c_n
+                                        // SPLINE:    (nSignals x 4*nSegments), d c b a per segment (Horner order)
+};
@@ -0,0 +1,162 @@
+/**
+ *	\file include/resultStore.h
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#pragma once
+
+#include <Eigen/Dense>              // #include module
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+using namespace Eigen;              // using namespace of module
+
+
+/** Range condition of a query: lower <= column <= upper
+ */
+struct rangeCondition
+{
+    std::string column;             // Column name
+    float lower;                    // Lower bound (-INFINITY: unbounded)
+    float upper;                    // Upper bound (INFINITY: unbounded)
+};
+
+
+/** Chunked binary store of campaign results: one row per run, one column per input
+ *  parameter or KPI. Rows are written in chunks, each compressed separately and
+ *  described by the min/max of every column in an index at the end of the file.
+ *  Readers memory-map the file and only decompress chunks that can satisfy a query.
+ *
+ *  Layout (little endian): header (magic, columns, chunk size), compressed chunks,
+ *  index (offset, size, rows, min, max per chunk), trailer (index offset, chunk count, magic).
+ */
+class resultStore
+{
+    //
+	// PUBLIC MEMBER FUNCTIONS:
+	//
+    public:
+        /** Default constructor
+         */
+        resultStore(  );
+
+        /** Destructor (finishes a store being written)
+         */
+        ~resultStore(  );
+
+        resultStore( const resultStore& ) = delete;
+        resultStore& operator=( const resultStore& ) = delete;
+
+
+        /** Create a new store for writing
+         *
+         * @param[in] fileName      Store file
+         * @param[in] _columns      Column names
+         * @param[in] _chunkRows    Number of rows per chunk
+         */
+        void create( const std::string& fileName, const std::vector<std::string>& _columns, unsigned int _chunkRows=4096 );
+
+        /** Append one row
+         *
+         * @param[in] row           Values of all columns
+         */
+        void append( const VectorXf& row );
+
+        /** Append rows
+         *
+         * @param[in] rows          One row per run, values of all columns
+         */
+        void append( const MatrixXf& rows );
+
+        /** Open an existing store for reading (memory-mapped)
+         *
+         * @param[in] fileName      Store file
+         */
+        void open( const std::string& fileName );
+
+        /** Finish writing (last chunk and index) or release a store opened for reading
+         */
+        void close(  );
+
+
+        /** Returns column names
+         */
+        const std::vector<std::string>& getColumns(  ) const;
+
+        /** Returns index of a column
+         *
+         * @param[in] name          Column name
+         */
+        unsigned int columnIndex( const std::string& name ) const;
+
+        /** Returns number of rows
+         */
+        uint64_t getNumRows(  ) const;
+
+        /** Returns number of chunks
+         */
+        unsigned int getNumChunks(  ) const;
+
+        /** Returns range of the columns in a chunk (from the index, no decompression)
+         *
+         * @param[in] chunk         Chunk index
+         * @param[out] min          Minimum of each column
+         * @param[out] max          Maximum of each column
+         */
+        void getChunkRange( unsigned int chunk, VectorXf& min, VectorXf& max ) const;
+
+        /** Decompress the rows of a chunk
+         *
+         * @param[in] chunk         Chunk index
+         * @param[out] rows         Rows of the chunk
+         */
+        void readChunk( unsigned int chunk, MatrixXf& rows ) const;
+
+        /** Select all rows satisfying every condition. Chunks whose index range does not
+         *  overlap a condition are skipped without decompression.
+         *
+         * @param[in] conditions    Range conditions
+         * @param[out] rows         Matching rows
+         *
+         * \return Number of chunks that were decompressed
+         */
+        unsigned int query( const std::vector<rangeCondition>& conditions, MatrixXf& rows ) const;
+
+
+    //
+	// PRIVATE MEMBER FUNCTIONS:
+	//
+    private:
+        /** Compress and write the buffered rows as one chunk
+         */
+        void flushChunk(  );
+
+
+    //
+	// PRIVATE DATA MEMBER:
+	//
+        struct chunkInfo
+        {
+            uint64_t offset;            // File offset of compressed chunk
+            uint32_t size;              // Compressed size in bytes
+            uint32_t rows;              // Number of rows
+            VectorXf min;               // Minimum of each column
+            VectorXf max;               // Maximum of each column
+        };
+
+        std::vector<std::string> columns;   // Column names
+        unsigned int chunkRows;             // Rows per chunk
+        std::vector<chunkInfo> chunks;      // Chunk index
+        uint64_t nRows;                     // Number of rows
+
+        std::ofstream output;               // Writer: store file
+        MatrixXf buffer;                    // Writer: rows of the chunk being filled
+        unsigned int nBuffered;             // Writer: number of buffered rows
+
+        const unsigned char* mapped;        // Reader: mapped file
+        size_t mappedSize;                  // Reader: size of mapped file
+        std::vector<unsigned char> fileData;    // Reader: file contents (where mmap is not available)
+};
@@ -0,0 +1,92 @@
+/**
+ *	\file include/rocketModel.h
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#pragma once
+
+#include <string>
+
+class rocketModel : public plantModel<rocketModel>
+{
+    //
+	// PUBLIC MEMBER FUNCTIONS:
+	//
+    public:
+        static constexpr unsigned int NX = 4;   // Number of states (x, y, Vx, Vy)
+        static constexpr unsigned int NU = 1;   // Number of inputs (airbrake extension)
+        static constexpr unsigned int NY = 2;   // Number of outputs (altitude, vertical velocity)
+
+        /** Default constructor (pre-flight fit of the model parameters)
+         */
+        rocketModel(  );
+
+        /** Destructor
+         */
+        ~rocketModel(  );
+
+
+        /** Calculate state derivatives (rhs of equations of motion). Does not modify
+         *  the model, so one model can be shared by any number of concurrent runs.
+         *
+         * @param[in] _t                Current time
+         * @param[in] _state            Current state (NX values)
+         * @param[in] _u                Control input (NU values)
+         * @param[out] _stateDerivative State derivatives (NX values)
+         */
+        template <class Scalar>
+        inline void derivative( Scalar _t, const Scalar* _state, const Scalar* _u, Scalar* _stateDerivative ) const;
+
+        /** Calculate output (altitude, vertical velocity)
+         *
+         * @param[in] _state            Current state (NX values)
+         * @param[out] _y               Output (NY values)
+         */
+        template <class Scalar>
+        inline void output( const Scalar* _state, Scalar* _y ) const;
+
+
+        /** Set model parameter by name
+         *
+         * @param[in] name              Parameter name (p00 ... p03, g, density_sea, A, mass)
+         * @param[in] value             New value
+         */
+        void setParameter( const std::string& name, double value );
+
+        /** Returns model parameter by name
+         *
+         * @param[in] name              Parameter name (p00 ... p03, g, density_sea, A, mass)
+         */
+        double getParameter( const std::string& name ) const;
+
+
+        /** Add model to hash identifying a simulation run
+         *
+         * @param[in,out] hash          Configuration hash
+         */
+        void hashConfiguration( configHash& hash ) const;
+
+
+    //
+	// PRIVATE DATA MEMBER:
+	//
+    private:
+        double p00 = 0.4165;			// Cd surface fit power coefficient
+        double p10 = 8.886;				// Cd = p00       + p10 * x     + p01 * y     + p20 * x^2 + p11 * x*y
+        double p01 = 0.3778;			//      p02 * y^2 + p21 * x^2*y + p12 * x*y^2 + p03 * y^3
+        double p20 = 43.25;				// with x: airbrake extension, y: mach number
+        double p11 = -10.48;
+        double p02 = -0.9093;
+        double p21 = 21.67;
+        double p12 = 22.7;
+        double p03 = 0.5587;
+
+        double g = 9.81;                // Gravitational constant
+        double density_sea = 1.225;     // Sea-level density
+        double A = 0.0191;              // Cross-sectional area
+        double mass = 20.1;             // Mass at burn-out
+
+        std::string modelVersion = "rocket-2d-v4.1";    // Model version tag (change when equations change)
+};
@@ -0,0 +1,34 @@
+/**
+ *	\file include/rocketModel.ipp
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#include "../header.h"    // #include header
+
+
+template <class Scalar>
+inline void rocketModel::derivative( Scalar _t, const Scalar* _state, const Scalar* _u, Scalar* _stateDerivative ) const
+{
+    Scalar xbr = _u[0];
+
+    Scalar density = Scalar( density_sea ) * std::exp( -_state[1] / Scalar( 8000 ) );
+    Scalar V = std::sqrt( _state[2]*_state[2] + _state[3]*_state[3] );
+    Scalar M = V / Scalar( sqrt( 1.4*287*278 ) );
+    Scalar Cd_val = Scalar( p00 ) + Scalar( p10 )*xbr + Scalar( p01 )*M + Scalar( p20 )*xbr*xbr + Scalar( p11 )*M*xbr
+                  + Scalar( p02 )*M*M + Scalar( p21 )*xbr*xbr*M + Scalar( p12 )*xbr*M*M + Scalar( p03 )*M*M*M;
+
+    _stateDerivative[0] = _state[2];               // x_dot = Vx
+    _stateDerivative[1] = _state[3];               // y_dot = Vy
+    _stateDerivative[2] = - Scalar( 0.5 ) * density * Scalar( A ) * Cd_val * V * _state[2] / Scalar( mass );  // Vx_dot
+    _stateDerivative[3] = - Scalar( g ) - Scalar( 0.5 ) * density * Scalar( A ) * Cd_val * V * _state[3] / Scalar( mass );  // Vy_dot
+}
+
+
+template <class Scalar>
+inline void rocketModel::output( const Scalar* _state, Scalar* _y ) const
+{
+    _y[0] = _state[1];
+    _y[1] = _state[3];
+}
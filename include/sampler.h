@@ -0,0 +1,94 @@
+/**
+ *	\file include/sampler.h
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#pragma once
+
+#include <Eigen/Dense>              // #include module
+#include <cstdint>
+#include <string>
+#include <vector>
+using namespace Eigen;              // using namespace of module
+
+
+/** Uncertain parameter of a dispersion study, sampled uniformly on [lower, upper]
+ *
+ *  name:   "state"          relative offset of initial state component index
+ *          "sensorBias", "sensorNoise"        output component index
+ *          "actuatorBias", "actuatorNoise"    control component index
+ *          model parameter name (see dynamics::setParameter), index unused
+ */
+struct uncertainParameter
+{
+    std::string name;               // Parameter name
+    unsigned int index;             // Component index
+    float lower;                    // Lower bound
+    float upper;                    // Upper bound
+};
+
+
+class sampler
+{
+    //
+	// PUBLIC MEMBER FUNCTIONS:
+	//
+    public:
+        /** Latin hypercube sample of the unit cube
+         *
+         * @param[in] n             Number of samples
+         * @param[in] dim           Number of dimensions
+         * @param[in] seed          Seed of the random permutations
+         *
+         * \return Samples, one row per sample
+         */
+        static MatrixXd latinHypercube( unsigned int n, unsigned int dim, unsigned int seed );
+
+        /** Sobol quasi-random sequence in the unit cube (Joe-Kuo direction numbers, up to 16 dimensions)
+         *
+         * @param[in] n             Number of samples
+         * @param[in] dim           Number of dimensions
+         * @param[in] skip          Number of initial points of the sequence to skip
+         *
+         * \return Samples, one row per sample
+         */
+        static MatrixXd sobol( unsigned int n, unsigned int dim, unsigned int skip=0 );
+
+        /** Sobol sequence with nested uniform (Owen) scrambling of the digits in every
+         *  dimension. Scrambled samples keep the low discrepancy of the sequence but are
+         *  unbiased, so independent scrambles (seeds) give independent replicates whose
+         *  spread estimates the error of the quasi-random estimate.
+         *
+         * @param[in] n             Number of samples
+         * @param[in] dim           Number of dimensions
+         * @param[in] seed          Seed of the scramble
+         *
+         * \return Samples, one row per sample
+         */
+        static MatrixXd scrambledSobol( unsigned int n, unsigned int dim, unsigned int seed );
+
+        /** Smolyak sparse grid on the unit cube based on nested Clenshaw-Curtis rules
+         *
+         * @param[in] dim           Number of dimensions
+         * @param[in] level         Level of the sparse grid (1: single center point)
+         * @param[out] weights      Quadrature weights of the points (sum to one)
+         *
+         * \return Grid points, one row per point
+         */
+        static MatrixXd smolyak( unsigned int dim, unsigned int level, VectorXd& weights );
+
+
+    //
+	// PRIVATE MEMBER FUNCTIONS:
+	//
+    private:
+        /** Clenshaw-Curtis weights on [0,1] of the rule at given level (2^(level-1)+1 points)
+         */
+        static VectorXd clenshawCurtisWeights( unsigned int level );
+
+        /** Reverse the bit order of a 32-bit word
+         */
+        static uint32_t reverseBits( uint32_t x );
+};
@@ -8,10 +8,18 @@
 #pragma once
 
 #include <Eigen/Dense>              // #include module
+#include <random>
+#include <string>
 using namespace Eigen;              // using namespace of module
 
-class saturator
+/** Position and rate limits, bias and noise on control signals. Templated on the scalar
+ *  type of the control signal; limits are configured in float and applied in Scalar.
+ */
+template <class Scalar>
+class scalarSaturator
 {
+    template <class Other> friend class scalarSaturator;
+
     //
     // PUBLIC MEMBER FUNCTIONS
     //
@@ -19,7 +27,7 @@ class saturator
 
         /** Default constructor
          */ 
-        saturator();
+        scalarSaturator();
 
         /** Constructor which takes dimensions of signal to be saturated
          *
@@ -28,17 +36,30 @@ class saturator
          * @param[in] _bias                 Bias on control input
          * @param[in] _noiseLevel           Noise level on control input
          */
-        saturator( unsigned int _nU, float _samplingTime );
+        scalarSaturator( unsigned int _nU, float _samplingTime );
         
         /** Copy constructor
 		 *
 		 *	@param[in] rhs	Right-hand side object.
 		 */
-		saturator( const saturator& rhs );
+		scalarSaturator( const scalarSaturator& rhs );
+
+        /** Copy assignment (same members as the copy constructor)
+		 *
+		 *	@param[in] rhs	Right-hand side object.
+		 */
+		scalarSaturator& operator=( const scalarSaturator& rhs ) = default;
+
+        /** Converting constructor (same configuration in another precision)
+		 *
+		 *	@param[in] rhs	Right-hand side object.
+		 */
+        template <class Other>
+		explicit scalarSaturator( const scalarSaturator<Other>& rhs );
 
 		/** Destructor. 
 		 */
-		~saturator( );
+		~scalarSaturator( );
 
 
         /** Assigns new lower limit on control signals
@@ -107,6 +128,58 @@ class saturator
          */
         void setNoise( const VectorXf& _noiseLevel );
 
+        /** Set bias on given component of control signal
+         * 
+         * @param[in] idx               Index of control signal component
+         * @param[in] _bias             New bias
+         */
+        void setBias( unsigned int idx, float _bias );
+
+        /** Set noise level on given component of control signal
+         * 
+         * @param[in] idx               Index of control signal component
+         * @param[in] _noiseLevel       New noise level
+         */
+        void setNoise( unsigned int idx, float _noiseLevel );
+
+        /** Seed the noise generator
+         * 
+         * @param[in] _seed             Seed of the random number generator
+         */
+        void setSeed( unsigned int _seed );
+
+        /** Mirror every noise draw about zero (antithetic stream): with the same seed, the
+         *  noise of a mirrored run is the negative of the noise of the unmirrored run
+         * 
+         * @param[in] _antithetic       Mirror noise draws
+         */
+        void setAntithetic( bool _antithetic );
+
+        /** Returns true if noise is added to the signals (the result depends on the generator)
+         */
+        bool isNoisy(  ) const;
+
+        /** Returns complete state of the noise generator (for checkpointing)
+         */
+        std::string getGeneratorState(  ) const;
+
+        /** Restore state of the noise generator from a checkpoint
+         * 
+         * @param[in] _state            Generator state as returned by getGeneratorState
+         */
+        void setGeneratorState( const std::string& _state );
+
+        /** Add configuration to hash identifying a simulation run
+         * 
+         * @param[in,out] hash          Configuration hash
+         */
+        void hashConfiguration( configHash& hash ) const;
+
+
+        /** Returns true if the last control signal was limited (position or rate limit)
+         */
+        bool isSaturated(  ) const;
+
 
         /** Reset satuator
          */
@@ -123,7 +196,7 @@ class saturator
          * 
          * @param[in] _u                Control signal
          */
-        void saturate( VectorXf& _u );
+        void saturate( VectorX<Scalar>& _u );
 
 
 
@@ -136,8 +209,11 @@ class saturator
 
         VectorXf bias;                              // bias in control input 
         VectorXf noiseLevel;                        // percentage noise deviations
+        std::mt19937 generator;                     // Noise generator
+        bool antithetic = false;                    // Mirror noise draws
 
-        VectorXf lastU;				                // Previous control
+        VectorX<Scalar> lastU;                      // Previous control
+        bool saturated;                             // Last control signal was limited
 
 		VectorXf lowerLimitControls;				// Lower limits on control signals
 		VectorXf upperLimitControls;				// Upper limits on control signals
@@ -146,3 +222,6 @@ class saturator
 		VectorXf upperRateLimitControls;			// Upper rate limits on control signals
 
 };
+
+
+typedef scalarSaturator<float> saturator;       // Saturator of single-precision control signals
@@ -0,0 +1,97 @@
+/**
+ *	\file include/scenario.h
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#pragma once
+
+#include <Eigen/Dense>              // #include module
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+using namespace Eigen;              // using namespace of module
+
+class scenarioRunner
+{
+    //
+	// PUBLIC MEMBER FUNCTIONS:
+	//
+    public:
+        /** Default constructor
+         */
+        scenarioRunner(  );
+
+        /** Destructor
+         */
+        virtual ~scenarioRunner(  );
+
+
+        /** Load scenarios from file. The file consists of sections "[name]", each
+         *  describing one run with "key = value" lines. Keys in the section
+         *  "[defaults]" apply to all scenarios unless overridden.
+         *
+         *  Keys: type (simulate|tune|robustness), model (rocket|poweredAscent, initState holds
+         *        Model::NX values), simulationTime, output, journal, cache, seed,
+         *        metrics (names of metrics written per run, see metricSet::add),
+         *        pGains, iGains, dGains, lowerLimit, upperLimit, lowerRateLimit, upperRateLimit,
+         *        actuatorBias, actuatorNoise, sensorBias, sensorNoise, initState, initTime,
+         *        samplingTime, reference (csv file), referenceTime (start step),
+         *        referenceFit (chebyshev <order> | spline <segments>),
+         *        integrator (euler | heun | rk3 | rk4 | dopri5)
+         *
+         * @param[in] fileName      Scenario file
+         */
+        void load( const std::string& fileName );
+
+        /** Run all loaded scenarios on a pool of threads
+         *
+         * @param[in] nThreads      Number of threads (0: number of hardware threads)
+         */
+        void run( unsigned int nThreads=0 );
+
+        /** Returns number of loaded scenarios
+         */
+        unsigned int size(  ) const;
+
+
+    //
+	// PRIVATE MEMBER FUNCTIONS:
+	//
+    private:
+        typedef std::map<std::string, std::string> settings;
+
+        /** Returns setting of a scenario, or default value if the key is not set
+         */
+        std::string getString( const settings& scenario, const std::string& key, const std::string& defaultValue ) const;
+        float getFloat( const settings& scenario, const std::string& key, float defaultValue ) const;
+        VectorXf getVector( const settings& scenario, const std::string& key ) const;
+        VectorXf getVector( const settings& scenario, const std::string& key, const VectorXf& defaultValue ) const;
+
+        /** Returns reference trajectory of a scenario, shared between all scenarios using the same data and fit
+         */
+        std::shared_ptr<const referenceTrajectory> getReference( const settings& scenario );
+
+        /** Build the simulator of a scenario for a plant model, from a prototype shared by scenarios
+         *  with identical configuration
+         *
+         * @param[in] k             Scenario index
+         * @param[in,out] prototypes Controller and dynamics by configuration hash
+         *
+         * \return Run of the scenario
+         */
+        template <class Model>
+        std::function<void()> createRun( unsigned int k,
+                                         std::map<uint64_t, std::pair<PIDcontroller, plantDynamics<Model> > >& prototypes );
+
+
+    //
+	// PRIVATE DATA MEMBER:
+	//
+        std::vector<std::string> names;                                                 // Scenario names
+        std::vector<settings> scenarios;                                                // Scenario settings
+        std::map<std::string, std::shared_ptr<const referenceTrajectory> > references;  // Shared reference trajectories
+};
@@ -0,0 +1,65 @@
+/**
+ *	\file include/scheduler.h
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+class multiRateScheduler
+{
+    //
+	// PUBLIC MEMBER FUNCTIONS:
+	//
+    public:
+        /** Default constructor
+         */
+        multiRateScheduler(  );
+
+        /** Destructor
+         */
+        virtual ~multiRateScheduler(  );
+
+
+        /** Add a periodic task. Tasks that are due at the same instant run in the order
+         *  in which they were added; between its executions the outputs of a task are held.
+         *
+         * @param[in] name          Name of the task
+         * @param[in] rateNum       Numerator of the task rate [Hz]
+         * @param[in] rateDen       Denominator of the task rate (rate = rateNum/rateDen Hz)
+         * @param[in] task          Task, called with the current time
+         */
+        void addTask( const std::string& name, unsigned long rateNum, unsigned long rateDen,
+                      std::function<void( double )> task );
+
+        /** Run all tasks from the start time for given duration. Only instants at which a
+         *  task is due are visited, a task runs at t = startTime + k/rate, k = 0, 1, ...
+         *
+         * @param[in] startTime     Start time
+         * @param[in] duration      Duration
+         */
+        void run( double startTime, double duration );
+
+
+        /** Returns the number of executions of a task in the last run
+         *
+         * @param[in] name          Name of the task
+         */
+        unsigned long getExecutions( const std::string& name ) const;
+
+
+    //
+	// PRIVATE DATA MEMBER:
+	//
+    private:
+        std::vector<std::string> names;                         // Task names
+        std::vector<unsigned long> rateNums;                    // Task rate numerators
+        std::vector<unsigned long> rateDens;                    // Task rate denominators
+        std::vector<std::function<void( double )> > tasks;      // Tasks
+        std::vector<unsigned long> executions;                  // Number of executions per task
+};
@@ -10,8 +10,32 @@
 #include <Eigen/Dense>              // #include module
 using namespace Eigen;              // using namespace of module
 
-class simulator
+
+/** Controller setting varied by paretoTune within [lower, upper]
+ *
+ *  name:   "pGain", "iGain", "dGain"              gain of output component index
+ *          "rateLimit"                             symmetric rate limit (+-value) of control component index
+ *          "lowerRateLimit", "upperRateLimit"      rate limit of control component index
+ *          "lowerLimit", "upperLimit"              limit of control component index
+ */
+struct tuningParameter
 {
+    std::string name;               // Setting name
+    unsigned int index;             // Component index
+    float lower;                    // Lower bound
+    float upper;                    // Upper bound
+};
+
+
+/** Closed-loop simulation and campaigns (tuning, robustness, dispersion) of a PID-controlled
+ *  plant model (see plantModel), with dynamics and controller evaluated in the precision of
+ *  Scalar (float or double). Recorded data and metrics are single precision.
+ */
+template <class Model, class Scalar = float>
+class closedLoopSimulator
+{
+    template <class, class> friend class closedLoopSimulator;
+
     //
 	// PUBLIC MEMBER FUNCTIONS:
 	//
@@ -19,7 +43,7 @@ class simulator
 
         /** Default onstructor
          */
-        simulator();
+        closedLoopSimulator();
         
         /** Set simulator parameters
          * 
@@ -31,12 +55,12 @@ class simulator
          * @param[in] _samplingTime Sampling Time
          * 
          */
-        simulator(  unsigned int _nx,
-                    unsigned int _nu,
-                    unsigned int _ny,
-                    PIDcontroller& controller,
-                    dynamics& system,
-                    float _samplingTime );
+        closedLoopSimulator(    unsigned int _nx,
+                                unsigned int _nu,
+                                unsigned int _ny,
+                                scalarPIDcontroller<Scalar>& controller,
+                                plantDynamics<Model, Scalar>& system,
+                                float _samplingTime );
 
 
         /** Simulate system given the controller and initial state
@@ -47,15 +71,390 @@ class simulator
          */
         void simulate( float simulationTime, bool saveData );
 
+        /** Simulate system from the current configuration into caller-owned buffers,
+         *  without writing output files
+         * 
+         * @param[in] simulationTime    Simulation time
+         * @param[out] metricValues     Values of the chosen metrics (see setMetrics), may be NULL
+         * @param[out] trajectory       State at every decimation-th step, nx values per sample
+         *                              (trajectorySamples samples), may be NULL
+         * @param[in] decimation        Trajectory decimation
+         * 
+         * \return Apogee of the run
+         */
+        float simulateInto( float simulationTime, float* metricValues, float* trajectory=NULL, unsigned int decimation=1 );
+
+        /** Returns number of trajectory samples stored by simulateInto
+         * 
+         * @param[in] simulationTime    Simulation time
+         * @param[in] decimation        Trajectory decimation
+         */
+        unsigned int trajectorySamples( float simulationTime, unsigned int decimation ) const;
+
+        /** Simulate system with components running at their own rates. The plant is
+         *  integrated at plantRate, each output component is sampled at its own sensor
+         *  rate, the actuator applies the latest command at actuatorRate and the
+         *  controller runs at controllerRate (which must match its sampling time).
+         *  The stepper motor speed is estimated from the applied commands at the actuator
+         *  rate, independent of the plant rate. Signals are held (zero-order hold) between
+         *  updates, only components that are due do work.
+         * 
+         * @param[in] simulationTime    Simulation time
+         * @param[in] plantRate         Plant integration rate [Hz]
+         * @param[in] sensorRates       Sample rate of each output component [Hz]
+         * @param[in] actuatorRate      Actuator update rate [Hz]
+         * @param[in] controllerRate    Controller rate [Hz]
+         * @param[in] saveData          Indicate if data should be saved (at controller rate)
+         */
+        void simulateMultiRate( float simulationTime, unsigned int plantRate, const VectorXi& sensorRates,
+                                unsigned int actuatorRate, unsigned int controllerRate, bool saveData );
+
         /** Tune controller gains
          */
         void tune(  );
 
         /** Generate robustness map
+         * 
+         * @param[in] initState         Nominal initial state
+         * @param[in] shardIndex        Index of the shard to compute (0 ... nShards-1)
+         * @param[in] nShards           Number of shards the map is partitioned in. With more than
+         *                              one shard, only every nShards-th point is computed and the
+         *                              result is written to a shard file (see mergeRobustness)
+         */
+        void robustness( const VectorXf& initState, unsigned int shardIndex=0, unsigned int nShards=1 );
+
+        /** Merge shard files of a robustness map into deviations.csv and stateOffsets.csv,
+         *  checking for missing shards and points
+         * 
+         * @param[in] nShards           Number of shards
+         * @param[in] nPoints           Number of points of the robustness map
+         */
+        void mergeRobustness( unsigned int nShards, unsigned int nPoints=441 );
+
+        /** Generate robustness map by adaptive refinement over the same altitude/velocity
+         *  offset range (+-10%). Starting from a coarse grid, cells are split in four
+         *  wherever the deviation at the cell center or edge midpoints differs from the
+         *  (bi)linear interpolation of the cell corners by more than the tolerance.
+         *  The scattered points are written to deviations.csv and stateOffsets.csv.
+         * 
+         * @param[in] initState         Nominal initial state
+         * @param[in] tolerance         Interpolation residual tolerance on the deviation [m]
+         * @param[in] nCoarse           Number of coarse grid cells per dimension
+         * @param[in] maxLevel          Maximum number of refinements of a coarse cell
+         */
+        void adaptiveRobustness( const VectorXf& initState, float tolerance, unsigned int nCoarse=4, unsigned int maxLevel=4 );
+
+        /** Dispersion study over any set of uncertain parameters (initial state, model
+         *  parameters, bias and noise levels). Writes the parameter values of each run to
+         *  dispersionSamples.csv and the deviation from the target apogee to deviations.csv.
+         * 
+         * @param[in] parameters        Uncertain parameters
+         * @param[in] samples           Samples in the unit cube, one row per run, one column per
+         *                              parameter (see sampler)
+         * @param[in] weights           Quadrature weights of the samples (empty: equal weights)
+         */
+        void dispersion( const std::vector<uncertainParameter>& parameters, const MatrixXd& samples,
+                         const VectorXd& weights=VectorXd() );
+
+        /** Compare a candidate controller against the current controller on the apogee
+         *  deviation, with variance reduction across the campaign:
+         *  - common random numbers: both controllers fly every run with the same noise
+         *    streams and the same dispersed parameters, so only the controller differs
+         *  - antithetic pairs: every noise stream is flown a second time with each noise draw
+         *    mirrored (see setAntithetic)
+         *  - scrambled Sobol points (see sampler::scrambledSobol) for the dispersed parameters,
+         *    one independent scramble per replicate
+         *  Writes the deviation of both controllers in every run to comparison.csv and logs the
+         *  standard error of the difference. It also logs the variance reduction: the variance of
+         *  independent-stream Monte Carlo with the same number of flights, estimated from the
+         *  same runs, divided by the achieved variance.
+         * 
+         * @param[in] candidate         Candidate controller
+         * @param[in] nRuns             Number of runs per controller (even with antithetic pairs)
+         * @param[in] parameters        Dispersed parameters (see dispersion), may be empty
+         * @param[in] antithetic        Fly antithetic pairs of noise streams
+         * @param[in] nReplicates       Number of independent scrambles with dispersed parameters
+         *                              (divides the number of runs or pairs)
+         * @param[in] seed              Seed of noise streams and scrambles
+         * @param[in] nThreads          Number of threads (0: one per core)
+         * 
+         * \return Mean deviation of the candidate minus mean deviation of the current controller
+         */
+        float compareControllers( const scalarPIDcontroller<Scalar>& candidate, unsigned int nRuns,
+                                  const std::vector<uncertainParameter>& parameters=std::vector<uncertainParameter>(),
+                                  bool antithetic=true, unsigned int nReplicates=8, unsigned int seed=0,
+                                  unsigned int nThreads=0 );
+
+
+        /** Compare campaign accuracy against an all-double twin of this simulator (same
+         *  controller, dynamics, noise streams and metrics): every point of the robustness map
+         *  is simulated in both precisions. Writes altitude and velocity offset, deviation,
+         *  reference deviation and their difference per point to precisionComparison.csv and
+         *  prints the largest and mean apogee difference and the run time of both precisions.
+         * 
+         * @param[in] tolerance         Apogee tolerance [m] within which this precision is safe
+         * 
+         * \return Largest absolute apogee difference
+         */
+        float comparePrecision( float tolerance );
+
+        /** Step-size convergence study: the closed loop is simulated from the current
+         *  configuration with the plant integrated at a ladder of steps (coarsest step
+         *  1/coarsestRate, halved at every level) while sensors, actuator and controller keep
+         *  running at the controller rate (see simulateMultiRate). The levels run in parallel.
+         *  The observed order of convergence of the apogee follows from every three consecutive
+         *  levels, and the error of each level is estimated against the Richardson extrapolation
+         *  of the two finest levels (against the finest level when the finest observed order is
+         *  not positive, e.g. when switching of the rate limits dominates). Writes step, apogee, observed order and estimated error per
+         *  level to convergence.csv.
+         * 
+         * @param[in] simulationTime    Simulation time
+         * @param[in] coarsestRate      Plant rate of the coarsest level [Hz]
+         * @param[in] nLevels           Number of levels (at least 3)
+         * @param[in] tolerance         Apogee tolerance [m]
+         * @param[in] nThreads          Number of threads (0: one per core)
+         * 
+         * \return Largest step whose estimated apogee error is within the tolerance (0 if none)
+         */
+        float convergenceStudy( float simulationTime, unsigned int coarsestRate, unsigned int nLevels,
+                                float tolerance, unsigned int nThreads=0 );
+
+        /** Multi-objective tuning of controller settings (see paretoOptimizer, NSGA-II) with
+         *  three objectives: deviation from the target apogee, actuator travel and peak stepper
+         *  motor speed. Settings whose peak motor speed exceeds maxOmega are infeasible. The
+         *  candidates of each generation are simulated in parallel from the initial state, each
+         *  on its own copy of the configuration. After every generation, the archive of feasible
+         *  non-dominated settings is written to paretoFront.csv: the setting values, then
+         *  the three objectives.
+         * 
+         * @param[in] parameters        Tuned settings and their bounds
+         * @param[in] populationSize    Population size (even)
+         * @param[in] nGenerations      Number of generations
+         * @param[in] maxOmega          Largest acceptable motor speed
+         * @param[in] seed              Seed of the optimizer
+         * @param[in] nThreads          Number of threads (0: one per core)
+         * 
+         * \return Number of settings on the Pareto front
+         */
+        unsigned int paretoTune( const std::vector<tuningParameter>& parameters, unsigned int populationSize,
+                                 unsigned int nGenerations, float maxOmega=5.0, unsigned int seed=0, unsigned int nThreads=0 );
+
+
+        /** Linearized pre-screen of controller gains (see linearAnalysis): the current
+         *  configuration is simulated once, the plant is linearized at the chosen times of
+         *  that nominal trajectory, and every gain combination is analyzed with the loop
+         *  closed by the PID law (limits inactive). Writes the gains and results of every
+         *  combination to gainScreen.csv.
+         * 
+         * @param[in] gains             One row per combination: proportional, integral and
+         *                              derivative gain of every output (3 ny columns)
+         * @param[in] times             Times of the operating points
+         * @param[in] simulationTime    Simulation time of the nominal trajectory
+         * 
+         * \return One row per combination: largest closed-loop spectral radius (stable below
+         *         one), smallest gain margin [dB], phase margin [deg] and bandwidth [rad/s]
+         */
+        MatrixXf screenGains( const MatrixXf& gains, const VectorXf& times, float simulationTime );
+
+        /** Check a controller generated with PIDcontroller::generateCode against the C++
+         *  controller: the generated header is compiled with the system C compiler ($CC,
+         *  default cc) and loaded, and both controllers are stepped on the same outputs
+         *  during a closed-loop simulation from the initial state. Linux only.
+         * 
+         * @param[in] headerFile        Generated header
+         * @param[in] name              Prefix of the generated identifiers
+         * @param[in] simulationTime    Simulation time
+         * 
+         * \return Largest difference between the control signals
          */
-        void robustness( const VectorXf& initState );
+        float verifyGeneratedCode( const std::string& headerFile, const std::string& name, float simulationTime );
+
+
+        /** Journal campaign results (tune, robustness) to a file and resume from it
+         *  when the campaign is restarted
+         * 
+         * @param[in] fileName          Journal file, progress is checkpointed in <fileName>.chk
+         */
+        void setJournal( const std::string& fileName );
+
+        /** Cache results of campaign runs on disk, keyed by a hash of the full run configuration
+         * 
+         * @param[in] fileName          Cache file, shared between campaigns
+         */
+        void setCache( const std::string& fileName );
+
+        /** Set metrics evaluated on every run. Sweeps (tune, robustness, dispersion) write
+         *  the metrics of each run to metrics.csv (names in metricNames.csv), in the same
+         *  order as their other outputs; a single simulation prints them.
+         * 
+         * @param[in] _metrics          Metric reducers
+         */
+        void setMetrics( const metricSet& _metrics );
+
+        /** Set built-in metrics evaluated on every run (see metricSet::add)
+         * 
+         * @param[in] names             Metric names
+         */
+        void setMetrics( const std::vector<std::string>& names );
+
+        /** Also write sweep results (inputs, deviation and metrics of every run) to a chunked,
+         *  indexed result store for range queries (see resultStore)
+         * 
+         * @param[in] fileName          Store file (empty: no store)
+         */
+        void setResultStore( const std::string& fileName );
+
+        /** Pre-screen the gain grid of tune with screenGains: only combinations that are
+         *  stable at every operating point with sufficient margins are simulated, the
+         *  others are recorded with a NaN deviation
+         * 
+         * @param[in] times             Times of the operating points (empty: no screen)
+         * @param[in] _minGainMargin    Smallest acceptable gain margin [dB]
+         * @param[in] _minPhaseMargin   Smallest acceptable phase margin [deg]
+         */
+        void setGainScreen( const VectorXf& times, float _minGainMargin=6.0, float _minPhaseMargin=30.0 );
+
+        /** Write the trajectories of simulate and simulateMultiRate encoded (state.trj,
+         *  output.trj and input.trj, see trajectoryCodec) instead of as CSV files
+         * 
+         * @param[in] tolerance         Error bound on every signal (0: CSV files)
+         */
+        void setTrajectoryCompression( float tolerance );
+
+        /** Set prefix of output files (default "../data/")
+         * 
+         * @param[in] prefix            Prefix prepended to output file names
+         */
+        void setOutputPrefix( const std::string& prefix );
         
 
+    //
+	// PRIVATE MEMBER FUNCTIONS:
+	//
+    private:
+        /** Closed-loop simulation from the current controller and dynamics configuration
+         * 
+         * @param[in] simulationTime    Simulation time
+         * @param[in] saveData          Indicate if data should be saved to file
+         * @param[out] trajectory       View on caller-owned state samples, may be NULL
+         * @param[in] decimation        Trajectory decimation
+         */
+        void closedLoop( float simulationTime, bool saveData, Map<MatrixXf>* trajectory, unsigned int decimation );
+
+        /** Run closed-loop simulation from the current controller and dynamics configuration,
+         *  or return the result from the cache if this configuration was simulated before
+         * 
+         * @param[in] simulationTime    Simulation time
+         * 
+         * \return Apogee of the run (chosen metrics in metricValues)
+         */
+        float simulateApogee( float simulationTime );
+
+        /** Returns cache key of a run of a controller from the current dynamics configuration
+         * 
+         * @param[in] controller        Controller
+         * @param[in] simulationTime    Simulation time
+         */
+        uint64_t runKey( const scalarPIDcontroller<Scalar>& controller, float simulationTime ) const;
+
+        /** Returns identity of a tune or robustness campaign, kept in the journal checkpoint:
+         *  campaign type, shard and the configuration of its first run
+         * 
+         * @param[in] campaign          Campaign type
+         * @param[in] shardIndex        Index of the shard
+         * @param[in] nShards           Number of shards
+         */
+        uint64_t campaignKey( const std::string& campaign, unsigned int shardIndex, unsigned int nShards ) const;
+
+        /** Simulate noise-free runs that only differ in their controller, from the current
+         *  dynamics configuration. Every controller is stepped on the output of its own
+         *  branch, but runs whose control signals have been identical so far share one plant
+         *  integration. A branch forks (copies the plant state) at the step where the
+         *  commands of its runs start to differ, so the common prefix (e.g. while all
+         *  commands are clamped at a limit) is integrated once instead of once per run.
+         * 
+         * @param[in,out] controllers   Controller of every run (reset)
+         * @param[in] simulationTime    Simulation time
+         * @param[out] plantSteps       Number of plant integration steps taken
+         * 
+         * \return One row per run: apogee, time of apogee and the chosen metrics (as cached)
+         */
+        MatrixXf forkedSweep( std::vector<scalarPIDcontroller<Scalar> >& controllers, float simulationTime,
+                              unsigned long& plantSteps );
+
+        /** Deviation from target apogee for given altitude and velocity offsets
+         * 
+         * @param[in] altitudeOffset    Relative offset of initial altitude
+         * @param[in] velocityOffset    Relative offset of initial vertical velocity
+         */
+        float offsetDeviation( float altitudeOffset, float velocityOffset );
+
+        /** Update apogee and chosen metrics with the signals of the next step (see metricSample)
+         */
+        void updateMetrics( Scalar time, float dt, const VectorX<Scalar>& y, const VectorX<Scalar>& u,
+                            const VectorX<Scalar>& error, Scalar omega, bool saturated );
+
+        /** Log the apogee and the values of the chosen metrics
+         */
+        void printMetrics(  ) const;
+
+        /** Write the saved state, output and input trajectories (CSV or encoded)
+         */
+        void saveTrajectories(  );
+
+        /** Write metrics of a sweep, one row per run (if any metrics are chosen)
+         */
+        void saveMetrics( MatrixXf& table ) const;
+
+        /** Write sweep results to the result store (if configured)
+         * 
+         * @param[in] inputNames        Names of the input columns
+         * @param[in] inputs            Inputs of every run
+         * @param[in] deviations        Deviation from target apogee of every run
+         * @param[in] metricTable       Metrics of every run
+         */
+        void saveStore( const std::vector<std::string>& inputNames, const MatrixXf& inputs,
+                        const MatrixXf& deviations, const MatrixXf& metricTable ) const;
+
+        /** Returns relative altitude and velocity offsets of the robustness map points
+         */
+        MatrixXf gridOffsets( unsigned int nPoints ) const;
+
+        /** Returns file name of a robustness map shard
+         */
+        std::string shardFileName( unsigned int shardIndex, unsigned int nShards ) const;
+
+        /** Apply values of uncertain parameters (see uncertainParameter) to a configuration
+         * 
+         * @param[in] parameters        Uncertain parameters
+         * @param[in] values            Value of every parameter
+         * @param[in,out] rocket        Dynamics
+         * @param[in,out] controller    Controller
+         * @param[in,out] offsets       Relative initial state offsets (nx values)
+         */
+        static void applyUncertainty( const std::vector<uncertainParameter>& parameters, const VectorXf& values,
+                                      plantDynamics<Model, Scalar>& rocket, scalarPIDcontroller<Scalar>& controller,
+                                      VectorXf& offsets );
+
+        /** Apply tuned settings (see tuningParameter) to a controller
+         * 
+         * @param[in] parameters        Tuned settings
+         * @param[in] values            Value of every setting
+         * @param[in,out] controller    Controller
+         */
+        static void applyTuning( const std::vector<tuningParameter>& parameters, const VectorXf& values,
+                                 scalarPIDcontroller<Scalar>& controller );
+
+        /** Returns states of all noise generators (controller, dynamics)
+         */
+        std::vector<std::string> getGeneratorStates(  ) const;
+
+        /** Restore states of all noise generators (controller, dynamics)
+         */
+        void setGeneratorStates( const std::vector<std::string>& states );
+
+
+
     //
 	// PRIVATE DATA MEMBER:
 	//
@@ -64,8 +463,8 @@ class simulator
         unsigned int nu;        // Number of inputs
         unsigned int ny;        // Number of outputs
 
-        dynamics Rocket;        // Rocket dynamics
-        PIDcontroller PID;      // PID controller
+        plantDynamics<Model, Scalar> Rocket;    // Rocket dynamics
+        scalarPIDcontroller<Scalar> PID;        // PID controller
         
         MatrixXf X;             // Save state data
         MatrixXf Y;             // Save output data
@@ -73,4 +472,22 @@ class simulator
 
         float samplingTime;     // Sampling time
 
+        journal campaignJournal;    // Journal of campaign results
+        resultCache cache;          // Cache of run results
+
+        std::string outputPrefix = "../data/";     // Prefix of output files
+        std::string storeFile;                      // Result store of sweeps (empty: none)
+        float trajectoryTolerance = 0.0;            // Error bound of encoded trajectories (0: CSV)
+
+        VectorXf screenTimes;       // Operating point times of the gain screen of tune (empty: none)
+        float minGainMargin = 6.0;  // Smallest gain margin [dB] and phase margin [deg] passing the screen
+        float minPhaseMargin = 30.0;
+
+        apogeeMetric apogee;        // Apogee of the current run
+        metricSet metrics;          // Chosen metrics of every run
+        VectorXf metricValues;      // Metric values of the last run of simulateApogee
+
 };
+
+
+typedef closedLoopSimulator<rocketModel> simulator;    // Simulator of the 2-D point-mass rocket
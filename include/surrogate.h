@@ -0,0 +1,153 @@
+/**
+ *	\file include/surrogate.h
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#pragma once
+
+#include <Eigen/Dense>              // #include module
+#include <string>
+using namespace Eigen;              // using namespace of module
+
+
+/** Surrogate model of a scalar campaign output (e.g. deviation from the target apogee) as a
+ *  function of the campaign inputs, trained on sweep or Monte Carlo results. Inputs are
+ *  scaled to [-1, 1] over the range of the training data. Two representations:
+ *
+ *      RBF                 cubic radial basis functions phi(r) = r^3 centered at the training
+ *                          points plus a linear polynomial (interpolating, or smoothing)
+ *      POLYNOMIAL_CHAOS    Legendre polynomials of total degree <= order, least squares
+ *
+ *  A single query costs one pass over the centers or terms and does not allocate; the RBF
+ *  centers are stored per input so that blocks of centers are evaluated with SIMD packets.
+ *
+ *  File layout (little endian): magic, representation, number of inputs, input offset and
+ *  scale, then centers and weights (RBF) or multi-indices and coefficients (polynomial chaos).
+ */
+class surrogateModel
+{
+    //
+	// PUBLIC MEMBER FUNCTIONS:
+	//
+    public:
+        enum representation { NONE = 0, RBF = 1, POLYNOMIAL_CHAOS = 2 };
+
+        static const unsigned int MAX_INPUTS = 16;      // Largest number of inputs
+        static const unsigned int MAX_ORDER = 16;       // Largest polynomial chaos order
+
+        /** Default constructor (empty model, evaluates to zero)
+         */
+        surrogateModel(  );
+
+        /** Destructor
+         */
+        ~surrogateModel(  );
+
+
+        /** Fit cubic radial basis functions with linear tail through the training data
+         *
+         * @param[in] inputs        Training inputs, one row per run, one column per input
+         * @param[in] outputs       Training outputs, one per run
+         * @param[in] smoothing     Smoothing (0: interpolate, > 0: regression of noisy outputs)
+         */
+        void fitRBF( const MatrixXf& inputs, const VectorXf& outputs, float smoothing=0.0 );
+
+        /** Fit a polynomial chaos expansion (Legendre polynomials) by least squares
+         *
+         * @param[in] inputs        Training inputs, one row per run, one column per input
+         * @param[in] outputs       Training outputs, one per run
+         * @param[in] order         Total degree of the expansion
+         */
+        void fitPolynomialChaos( const MatrixXf& inputs, const VectorXf& outputs, unsigned int order );
+
+        /** K-fold cross-validation of the current representation and settings: the model is
+         *  refitted without every nFolds-th run (interleaved folds) and evaluated on the
+         *  runs left out. The model itself is not changed.
+         *
+         * @param[in] inputs        Training inputs, one row per run, one column per input
+         * @param[in] outputs       Training outputs, one per run
+         * @param[in] nFolds        Number of folds
+         *
+         * \return Root-mean-square and largest absolute prediction error
+         */
+        VectorXf crossValidate( const MatrixXf& inputs, const VectorXf& outputs, unsigned int nFolds=5 ) const;
+
+
+        /** Evaluate the surrogate at one point
+         *
+         * @param[in] x             Inputs (getNumInputs values)
+         *
+         * \return Predicted output
+         */
+        inline float evaluate( const float* x ) const;
+
+        /** Evaluate the surrogate at many points
+         *
+         * @param[in] inputs        Inputs, one row per point
+         * @param[out] outputs      Predicted outputs
+         */
+        void evaluate( const MatrixXf& inputs, VectorXf& outputs ) const;
+
+
+        /** Write the model to a binary file
+         *
+         * @param[in] fileName      Model file
+         */
+        void save( const std::string& fileName ) const;
+
+        /** Read a model written by save
+         *
+         * @param[in] fileName      Model file
+         */
+        void load( const std::string& fileName );
+
+
+        /** Returns representation of the model
+         */
+        representation getType(  ) const;
+
+        /** Returns number of inputs
+         */
+        unsigned int getNumInputs(  ) const;
+
+        /** Returns number of RBF centers or polynomial chaos terms
+         */
+        unsigned int getNumTerms(  ) const;
+
+
+    //
+	// PRIVATE MEMBER FUNCTIONS:
+	//
+    private:
+        /** Set input scaling to map the range of the training inputs onto [-1, 1]
+         */
+        void setScaling( const MatrixXf& inputs );
+
+        /** Returns training inputs scaled to [-1, 1]
+         */
+        MatrixXd scaledInputs( const MatrixXf& inputs ) const;
+
+        /** Check dimensions of training data
+         */
+        void checkData( const MatrixXf& inputs, const VectorXf& outputs ) const;
+
+
+    //
+	// PRIVATE DATA MEMBER:
+	//
+        representation type = NONE;     // Representation
+        unsigned int nInputs = 0;       // Number of inputs
+
+        VectorXf offset;                // Input scaling: (x - offset)*scale in [-1, 1]
+        VectorXf scale;
+
+        float smoothing = 0.0;          // RBF smoothing
+        MatrixXf centers;               // RBF centers (scaled), one row per center (contiguous per input)
+        VectorXf weights;               // RBF weights, followed by constant and linear tail
+
+        unsigned int order = 0;         // Polynomial chaos order
+        MatrixXi multiIndices;          // Degree of each input, one column per term
+        VectorXf coefficients;          // Coefficient of each term
+};
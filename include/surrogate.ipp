@@ -0,0 +1,73 @@
+/**
+ *	\file include/surrogate.ipp
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#include "../header.h"    // #include header
+
+
+inline float surrogateModel::evaluate( const float* x ) const
+{
+    // Scaled inputs
+    float s[MAX_INPUTS];
+    for ( unsigned int i=0; i<nInputs; ++i )
+        s[i] = ( x[i] - offset(i) )*scale(i);
+
+    if ( type == RBF )
+    {
+        const unsigned int BLOCK = 32;
+        unsigned int n = centers.rows();
+        const float* w = weights.data();
+
+        // Linear tail
+        float sum = w[n];
+        for ( unsigned int i=0; i<nInputs; ++i )
+            sum += w[n+1+i]*s[i];
+
+        // Cubic radial basis functions, BLOCK centers at a time
+        Array<float, BLOCK, 1> r2;
+        unsigned int j = 0;
+        for ( ; j+BLOCK<=n; j+=BLOCK )
+        {
+            r2 = ( s[0] - centers.col(0).segment<BLOCK>(j).array() ).square();
+            for ( unsigned int i=1; i<nInputs; ++i )
+                r2 += ( s[i] - centers.col(i).segment<BLOCK>(j).array() ).square();
+            sum += ( weights.segment<BLOCK>(j).array()*r2*r2.sqrt() ).sum();
+        }
+        for ( ; j<n; ++j )
+        {
+            float d2 = 0.0f;
+            for ( unsigned int i=0; i<nInputs; ++i )
+                d2 += ( s[i] - centers(j,i) )*( s[i] - centers(j,i) );
+            sum += w[j]*d2*std::sqrt( d2 );
+        }
+        return sum;
+    }
+    else if ( type == POLYNOMIAL_CHAOS )
+    {
+        // Legendre polynomials of every input: (k+1) L_k+1 = (2k+1) s L_k - k L_k-1
+        float L[MAX_INPUTS][MAX_ORDER+1];
+        for ( unsigned int i=0; i<nInputs; ++i )
+        {
+            L[i][0] = 1.0f;
+            if ( order > 0 )
+                L[i][1] = s[i];
+            for ( unsigned int k=1; k<order; ++k )
+                L[i][k+1] = ( (2*k+1)*s[i]*L[i][k] - k*L[i][k-1] )/(k+1);
+        }
+
+        float sum = 0.0f;
+        const int* alpha = multiIndices.data();
+        for ( unsigned int t=0; t<coefficients.size(); ++t, alpha+=nInputs )
+        {
+            float term = coefficients(t);
+            for ( unsigned int i=0; i<nInputs; ++i )
+                term *= L[i][alpha[i]];
+            sum += term;
+        }
+        return sum;
+    }
+    return 0.0f;
+}
@@ -0,0 +1,129 @@
+/**
+ *	\file include/trajectoryCodec.h
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#pragma once
+
+#include <Eigen/Dense>              // #include module
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+using namespace Eigen;              // using namespace of module
+
+
+/** Lossy binary codec for trajectories: one row per signal (state, output, input, motor
+ *  speed), one column per sample. Every signal is quantized with a step of twice its error
+ *  bound, so a decoded value is within the bound of the original up to float rounding.
+ *  Trajectories are smooth, so predicting every quantized value from the previous ones leaves
+ *  small residuals. Per signal and block the cheaper of two predictors is used: the previous
+ *  value (for piecewise constant signals such as the motor speed) or the linear extrapolation of
+ *  the two previous values. The residuals are zigzag-encoded and bit-packed, every 32
+ *  residuals with the smallest width that holds them, so a single jump (e.g. a saturation)
+ *  does not widen the whole block.
+ *
+ *  Samples are grouped in blocks that are coded independently, so any range of samples is
+ *  decoded without touching the other blocks.
+ *
+ *  Layout (little endian): header (magic, signals, samples, block size), quantization step of
+ *  every signal, offset of every block, blocks. A block holds, per signal: predictor, first
+ *  quantized value, then bit width and packed residuals of every 32 samples.
+ */
+class trajectoryCodec
+{
+    //
+	// PUBLIC MEMBER FUNCTIONS:
+	//
+    public:
+        /** Default constructor
+         */
+        trajectoryCodec(  );
+
+        /** Destructor
+         */
+        ~trajectoryCodec(  );
+
+
+        /** Encode a trajectory and write it to file
+         *
+         * @param[in] fileName      Trajectory file
+         * @param[in] data          Trajectory, one row per signal, one column per sample
+         * @param[in] tolerances    Error bound of every signal
+         * @param[in] blockSize     Number of samples per block
+         */
+        static void save( const std::string& fileName, const MatrixXf& data, const VectorXf& tolerances,
+                          unsigned int blockSize=256 );
+
+        /** Encode a trajectory and write it to file, same error bound for all signals
+         *
+         * @param[in] fileName      Trajectory file
+         * @param[in] data          Trajectory, one row per signal, one column per sample
+         * @param[in] tolerance     Error bound
+         * @param[in] blockSize     Number of samples per block
+         */
+        static void save( const std::string& fileName, const MatrixXf& data, float tolerance, unsigned int blockSize=256 );
+
+        /** Returns true if a file is an encoded trajectory (checks the magic number)
+         *
+         * @param[in] fileName      File name
+         */
+        static bool isTrajectory( const std::string& fileName );
+
+
+        /** Open an encoded trajectory for reading (reads header and block offsets)
+         *
+         * @param[in] fileName      Trajectory file
+         */
+        void open( const std::string& fileName );
+
+        /** Close the trajectory file
+         */
+        void close(  );
+
+        /** Returns number of signals
+         */
+        unsigned int getNumSignals(  ) const;
+
+        /** Returns number of samples
+         */
+        unsigned int getNumSamples(  ) const;
+
+        /** Decode the complete trajectory
+         */
+        MatrixXf read(  );
+
+        /** Decode a range of samples, only the blocks overlapping the range are read
+         *
+         * @param[in] first         First sample
+         * @param[in] count         Number of samples
+         */
+        MatrixXf read( unsigned int first, unsigned int count );
+
+
+    //
+	// PRIVATE MEMBER FUNCTIONS:
+	//
+    private:
+        /** Decode one block into the columns of a trajectory
+         *
+         * @param[in] block         Block index
+         * @param[in,out] data      Trajectory, one row per signal
+         * @param[in] column        Column of the first sample of the block
+         */
+        void decodeBlock( unsigned int block, MatrixXf& data, unsigned int column );
+
+
+    //
+	// PRIVATE DATA MEMBER:
+	//
+        std::ifstream file;                 // Trajectory file
+        unsigned int nSignals;              // Number of signals
+        unsigned int nSamples;              // Number of samples
+        unsigned int blockSize;             // Samples per block
+        VectorXd steps;                     // Quantization step of every signal
+        std::vector<uint64_t> offsets;      // File offset of every block (and end of file)
+        std::vector<unsigned char> buffer;  // Encoded block
+};
@@ -1,8 +1,137 @@
 #include "header.h"
 
+#include <chrono>
+#include <cstdlib>
+
+
+/** Parse a non-negative integer command line argument
+ *
+ * @param[in] arg           Argument
+ * @param[out] value        Parsed value
+ *
+ * \return True if the whole argument is a valid number
+ */
+static bool parseUnsigned( const char* arg, unsigned int& value )
+{
+    char* end;
+    unsigned long parsed = strtoul( arg, &end, 10 );
+    if ( arg[0] < '0' || arg[0] > '9' || *end != '\0' || parsed > 0xFFFFFFFFul )
+        return false;
+
+    value = (unsigned int) parsed;
+    return true;
+}
+
 
 int main(int argc, char const *argv[])
 {
+    /* Sharded robustness map: ControlSoftware --shard <index> <count> | --merge <count> */
+    bool shardMode = ( argc > 3 && string( argv[1] ) == "--shard" );
+    bool mergeMode = ( argc > 2 && string( argv[1] ) == "--merge" );
+
+    unsigned int shardIndex = 0, nShards = 1;
+    if ( ( shardMode && ( !parseUnsigned( argv[2], shardIndex ) || !parseUnsigned( argv[3], nShards ) || shardIndex >= nShards ) )
+         || ( mergeMode && !parseUnsigned( argv[2], nShards ) ) || nShards == 0 )
+    {
+        logger::error( "Invalid shard arguments, expected --shard <index> <count> with index < count, or --merge <count> with count > 0" );
+        logger::flush();
+        return 1;
+    }
+
+    /* Flight code export: ControlSoftware --codegen <header> (generates and verifies C controller) */
+    bool codegenMode = ( argc > 2 && string( argv[1] ) == "--codegen" );
+
+    /* Result store query: ControlSoftware --query <store> <column> <lower> <upper> [<column> <lower> <upper> ...] */
+    if ( argc > 2 && string( argv[1] ) == "--query" )
+    {
+        std::vector<rangeCondition> conditions;
+        for ( int i=3; i+2<argc; i+=3 )
+            conditions.push_back( { argv[i], stof( argv[i+1] ), stof( argv[i+2] ) } );
+
+        resultStore store;
+        store.open( argv[2] );
+
+        MatrixXf rows;
+        unsigned int nScanned = store.query( conditions, rows );
+        std::cout << rows.rows() << " of " << store.getNumRows() << " runs match, " << nScanned << " of "
+                  << store.getNumChunks() << " chunks scanned" << std::endl;
+
+        saveToFile( rows, rows.rows(), rows.cols(), "../data/query.csv" );
+        return 0;
+    }
+
+    /* Surrogate model: ControlSoftware --surrogate <store> <output column> <input column> [<input column> ...] */
+    if ( argc > 4 && string( argv[1] ) == "--surrogate" )
+    {
+        resultStore store;
+        store.open( argv[2] );
+
+        MatrixXf rows;
+        store.query( {}, rows );
+
+        VectorXf outputs = rows.col( store.columnIndex( argv[3] ) );
+        MatrixXf inputs( rows.rows(), argc-4 );
+        for ( int i=4; i<argc; ++i )
+            inputs.col( i-4 ) = rows.col( store.columnIndex( argv[i] ) );
+
+        // Candidates: RBF (dense solve, small sweeps only) and polynomial chaos of increasing order
+        surrogateModel best, candidate;
+        float bestError = INFINITY;
+        auto consider = [&]( const std::string& name )
+        {
+            VectorXf error = candidate.crossValidate( inputs, outputs, 5 );
+            std::cout << name << ": cross-validated rms error " << error(0) << " max error " << error(1) << std::endl;
+            if ( error(0) < bestError )
+            {
+                best = candidate;
+                bestError = error(0);
+            }
+        };
+
+        if ( inputs.rows() <= 5000 )
+        {
+            candidate.fitRBF( inputs, outputs );
+            consider( "RBF" );
+        }
+        for ( unsigned int order=2; order<=surrogateModel::MAX_ORDER; order+=2 )
+        {
+            try
+            {
+                candidate.fitPolynomialChaos( inputs, outputs, order );
+            }
+            catch ( const std::invalid_argument& )
+            {
+                break;      // More terms than runs
+            }
+            consider( "Polynomial chaos order " + std::to_string( order ) );
+        }
+
+        // Query time of the chosen model
+        VectorXf x = inputs.row(0).transpose();
+        [[maybe_unused]] volatile float prediction;
+        auto start = std::chrono::steady_clock::now();
+        for ( unsigned int k=0; k<1000000; ++k )
+        {
+            x(0) = inputs(k % inputs.rows(), 0);
+            prediction = best.evaluate( x.data() );
+        }
+        double elapsed = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+        best.save( "../data/surrogate.bin" );
+        std::cout << "Saved " << ( best.getType() == surrogateModel::RBF ? "RBF" : "polynomial chaos" ) << " surrogate with "
+                  << best.getNumTerms() << " terms, " << elapsed*1e3 << " ns per query" << std::endl;
+        return 0;
+    }
+
+    /* Scenario batch: ControlSoftware <scenario file> [threads] */
+    if ( argc > 1 && !shardMode && !mergeMode && !codegenMode )
+    {
+        scenarioRunner Runner;
+        Runner.load( argv[1] );
+        Runner.run( argc > 2 ? atoi( argv[2] ) : 0 );
+        return 0;
+    }
+
     /* Controller */
     PIDcontroller PID( 2, 1, 0.05 );
 
@@ -30,13 +159,21 @@ int main(int argc, char const *argv[])
     PID.setControlLowerRateLimit(0, -0.05);
     PID.setControlUpperRateLimit(0, 0.05);
 
-    // Controller reference using polynomial approximation coefficients
-    MatrixXf ref( 2,6 );
+    // Controller reference fitted to the optimal trajectory (altitude and velocity, t = 5.5:0.05:25.5)
+    MatrixXf refData = loadFromFile( "../data/OptimalTrajectoryDelayed_0.05.csv", 2, 401 );
+    VectorXf refTime = VectorXf::LinSpaced( 401, 5.5, 25.5 );
 
-    ref.row(0) << 0.000552959959483582,-0.0536167708516457,2.11969221432553,-48.1791794728476,707.049841776998,-1640.19371969719;   // Altitude reference signal
-    ref.row(1) << -1.78444699910487e-05,0.00365544263025656,-0.225186229775288,6.27114893267685,-94.0507177583389,696.642796048007; // Velocity reference signal       
+    referenceTrajectory ref;
+    ref.fitChebyshev( refTime, refData, 12 );                           // 12th order Chebyshev series
+    // ref.fitSpline( refTime, refData, 40 );                           // Natural cubic spline, 40 segments
 
-    PID.setPolynomialReference(ref);
+    PID.setReference( ref );
+
+    // Controller reference using polynomial approximation coefficients (from getTrajectory.m)
+    // MatrixXf refCoeff( 2,6 );
+    // refCoeff.row(0) << 0.000552959959483582,-0.0536167708516457,2.11969221432553,-48.1791794728476,707.049841776998,-1640.19371969719;   // Altitude reference signal
+    // refCoeff.row(1) << -1.78444699910487e-05,0.00365544263025656,-0.225186229775288,6.27114893267685,-94.0507177583389,696.642796048007; // Velocity reference signal       
+    // PID.setPolynomialReference( refCoeff );
 
 
     /* System dynamics */
@@ -49,6 +186,14 @@ int main(int argc, char const *argv[])
     unsigned int ny = 2;     // Output dimension
 
     dynamics Rocket( nx, nu, ny, init_state, 0.05, t_burn );
+    // Rocket.setIntegrator( "heun" );                                // euler, heun, rk3, rk4 (default) or dopri5
+
+    /* Re-identify the drag model from recorded flights (files written by simulate) */
+    // parameterIdentification<rocketModel> identification( Rocket.getModel(), Rocket.getIntegrator() );
+    // identification.addLogFromFiles( "../data/flight1_", t_burn, 0.05 );
+    // identification.addLogFromFiles( "../data/flight2_", t_burn, 0.05 );
+    // identification.fit( { "p00", "p10", "p01", "p20", "p11", "p02", "p21", "p12", "p03" } );
+    // Rocket.setModel( identification.getModel() );
     
 
     /* Set sensor and actuator bias and noise */
@@ -73,7 +218,67 @@ int main(int argc, char const *argv[])
     /* Closed-loop simulation */
     simulator Simulator( nx, nu, ny, PID, Rocket, 0.05 );
 
+    // logger::setLevel( logger::DEBUG );                            // Log every run and every 25th simulation step
+
+    // Simulator.setJournal( "../data/campaign.journal" );            // Resume interrupted tune/robustness campaigns
+    // Simulator.setCache( "../data/results.cache" );                // Reuse results of previously simulated runs
+    // Simulator.setResultStore( "../data/results.store" );          // Indexed store of sweep results (see --query)
+    // Simulator.setTrajectoryCompression( 0.001 );                   // Encoded trajectories (*.trj) within 1 mm instead of CSV
+    // Simulator.setMetrics( { "apogeeTime", "peakOmega", "actuatorTravel", "saturationTime", "rmsAltitudeError" } );  // KPIs per run
+
+    if ( shardMode )
+    {
+        Simulator.robustness( init_state, shardIndex, nShards );
+        return 0;
+    }
+    if ( mergeMode )
+    {
+        try
+        {
+            Simulator.mergeRobustness( nShards );
+        }
+        catch ( const std::exception& e )
+        {
+            logger::error( "Merge failed: ", e.what() );
+            logger::flush();
+            return 1;
+        }
+        return 0;
+    }
+    if ( codegenMode )
+    {
+        PID.generateCode( argv[2], "airbrake" );
+        return ( Simulator.verifyGeneratedCode( argv[2], "airbrake", 20.0 ) > 1e-6 ) ? 1 : 0;
+    }
+
     Simulator.simulate( 20.0, true );
+    // VectorXi sensorRates( ny ); sensorRates << 50, 1000;             // Barometer 50 Hz, IMU 1 kHz
+    // Simulator.simulateMultiRate( 20.0, 200, sensorRates, 200, 20, true );
+    // VectorXf screenTimes( 3 ); screenTimes << 6.0, 10.0, 15.0;         // Operating points of the linearized gain screen
+    // Simulator.setGainScreen( screenTimes, 6.0, 30.0 );               // tune simulates only stable gains with 6 dB / 30 deg margins
     //Simulator.tune(  );
     //Simulator.robustness( init_state );
+    //Simulator.adaptiveRobustness( init_state, 2.0 );
+    //Simulator.comparePrecision( 0.5 );                                // Float vs all-double apogee over the robustness map
+    //Simulator.convergenceStudy( 20.0, 20, 5, 0.05 );                  // Largest integration step within 5 cm of apogee
+    // std::vector<tuningParameter> tuned = { { "pGain", 0, -10.0, -0.5 },
+    //                                        { "dGain", 0, -15.0, -1.0 },
+    //                                        { "rateLimit", 0, 0.01, 0.1 } };
+    // Simulator.paretoTune( tuned, 64, 50, 5.0 );                       // Apogee error vs actuator travel vs motor speed
+
+    /* Dispersion study over initial state, model parameters and sensor bias */
+    // std::vector<uncertainParameter> uncertain = { { "state", 1, -0.05, 0.05 },
+    //                                               { "state", 3, -0.05, 0.05 },
+    //                                               { "mass", 0, 19.5, 20.7 },
+    //                                               { "A", 0, 0.0185, 0.0197 },
+    //                                               { "p00", 0, 0.38, 0.45 },
+    //                                               { "sensorBias", 0, -30.0, 30.0 } };
+    // Simulator.dispersion( uncertain, sampler::sobol( 1024, uncertain.size() ) );        // or sampler::latinHypercube
+    // VectorXd weights;
+    // MatrixXd grid = sampler::smolyak( uncertain.size(), 3, weights );
+    // Simulator.dispersion( uncertain, grid, weights );
+    // PIDcontroller candidate( PID );                                 // Gain set to compare, same noise streams
+    // VectorXf candidateGains( ny ); candidateGains << -3.3, -3.3;
+    // candidate.setProportionalGains( candidateGains );
+    // Simulator.compareControllers( candidate, 256, uncertain );         // Antithetic pairs, 8 scrambled Sobol replicates
 }
\ No newline at end of file
@@ -0,0 +1,283 @@
+/**
+ *	\file src/cache.cpp
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#include "../header.h"    // #include header
+
+#include <cstdio>
+#include <cinttypes>
+#include <cstdlib>
+#include <mutex>
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#endif
+
+
+/** Serializes appends of the caches in this process (several scenarios may share one file)
+ */
+static std::mutex appendMutex;
+
+
+/** Checksum of a cache record, stored after its last field
+ */
+static uint64_t recordChecksum( const std::string& record )
+{
+    configHash checksum;
+    checksum.add( record );
+    return checksum.value();
+}
+
+
+/** Append a complete line to a file with a single write, so that records of concurrent writers
+ *  (threads or processes) are not interleaved
+ */
+static void appendLine( const std::string& fileName, const std::string& line )
+{
+    std::lock_guard<std::mutex> lock( appendMutex );
+
+#ifdef _WIN32
+    int file = _open( fileName.c_str(), _O_WRONLY | _O_APPEND | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE );
+    bool written = file >= 0 && _write( file, line.data(), line.size() ) == (int) line.size();
+    if ( file >= 0 )
+        _close( file );
+#else
+    int file = open( fileName.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644 );
+    bool written = file >= 0 && write( file, line.data(), line.size() ) == (ssize_t) line.size();
+    if ( file >= 0 )
+        close( file );
+#endif
+    if ( !written )
+        throw std::runtime_error("Unable to append to cache file " + fileName);
+}
+
+
+//
+// PUBLIC MEMBER FUNCTIONS (configHash):
+//
+
+configHash::configHash(  )
+{
+    state = 14695981039346656037ULL;        // FNV offset basis
+}
+
+
+void configHash::add( const void* data, size_t size )
+{
+    const unsigned char* bytes = (const unsigned char*) data;
+
+    for ( size_t i=0; i<size; ++i )
+    {
+        state ^= bytes[i];
+        state *= 1099511628211ULL;          // FNV prime
+    }
+}
+
+
+void configHash::add( float value )
+{
+    add( &value, sizeof( value ) );
+}
+
+
+void configHash::add( double value )
+{
+    add( &value, sizeof( value ) );
+}
+
+
+void configHash::add( unsigned int value )
+{
+    add( &value, sizeof( value ) );
+}
+
+
+void configHash::add( const std::string& value )
+{
+    add( (unsigned int) value.size() );
+    add( value.data(), value.size() );
+}
+
+
+void configHash::add( const VectorXf& value )
+{
+    add( (unsigned int) value.size() );
+    add( value.data(), value.size()*sizeof( float ) );
+}
+
+
+void configHash::add( const VectorXd& value )
+{
+    add( (unsigned int) value.size() );
+    add( value.data(), value.size()*sizeof( double ) );
+}
+
+
+void configHash::add( const MatrixXf& value )
+{
+    add( (unsigned int) value.rows() );
+    add( (unsigned int) value.cols() );
+    add( value.data(), value.size()*sizeof( float ) );
+}
+
+
+void configHash::add( const MatrixXd& value )
+{
+    add( (unsigned int) value.rows() );
+    add( (unsigned int) value.cols() );
+    add( value.data(), value.size()*sizeof( double ) );
+}
+
+
+uint64_t configHash::value(  ) const
+{
+    return state;
+}
+
+
+
+//
+// PUBLIC MEMBER FUNCTIONS (resultCache):
+//
+
+resultCache::resultCache(  ){}
+
+
+resultCache::resultCache( std::string _fileName )
+{
+    fileName = _fileName;
+
+    // Load previously cached runs
+    ifstream File( fileName );
+    string line;
+
+    while ( getline( File, line ) )
+    {
+        std::vector<float> values;
+        std::vector<std::string> states;
+        string entry;
+
+        // Skip records that are incomplete or corrupted (checksum after '#')
+        size_t mark = line.rfind( '#' );
+        if ( mark == string::npos )
+            continue;
+        char* end;
+        uint64_t checksum = strtoull( line.c_str() + mark + 1, &end, 16 );
+        if ( end == line.c_str() + mark + 1 || *end != '\0' )
+            continue;
+        line.resize( mark );
+        if ( checksum != recordChecksum( line ) )
+            continue;
+
+        // Generator states (no commas) follow the result, separated by semicolons
+        size_t separator = line.find( ';' );
+        if ( separator != string::npos )
+        {
+            std::istringstream stateStream( line.substr( separator + 1 ) );
+            while ( getline( stateStream, entry, ';' ) )
+                states.push_back( entry );
+            line.resize( separator );
+        }
+        std::istringstream stream( line );
+
+        if ( !getline( stream, entry, ',' ) )
+            continue;
+        uint64_t key = strtoull( entry.c_str(), &end, 16 );
+        bool valid = !entry.empty() && *end == '\0';
+
+        while ( valid && getline( stream, entry, ',' ) )
+        {
+            values.push_back( strtof( entry.c_str(), &end ) );
+            valid = !entry.empty() && *end == '\0';
+        }
+        if ( !valid )
+            continue;
+
+        entries[key] = Map<VectorXf>( values.data(), values.size() );
+        if ( !states.empty() )
+            generatorStates[key] = states;
+    }
+}
+
+
+resultCache::~resultCache(  ){}
+
+
+bool resultCache::lookup( uint64_t key, VectorXf& result ) const
+{
+    std::unordered_map<uint64_t, VectorXf>::const_iterator it = entries.find( key );
+
+    if ( it == entries.end() )
+        return false;
+
+    result = it->second;
+    return true;
+}
+
+
+bool resultCache::lookup( uint64_t key, VectorXf& result, std::vector<std::string>& states ) const
+{
+    if ( !lookup( key, result ) )
+        return false;
+
+    std::unordered_map<uint64_t, std::vector<std::string> >::const_iterator it = generatorStates.find( key );
+    if ( it == generatorStates.end() )
+        states.clear();
+    else
+        states = it->second;
+    return true;
+}
+
+
+void resultCache::store( uint64_t key, const VectorXf& result )
+{
+    store( key, result, std::vector<std::string>() );
+}
+
+
+void resultCache::store( uint64_t key, const VectorXf& result, const std::vector<std::string>& states )
+{
+    for ( unsigned int i=0; i<states.size(); ++i )
+        if ( states[i].find_first_of( ",;#\n" ) != std::string::npos )
+            throw std::invalid_argument("Generator state cannot be stored in the cache");
+
+    entries[key] = result;
+    if ( states.empty() )
+        generatorStates.erase( key );
+    else
+        generatorStates[key] = states;
+
+    // One record per line: key,result...[;state...]#checksum
+    char value[32];
+    snprintf( value, sizeof( value ), "%016" PRIx64, key );
+    string line = value;
+    for ( unsigned int j=0; j<result.size(); ++j )
+    {
+        snprintf( value, sizeof( value ), ",%.9g", result(j) );
+        line.append( value );
+    }
+    for ( unsigned int i=0; i<states.size(); ++i )
+        line.append( ";" + states[i] );
+    snprintf( value, sizeof( value ), "#%016" PRIx64 "\n", recordChecksum( line ) );
+    line.append( value );
+
+    appendLine( fileName, line );
+}
+
+
+bool resultCache::isActive(  ) const
+{
+    return !fileName.empty();
+}
+
+
+unsigned int resultCache::size(  ) const
+{
+    return entries.size();
+}
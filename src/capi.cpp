@@ -0,0 +1,114 @@
+/**
+ *	\file src/capi.cpp
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#include "../header.h"    // #include header
+
+
+typedef Matrix<float, Dynamic, Dynamic, RowMajor> rowMatrixXf;     // Layout of caller-owned arrays
+
+
+//
+// C INTERFACE:
+//
+
+int rocketsim_api_version( void )
+{
+    return ROCKETSIM_API_VERSION;
+}
+
+
+unsigned int rocketsim_trajectory_samples( const rocketsim_batch* batch )
+{
+    if ( !batch || batch->decimation == 0 || batch->samplingTime <= 0.0f )
+        return 0;
+
+    int Nsim = (int) batch->simulationTime/batch->samplingTime;
+    return Nsim/batch->decimation + 1;
+}
+
+
+int rocketsim_simulate_batch( const rocketsim_batch* batch, rocketsim_results* results, char* error, size_t errorSize )
+{
+    const unsigned int nx = rocketModel::NX, nu = rocketModel::NU, ny = rocketModel::NY;
+
+    try
+    {
+        if ( !batch || !results )
+            throw std::invalid_argument("No batch or results given");
+        if ( !batch->initStates || !batch->gains || !results->apogee )
+            throw std::invalid_argument("Initial states, gains and apogee output are required");
+        if ( batch->nParameters > 0 && ( !batch->parameterNames || !batch->parameters ) )
+            throw std::invalid_argument("Missing model parameter names or values");
+        if ( batch->nMetrics > 0 && !batch->metricNames )
+            throw std::invalid_argument("Missing metric names");
+
+        unsigned int nRuns = batch->nRuns;
+        unsigned int nSamples = rocketsim_trajectory_samples( batch );
+
+        // Views on caller-owned arrays
+        Map<const rowMatrixXf> initStates( batch->initStates, nRuns, nx );
+        Map<const rowMatrixXf> gains( batch->gains, nRuns, 6 );
+        Map<const rowMatrixXf> parameters( batch->parameters, nRuns, batch->nParameters );
+        Map<VectorXf> apogee( results->apogee, nRuns );
+
+        std::vector<std::string> parameterNames( batch->parameterNames, batch->parameterNames + batch->nParameters );
+        std::vector<std::string> metricNames( batch->metricNames, batch->metricNames + batch->nMetrics );
+
+        // Prototype controller, shared by all runs
+        PIDcontroller prototype( ny, nu, batch->samplingTime );
+        prototype.setControlLowerLimit( 0, batch->limits[0] );
+        prototype.setControlUpperLimit( 0, batch->limits[1] );
+        prototype.setControlLowerRateLimit( 0, batch->limits[2] );
+        prototype.setControlUpperRateLimit( 0, batch->limits[3] );
+
+        if ( batch->nReference > 0 )
+        {
+            Map<const VectorXf> referenceTime( batch->referenceTime, batch->nReference );
+            Map<const MatrixXf> referenceData( batch->referenceData, batch->nReference, 2 );    // row-major 2 x n
+
+            referenceTrajectory reference;
+            reference.fitChebyshev( referenceTime, referenceData.transpose(), batch->referenceOrder );
+            prototype.setReference( reference );
+        }
+        metricSet metrics( metricNames );
+
+        parallelFor( nRuns, batch->nThreads, [&]( unsigned int k )
+        {
+            /* Controller */
+            PIDcontroller PID( prototype );
+            PID.setProportionalGains( gains.block<1,2>(k,0).transpose() );
+            PID.setIntegralGains( gains.block<1,2>(k,2).transpose() );
+            PID.setDerivativeGains( gains.block<1,2>(k,4).transpose() );
+
+            /* System dynamics */
+            dynamics Rocket( nx, nu, ny, initStates.row(k).transpose(), batch->samplingTime, batch->initTime );
+            for ( unsigned int j=0; j<parameterNames.size(); ++j )
+                Rocket.setParameter( parameterNames[j], parameters(k,j) );
+
+            /* Closed-loop simulation into caller-owned outputs */
+            simulator Simulator( nx, nu, ny, PID, Rocket, batch->samplingTime );
+            Simulator.setMetrics( metrics );
+
+            float* metricValues = results->metrics ? results->metrics + (size_t) k*metrics.size() : NULL;
+            float* trajectory = ( results->trajectories && nSamples > 0 )
+                              ? results->trajectories + (size_t) k*nSamples*nx : NULL;
+
+            apogee(k) = Simulator.simulateInto( batch->simulationTime, metricValues, trajectory,
+                                                std::max( 1u, batch->decimation ) );
+        }, "Run" );
+    }
+    catch ( const std::exception& e )
+    {
+        if ( error && errorSize > 0 )
+            snprintf( error, errorSize, "%s", e.what() );
+        return 1;
+    }
+
+    if ( error && errorSize > 0 )
+        error[0] = '\0';
+    return 0;
+}
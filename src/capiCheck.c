@@ -0,0 +1,116 @@
+/**
+ *	\file src/capiCheck.c
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ *
+ *  Check of the C interface (registered as test c_interface): a plain C caller simulates the
+ *  nominal scenario through rocketsim and compares the results with the C++ simulation.
+ *  Run from the build directory (reads ../data/OptimalTrajectoryDelayed_0.05.csv).
+ */
+
+#include "capi.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define N_RUNS 4
+#define N_REFERENCE 401
+
+
+/** Report a failed check
+ */
+static int fail( const char* message )
+{
+    fprintf( stderr, "C interface check failed: %s\n", message );
+    return 1;
+}
+
+
+int main( void )
+{
+    static float referenceTime[N_REFERENCE], referenceData[2*N_REFERENCE];
+    float initStates[N_RUNS*4], gains[N_RUNS*6], apogee[N_RUNS], apogeeSerial[N_RUNS], metrics[N_RUNS];
+    const char* metricNames[1] = { "peakOmega" };
+    const char* parameterNames[1] = { "unknownParameter" };
+    float parameters[N_RUNS];
+    char error[256];
+    unsigned int i, k;
+
+    if ( rocketsim_api_version() != ROCKETSIM_API_VERSION )
+        return fail( "library built for another ABI version" );
+
+    /* Reference: altitude and velocity, one sample per 0.05 s from 5.5 s */
+    FILE* file = fopen( "../data/OptimalTrajectoryDelayed_0.05.csv", "r" );
+    if ( file == NULL )
+        return fail( "unable to open reference trajectory" );
+    for ( i=0; i<2*N_REFERENCE; ++i )
+        if ( fscanf( file, "%f%*[,\n]", &referenceData[i] ) != 1 )
+        {
+            fclose( file );
+            return fail( "unable to read reference trajectory" );
+        }
+    fclose( file );
+    for ( i=0; i<N_REFERENCE; ++i )
+        referenceTime[i] = 5.5f + 0.05f*i;
+
+    /* Nominal configuration of main.cpp, the second half of the runs with a lower proportional gain */
+    for ( k=0; k<N_RUNS; ++k )
+    {
+        float state[4] = { 171.9f, 1098.5f, 54.14f, 332.26f };
+        float gain[6] = { -3.0f, -3.0f, 0.0f, 0.0f, -7.0f, -7.0f };
+        if ( k >= N_RUNS/2 )
+            gain[0] = -1.0f;
+        memcpy( &initStates[4*k], state, sizeof( state ) );
+        memcpy( &gains[6*k], gain, sizeof( gain ) );
+    }
+
+    rocketsim_batch batch;
+    memset( &batch, 0, sizeof( batch ) );
+    batch.nRuns = N_RUNS;
+    batch.simulationTime = 20.0f;
+    batch.samplingTime = 0.05f;
+    batch.initTime = 5.5f;
+    batch.initStates = initStates;
+    batch.gains = gains;
+    batch.limits[0] = 0.0f;  batch.limits[1] = 0.05f;
+    batch.limits[2] = -0.05f; batch.limits[3] = 0.05f;
+    batch.nReference = N_REFERENCE;
+    batch.referenceTime = referenceTime;
+    batch.referenceData = referenceData;
+    batch.referenceOrder = 12;
+    batch.nMetrics = 1;
+    batch.metricNames = metricNames;
+
+    rocketsim_results results = { apogee, metrics, NULL };
+    if ( rocketsim_simulate_batch( &batch, &results, error, sizeof( error ) ) != 0 )
+        return fail( error );
+
+    /* Same apogee as the nominal C++ simulation */
+    if ( fabs( apogee[0] - 3499.74 ) > 0.01 )
+        return fail( "nominal apogee differs from the C++ simulation" );
+    if ( apogee[1] != apogee[0] || apogee[3] != apogee[2] || apogee[2] == apogee[0] )
+        return fail( "runs do not follow their own configuration" );
+
+    /* Independent of the number of threads */
+    batch.nThreads = 1;
+    results.apogee = apogeeSerial;
+    if ( rocketsim_simulate_batch( &batch, &results, error, sizeof( error ) ) != 0 )
+        return fail( error );
+    if ( memcmp( apogee, apogeeSerial, sizeof( apogee ) ) != 0 )
+        return fail( "results depend on the number of threads" );
+
+    /* Errors are reported, not thrown across the interface */
+    for ( k=0; k<N_RUNS; ++k )
+        parameters[k] = 1.0f;
+    batch.nParameters = 1;
+    batch.parameterNames = parameterNames;
+    batch.parameters = parameters;
+    error[0] = '\0';
+    if ( rocketsim_simulate_batch( &batch, &results, error, sizeof( error ) ) == 0 || error[0] == '\0' )
+        return fail( "unknown model parameter not reported" );
+
+    printf( "C interface check passed (apogee %.2f)\n", apogee[0] );
+    return 0;
+}
@@ -12,16 +12,18 @@
 // PUBLIC MEMBER FUNCTIONS:
 //
 
-PIDcontroller::PIDcontroller(  ) : saturator(  )
+template <class Scalar>
+scalarPIDcontroller<Scalar>::scalarPIDcontroller(  ) : scalarSaturator<Scalar>(  )
 {
     nInputs = 0;
     nOutputs = 0;
 }
 
 
-PIDcontroller::PIDcontroller(   unsigned int _nInputs,
+template <class Scalar>
+scalarPIDcontroller<Scalar>::scalarPIDcontroller(   unsigned int _nInputs,
                                 unsigned int _nOutputs,
-                                float _sampleTime ) : saturator( _nOutputs, _sampleTime )
+                                float _sampleTime ) : scalarSaturator<Scalar>( _nOutputs, _sampleTime )
 {
     if ( ( _nOutputs != _nInputs ) && ( _nOutputs != 1 ) )
     {
@@ -31,18 +33,19 @@ PIDcontroller::PIDcontroller(   unsigned int _nInputs,
     nInputs  = _nInputs;
 	nOutputs = _nOutputs;
 
-	pGains = VectorXf::Zero( nInputs );
-	iGains = VectorXf::Zero( nInputs );
-	dGains = VectorXf::Zero( nInputs );
+	pGains = VectorX<Scalar>::Zero( nInputs );
+	iGains = VectorX<Scalar>::Zero( nInputs );
+	dGains = VectorX<Scalar>::Zero( nInputs );
 
-    iValue = VectorXf::Zero( nInputs );
-	lastError = VectorXf::Zero( nInputs );
+    iValue = VectorX<Scalar>::Zero( nInputs );
+	lastError = VectorX<Scalar>::Zero( nInputs );
 
     samplingTime = _sampleTime;
 }
 
 
-PIDcontroller::PIDcontroller( const PIDcontroller& rhs ) : saturator( rhs )
+template <class Scalar>
+scalarPIDcontroller<Scalar>::scalarPIDcontroller( const scalarPIDcontroller& rhs ) : scalarSaturator<Scalar>( rhs )
 {
     nInputs  = rhs.nInputs;
 	nOutputs = rhs.nOutputs;
@@ -53,55 +56,134 @@ PIDcontroller::PIDcontroller( const PIDcontroller& rhs ) : saturator( rhs )
 
 	iValue    = rhs.iValue;
 	lastError = rhs.lastError;
+
+    samplingTime = rhs.samplingTime;
+    reference = rhs.reference;
+    u = rhs.u;
+}
+
+
+template <class Scalar>
+template <class Other>
+scalarPIDcontroller<Scalar>::scalarPIDcontroller( const scalarPIDcontroller<Other>& rhs ) : scalarSaturator<Scalar>( rhs )
+{
+    nInputs  = rhs.nInputs;
+	nOutputs = rhs.nOutputs;
+
+	pGains = rhs.pGains.template cast<Scalar>();
+	iGains = rhs.iGains.template cast<Scalar>();
+	dGains = rhs.dGains.template cast<Scalar>();
+
+	iValue    = rhs.iValue.template cast<Scalar>();
+	lastError = rhs.lastError.template cast<Scalar>();
+
+    samplingTime = rhs.samplingTime;
+    reference = rhs.reference;
+    u = rhs.u.template cast<Scalar>();
 }
 
 
-PIDcontroller::~PIDcontroller(  ){}
+template <class Scalar>
+scalarPIDcontroller<Scalar>::~scalarPIDcontroller(  ){}
 
 
-void PIDcontroller::setProportionalGains( const VectorXf& _pGains )
+template <class Scalar>
+void scalarPIDcontroller<Scalar>::setProportionalGains( const VectorXf& _pGains )
 {
     if ( _pGains.size() != nInputs )
         throw std::invalid_argument("Number of proportional gains does not match number of inputs");
     else
-        pGains = _pGains;
+        pGains = _pGains.cast<Scalar>();
 }
 
 
-void PIDcontroller::setIntegralGains( const VectorXf& _iGains )
+template <class Scalar>
+void scalarPIDcontroller<Scalar>::setIntegralGains( const VectorXf& _iGains )
 {
     if ( _iGains.size() != nInputs )
         throw std::invalid_argument("Number of integral gains does not match number of inputs");
     else
-        iGains = _iGains;
+        iGains = _iGains.cast<Scalar>();
 }
 
 
-void PIDcontroller::setDerivativeGains( const VectorXf& _dGains )
+template <class Scalar>
+void scalarPIDcontroller<Scalar>::setDerivativeGains( const VectorXf& _dGains )
 {
     if ( _dGains.size() != nInputs )
         throw std::invalid_argument("Number of derivative gains does not match number of inputs");
     else
-        dGains = _dGains;
+        dGains = _dGains.cast<Scalar>();
+}
+
+
+template <class Scalar>
+void scalarPIDcontroller<Scalar>::setProportionalGains( unsigned int idx, float _pGain )
+{
+    if ( idx >= nInputs )
+        throw std::invalid_argument("Invalid index for input component given");
+
+    pGains( idx ) = _pGain;
+}
+
+
+template <class Scalar>
+void scalarPIDcontroller<Scalar>::setIntegralGains( unsigned int idx, float _iGain )
+{
+    if ( idx >= nInputs )
+        throw std::invalid_argument("Invalid index for input component given");
+
+    iGains( idx ) = _iGain;
 }
 
 
-void PIDcontroller::setPolynomialReference( const MatrixXf& _refCoeff)
+template <class Scalar>
+void scalarPIDcontroller<Scalar>::setDerivativeGains( unsigned int idx, float _dGain )
+{
+    if ( idx >= nInputs )
+        throw std::invalid_argument("Invalid index for input component given");
+
+    dGains( idx ) = _dGain;
+}
+
+
+template <class Scalar>
+void scalarPIDcontroller<Scalar>::setPolynomialReference( const MatrixXf& _refCoeff)
 {
     if ( _refCoeff.rows() != nInputs )
         throw std::invalid_argument("Incorrect number of reference trajectories given");
+
+    std::shared_ptr<referenceTrajectory> ref = std::make_shared<referenceTrajectory>(  );
+    ref->setMonomial( _refCoeff );
+    reference = ref;
+}
+
+
+template <class Scalar>
+void scalarPIDcontroller<Scalar>::setReference( const referenceTrajectory& _reference )
+{
+    setReference( std::make_shared<const referenceTrajectory>( _reference ) );
+}
+
+
+template <class Scalar>
+void scalarPIDcontroller<Scalar>::setReference( std::shared_ptr<const referenceTrajectory> _reference )
+{
+    if ( _reference && _reference->getNumSignals() != nInputs )
+        throw std::invalid_argument("Incorrect number of reference trajectories given");
     else
-        refCoeff = _refCoeff;
+        reference = _reference;
 }
 
 
-void PIDcontroller::init( const VectorXf& _x0, const VectorXf& _yRef, double startTime )
+template <class Scalar>
+void scalarPIDcontroller<Scalar>::init( const VectorX<Scalar>& _x0, const VectorX<Scalar>& _yRef, double startTime )
 {
     if ( _x0.size() != nInputs ) 
         throw std::invalid_argument("Incorrect number of input dimensions");
 
     // Set reference trajectory
-    VectorXf xRef( _x0.size() );
+    VectorX<Scalar> xRef( _x0.size() );
 
     if ( _yRef.size() > 0 )
     {
@@ -116,32 +198,24 @@ void PIDcontroller::init( const VectorXf& _x0, const VectorXf& _yRef, double sta
     }
 
     // Initialize control signals
-    u = VectorXf::Zero( nOutputs );
+    u = VectorX<Scalar>::Zero( nOutputs );
 
     lastError = xRef - _x0;
 }
 
 
-void PIDcontroller::init( const VectorXf& _x0, double startTime )
+template <class Scalar>
+void scalarPIDcontroller<Scalar>::init( const VectorX<Scalar>& _x0, double startTime )
 {
     if ( _x0.size() != nInputs ) 
         throw std::invalid_argument("Incorrect number of input dimensions");
 
     // Get reference trajectory
-    VectorXf xRef( _x0.size() ); xRef.setZero();
+    VectorX<Scalar> xRef( _x0.size() ); xRef.setZero();
 
-    if ( refCoeff.rows() > 0 )
+    if ( reference )
     {
-        if ( refCoeff.rows() != nInputs )
-            throw std::invalid_argument("Incorrect number of reference trajectories given");
-        else
-            for ( unsigned int i=0; i<refCoeff.rows(); ++i)
-            {
-                for ( unsigned int j=0; j<refCoeff.cols(); ++j)
-                {
-                    xRef(i) += refCoeff(i,j) * pow( startTime,refCoeff.cols()-j-1 );
-                }
-            }
+        reference->evaluate( startTime, xRef );
     }
     else
     {
@@ -149,19 +223,20 @@ void PIDcontroller::init( const VectorXf& _x0, double startTime )
     }
 
     // Initialize control signals
-    u = VectorXf::Zero( nOutputs );
+    u = VectorX<Scalar>::Zero( nOutputs );
 
     lastError = xRef - _x0;
 }
 
 
-void PIDcontroller::step( double currentTime, const VectorXf& _x, const VectorXf& _yRef )
+template <class Scalar>
+void scalarPIDcontroller<Scalar>::step( double currentTime, const VectorX<Scalar>& _x, const VectorX<Scalar>& _yRef )
 {
     if ( _x.size() != nInputs ) 
         throw std::invalid_argument("Incorrect number of input dimensions");
 
     // Set reference trajectory
-    VectorXf xRef( _x.size() );
+    VectorX<Scalar> xRef( _x.size() );
 
     if ( _yRef.size() > 0 )
     {
@@ -184,30 +259,22 @@ void PIDcontroller::step( double currentTime, const VectorXf& _x, const VectorXf
         u.setZero();
 
     // Saturate output
-    saturate( u );
+    this->saturate( u );
 }
 
 
-void PIDcontroller::step( double currentTime, const VectorXf& _x )
+template <class Scalar>
+void scalarPIDcontroller<Scalar>::step( double currentTime, const VectorX<Scalar>& _x )
 {
     if ( _x.size() != nInputs ) 
         throw std::invalid_argument("Incorrect number of input dimensions");
 
     // Get reference trajectory
-    VectorXf xRef( _x.size() ); xRef.setZero();
+    VectorX<Scalar> xRef( _x.size() ); xRef.setZero();
 
-    if ( refCoeff.rows() > 0 )
+    if ( reference )
     {
-        if ( refCoeff.rows() != nInputs )
-            throw std::invalid_argument("Incorrect number of reference trajectories given");
-        else
-            for ( unsigned int i=0; i<refCoeff.rows(); ++i)
-            {
-                for ( unsigned int j=0; j<refCoeff.cols(); ++j)
-                {
-                    xRef(i) += refCoeff(i,j) * pow( currentTime,refCoeff.cols()-j-1 );
-                }
-            }
+        reference->evaluate( currentTime, xRef );
     }
     else
     {
@@ -223,16 +290,196 @@ void PIDcontroller::step( double currentTime, const VectorXf& _x )
         u.setZero();
 
     // Saturate output
-    saturate( u );
+    this->saturate( u );
 }
 
 
-void PIDcontroller::resetController(  )
+template <class Scalar>
+void scalarPIDcontroller<Scalar>::hashConfiguration( configHash& hash ) const
 {
-    iValue = VectorXf::Zero( nInputs );
-	lastError = VectorXf::Zero( nInputs );
+    scalarSaturator<Scalar>::hashConfiguration( hash );
+
+    hash.add( nInputs );
+    hash.add( nOutputs );
+    hash.add( samplingTime );
+
+    hash.add( pGains );
+    hash.add( iGains );
+    hash.add( dGains );
+    hash.add( iValue );
+
+    if ( reference )
+        reference->hashConfiguration( hash );
+    else
+        hash.add( (unsigned int) referenceTrajectory::NONE );
+}
+
+
+template <class Scalar>
+void scalarPIDcontroller<Scalar>::resetController(  )
+{
+    iValue = VectorX<Scalar>::Zero( nInputs );
+	lastError = VectorX<Scalar>::Zero( nInputs );
     
-    u = VectorXf::Zero( nOutputs );
+    u = VectorX<Scalar>::Zero( nOutputs );
+}
+
+
+
+template <class Scalar>
+void scalarPIDcontroller<Scalar>::generateCode( const std::string& fileName, const std::string& name ) const
+{
+    // Exact (hexadecimal) C literals
+    auto literal = []( double value, bool isFloat ) -> std::string
+    {
+        char buffer[64];
+        snprintf( buffer, sizeof( buffer ), "%a", value );
+        return std::string( buffer ) + ( isFloat ? "f" : "" );
+    };
+    // Signals and constants have the scalar type of this controller
+    const bool isFloat = std::is_same<Scalar, float>::value;
+    const std::string real = isFloat ? "float" : "double";
+    const std::string zero = isFloat ? "0.0f" : "0.0";
+
+    auto realArray = [&]( const VectorXd& values ) -> std::string
+    {
+        std::string str = "{ ";
+        for ( unsigned int i=0; i<values.size(); ++i )
+            str += literal( values(i), isFloat ) + ( i+1 < values.size() ? ", " : " }" );
+        return str;
+    };
+
+    std::string guard = name;
+    std::transform( guard.begin(), guard.end(), guard.begin(), ::toupper );
+
+    std::ofstream File( fileName );
+    if ( !File.is_open() )
+        throw std::runtime_error("Could not open file " + fileName);
+
+    File << "/* Generated by PIDcontroller::generateCode, do not edit. */\n\n";
+    File << "#ifndef " << guard << "_H\n#define " << guard << "_H\n\n";
+    File << "#include <math.h>\n\n";
+    File << "#define " << guard << "_NIN " << nInputs << "\n";
+    File << "#define " << guard << "_NOUT " << nOutputs << "\n\n";
+
+    File << "typedef struct\n{\n";
+    File << "    " << real << " iValue[" << guard << "_NIN];\n";
+    File << "    " << real << " lastError[" << guard << "_NIN];\n";
+    File << "    " << real << " lastU[" << guard << "_NOUT];\n";
+    File << "} " << name << "_state;\n\n";
+
+    File << "static const " << real << " " << name << "_pGains[] = " << realArray( pGains.template cast<double>() ) << ";\n";
+    File << "static const " << real << " " << name << "_iGains[] = " << realArray( iGains.template cast<double>() ) << ";\n";
+    File << "static const " << real << " " << name << "_dGains[] = " << realArray( dGains.template cast<double>() ) << ";\n";
+    File << "static const " << real << " " << name << "_lowerLimit[] = " << realArray( this->lowerLimitControls.template cast<double>() ) << ";\n";
+    File << "static const " << real << " " << name << "_upperLimit[] = " << realArray( this->upperLimitControls.template cast<double>() ) << ";\n";
+    File << "static const " << real << " " << name << "_lowerRateLimit[] = " << realArray( this->lowerRateLimitControls.template cast<double>() ) << ";\n";
+    File << "static const " << real << " " << name << "_upperRateLimit[] = " << realArray( this->upperRateLimitControls.template cast<double>() ) << ";\n\n";
+
+    // Reference trajectory
+    File << "static inline void " << name << "_reference( double t, " << real << "* yRef )\n{\n";
+    referenceTrajectory::representation type = reference ? reference->getType() : referenceTrajectory::NONE;
+    if ( type != referenceTrajectory::NONE )
+    {
+        const MatrixXd& coeff = reference->getCoefficients();
+        double t0 = reference->getStartTime(), t1 = reference->getEndTime();
+
+        if ( type == referenceTrajectory::SPLINE )
+        {
+            unsigned int nSegments = coeff.cols()/4;
+            File << "    double s;\n    int idx = (int) floor( (t - " << literal( t0, false ) << ")/" << literal( (t1 - t0)/nSegments, false ) << " );\n";
+            File << "    if ( idx < 0 ) idx = 0;\n    if ( idx > " << nSegments-1 << " ) idx = " << nSegments-1 << ";\n";
+            File << "    s = t - ( " << literal( t0, false ) << " + idx*" << literal( (t1 - t0)/nSegments, false ) << " );\n\n";
+        }
+        else if ( type == referenceTrajectory::CHEBYSHEV )
+        {
+            File << "    double s = ( 2.0*t - " << literal( t0 + t1, false ) << " ) / " << literal( t1 - t0, false ) << ";\n";
+            File << "    double b1, b2, tmp;\n\n";
+        }
+
+        for ( unsigned int i=0; i<coeff.rows(); ++i )
+        {
+            File << "    {\n";
+            if ( type == referenceTrajectory::MONOMIAL )
+            {
+                // Horner scheme
+                File << "        double tmp = " << literal( coeff(i,0), false ) << ";\n";
+                for ( unsigned int j=1; j<coeff.cols(); ++j )
+                    File << "        tmp = tmp*t + " << literal( coeff(i,j), false ) << ";\n";
+                File << "        yRef[" << i << "] = (" << real << ") tmp;\n";
+            }
+            else if ( type == referenceTrajectory::CHEBYSHEV )
+            {
+                // Clenshaw recurrence
+                File << "        b1 = 0.0; b2 = 0.0;\n";
+                for ( int j=coeff.cols()-1; j>=1; --j )
+                    File << "        tmp = 2.0*s*b1 - b2 + " << literal( coeff(i,j), false ) << "; b2 = b1; b1 = tmp;\n";
+                File << "        yRef[" << i << "] = (" << real << ") ( s*b1 - b2 + " << literal( coeff(i,0), false ) << " );\n";
+            }
+            else
+            {
+                // Segment table in Horner order
+                File << "        static const double c[][4] = {\n";
+                for ( unsigned int k=0; k<coeff.cols()/4; ++k )
+                    File << "            { " << literal( coeff(i,4*k), false ) << ", " << literal( coeff(i,4*k+1), false ) << ", "
+                         << literal( coeff(i,4*k+2), false ) << ", " << literal( coeff(i,4*k+3), false ) << " },\n";
+                File << "        };\n";
+                File << "        yRef[" << i << "] = (" << real << ") ( ( ( c[idx][0]*s + c[idx][1] )*s + c[idx][2] )*s + c[idx][3] );\n";
+            }
+            File << "    }\n";
+        }
+    }
+    else
+    {
+        File << "    int i;\n    (void) t;\n";
+        File << "    for ( i=0; i<" << guard << "_NIN; ++i )\n        yRef[i] = " << zero << ";\n";
+    }
+    File << "}\n\n";
+
+    // Initialization
+    File << "static inline void " << name << "_init( " << name << "_state* state, const " << real << "* y0, double t )\n{\n";
+    File << "    " << real << " yRef[" << guard << "_NIN];\n    int i;\n\n";
+    File << "    " << name << "_reference( t, yRef );\n";
+    File << "    for ( i=0; i<" << guard << "_NIN; ++i )\n    {\n";
+    File << "        state->iValue[i] = " << zero << ";\n";
+    File << "        state->lastError[i] = yRef[i] - y0[i];\n    }\n";
+    File << "    for ( i=0; i<" << guard << "_NOUT; ++i )\n        state->lastU[i] = " << zero << ";\n}\n\n";
+
+    // Control law and saturation
+    File << "static inline void " << name << "_step( " << name << "_state* state, double t, const " << real << "* y, " << real << "* u )\n{\n";
+    File << "    " << real << " yRef[" << guard << "_NIN], error[" << guard << "_NIN];\n";
+    File << "    " << real << " tmp;\n    int i;\n\n";
+    File << "    " << name << "_reference( t, yRef );\n";
+    File << "    for ( i=0; i<" << guard << "_NOUT; ++i )\n        u[i] = " << zero << ";\n\n";
+    File << "    /* PID law */\n";
+    File << "    for ( i=0; i<" << guard << "_NIN; ++i )\n    {\n";
+    File << "        error[i] = yRef[i] - y[i];\n";
+    File << "        state->iValue[i] += error[i] * " << literal( samplingTime, isFloat ) << ";\n    }\n";
+    File << "    for ( i=0; i<" << guard << "_NIN; ++i )\n    {\n";
+    File << "        tmp  = " << name << "_pGains[i] * error[i];\n";
+    File << "        tmp += " << name << "_iGains[i] * state->iValue[i];\n";
+    File << "        tmp += " << name << "_dGains[i] * (error[i] - state->lastError[i]) / " << literal( samplingTime, isFloat ) << ";\n";
+    File << "        state->lastError[i] = error[i];\n";
+    if ( nOutputs > 1 )
+        File << "        u[i] = tmp;\n";
+    else
+        File << "        u[0] = u[0] + tmp;\n";
+    File << "    }\n\n";
+    File << "    /* Position and rate limits */\n";
+    File << "    for ( i=0; i<" << guard << "_NOUT; ++i )\n    {\n";
+    File << "        " << real << " lb = " << name << "_lowerLimit[i], ub = " << name << "_upperLimit[i];\n";
+    File << "        if ( state->lastU[i] + " << literal( scalarSaturator<Scalar>::samplingTime, isFloat ) << "*" << name << "_lowerRateLimit[i] > lb )\n";
+    File << "            lb = state->lastU[i] + " << literal( scalarSaturator<Scalar>::samplingTime, isFloat ) << "*" << name << "_lowerRateLimit[i];\n";
+    File << "        if ( state->lastU[i] + " << literal( scalarSaturator<Scalar>::samplingTime, isFloat ) << "*" << name << "_upperRateLimit[i] < ub )\n";
+    File << "            ub = state->lastU[i] + " << literal( scalarSaturator<Scalar>::samplingTime, isFloat ) << "*" << name << "_upperRateLimit[i];\n";
+    File << "        if ( u[i] > ub ) u[i] = ub;\n";
+    File << "        if ( u[i] < lb ) u[i] = lb;\n";
+    File << "        state->lastU[i] = u[i];\n\n";
+    File << "        if ( u[i] < " << name << "_lowerLimit[i] ) u[i] = " << name << "_lowerLimit[i];\n";
+    File << "        if ( u[i] > " << name << "_upperLimit[i] ) u[i] = " << name << "_upperLimit[i];\n";
+    File << "    }\n}\n\n";
+
+    File << "#endif\n";
 }
 
 
@@ -241,23 +488,24 @@ void PIDcontroller::resetController(  )
 // PRIVATE MEMBER FUNCTION:
 //
 
-void PIDcontroller::determineControlAction( const VectorXf& error, VectorXf& output )
+template <class Scalar>
+void scalarPIDcontroller<Scalar>::determineControlAction( const VectorX<Scalar>& error, VectorX<Scalar>& output )
 {
     unsigned int i;
-    double tmp;
+    Scalar tmp, h = samplingTime;
 
-    output = VectorXf::Zero( nOutputs );
+    output = VectorX<Scalar>::Zero( nOutputs );
 
     // Update integral value
     for ( i=0; i<nInputs; ++i )
-        iValue(i) += error(i) * samplingTime;
+        iValue(i) += error(i) * h;
 
     // determine ouputs
     for ( i=0; i<nInputs; ++i )
     {
         tmp  = pGains(i) * error(i);
         tmp += iGains(i) * iValue(i);
-        tmp += dGains(i) * (error(i) - lastError(i)) / samplingTime;
+        tmp += dGains(i) * (error(i) - lastError(i)) / h;
 
         if ( nOutputs > 1  )
             output(i) = tmp;
@@ -268,3 +516,15 @@ void PIDcontroller::determineControlAction( const VectorXf& error, VectorXf& out
     // update last error
     lastError = error;
 }
+
+
+
+//
+// EXPLICIT INSTANTIATIONS:
+//
+
+template class scalarPIDcontroller<float>;
+template class scalarPIDcontroller<double>;
+
+template scalarPIDcontroller<float>::scalarPIDcontroller( const scalarPIDcontroller<double>& );
+template scalarPIDcontroller<double>::scalarPIDcontroller( const scalarPIDcontroller<float>& );
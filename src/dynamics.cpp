@@ -1,7 +1,7 @@
 /**
  *	\file src/dynamics.cpp
  *	\author Mike Timmerman
- *	\version 4.1
+ *	\version 5.0
  *	\date 2022
  */
 
@@ -12,128 +12,415 @@
 // PUBLIC MEMBER FUNCTIONS:
 //
 
-dynamics::dynamics(  ) {}
+template <class Model, class Scalar>
+plantDynamics<Model, Scalar>::plantDynamics(  )
+{
+    model = std::make_shared<const Model>(  );
+    memset( &run, 0, sizeof( run ) );
+}
 
 
-dynamics::dynamics( unsigned int _nx,
-                    unsigned int _nu, 
-                    unsigned int _ny,
-                    VectorXf _initState,
-                    float _samplingTime, 
-                    float _initTime )
+template <class Model, class Scalar>
+plantDynamics<Model, Scalar>::plantDynamics(    unsigned int _nx,
+                                        unsigned int _nu, 
+                                        unsigned int _ny,
+                                        VectorXf _initState,
+                                        float _samplingTime, 
+                                        float _initTime )
 {
+    if ( _nx != Model::NX || _initState.size() != Model::NX )
+        throw std::invalid_argument("Number of states does not match plant model");
+    if ( _nu != Model::NU )
+        throw std::invalid_argument("Number of inputs does not match plant model");
+    if ( _ny != Model::NY )
+        throw std::invalid_argument("Number of outputs does not match plant model");
+
     // Initialize system dynamics properties
     nx = _nx;
     nu = _nu;
     ny = _ny;
 
     initTime = _initTime;
-    time = _initTime;
     samplingTime = _samplingTime;
 
     bias = VectorXf::Zero( _ny );
     noiseLevel = VectorXf::Zero( _ny );
 
-    lastU = VectorXf::Zero( _nu );
+    model = std::make_shared<const Model>(  );
     initState = _initState;
-    state = _initState;
 
-    // Initialize private data members
-    k1 = VectorXf::Zero(nx,1);
-    k2 = VectorXf::Zero(nx,1);
-    k3 = VectorXf::Zero(nx,1);
-    k4 = VectorXf::Zero(nx,1);
-    stateDerivative = VectorXf::Zero(nx,1);
+    // Initialize run state
+    memset( &run, 0, sizeof( run ) );
+    for ( unsigned int i=0; i<nx; i++ )
+        run.state[i] = initState(i);
+    run.time = initTime;
+}
+
+
+template <class Model, class Scalar>
+plantDynamics<Model, Scalar>::plantDynamics( const plantDynamics& rhs )
+{
+    nx = rhs.nx;
+    nu = rhs.nu;
+    ny = rhs.ny;
+
+    initTime = rhs.initTime;
+    samplingTime = rhs.samplingTime;
+
+    bias = rhs.bias;
+    noiseLevel = rhs.noiseLevel;
+    generator = rhs.generator;
+    antithetic = rhs.antithetic;
+
+    model = rhs.model;
+    initState = rhs.initState;
+    run = rhs.run;
+
+    integrator = rhs.integrator;
+    integratorName = rhs.integratorName;
+    integratorEvaluations = rhs.integratorEvaluations;
+}
+
+
+template <class Model, class Scalar>
+template <class Other>
+plantDynamics<Model, Scalar>::plantDynamics( const plantDynamics<Model, Other>& rhs )
+{
+    nx = rhs.nx;
+    nu = rhs.nu;
+    ny = rhs.ny;
+
+    initTime = rhs.initTime;
+    samplingTime = rhs.samplingTime;
+
+    bias = rhs.bias;
+    noiseLevel = rhs.noiseLevel;
+    generator = rhs.generator;
+    antithetic = rhs.antithetic;
+
+    model = rhs.model;
+    initState = rhs.initState;
+    setIntegrator( rhs.integratorName );
+
+    for ( unsigned int i=0; i<Model::NX; i++ )
+        run.state[i] = rhs.run.state[i];
+    for ( unsigned int i=0; i<Model::NU; i++ )
+        run.lastU[i] = rhs.run.lastU[i];
+    run.time = rhs.run.time;
+    run.omega = rhs.run.omega;
 }
 
 
-dynamics::~dynamics(  ) {}
+template <class Model, class Scalar>
+plantDynamics<Model, Scalar>::~plantDynamics(  ) {}
 
 
-void dynamics::step( const VectorXf& _u, VectorXf& _y )
+template <class Model, class Scalar>
+void plantDynamics<Model, Scalar>::step( const VectorX<Scalar>& _u, VectorX<Scalar>& _y )
 {
     /*  Update system state */
     updateState( _u );
 
     /* Update system output */
-    VectorXf tmp( ny ); tmp << state[1], state[3];
+    _y.resize( ny );
 
     for (unsigned int i=0; i<ny; i++)
-    {
-        // Add noise
-        tmp(i) = tmp(i)*(1+ noiseLevel(i)*( rand() % 201 - 100.0) / 100.0);
+        _y(i) = measure( i );
+}
 
-        // Add bais
-        tmp(i) = tmp(i) + bias(i);
-    }
 
-    _y = tmp;
+template <class Model, class Scalar>
+void plantDynamics<Model, Scalar>::integrate( const VectorX<Scalar>& _u )
+{
+    updateState( _u );
+}
+
+
+template <class Model, class Scalar>
+Scalar plantDynamics<Model, Scalar>::measure( unsigned int idx )
+{
+    if ( idx >= ny )
+        throw std::invalid_argument("Invalid index for output signal given");
+
+    // Output map of the model
+    Scalar y[Model::NY];
+    model->outputMap( run.state, y );
+
+    Scalar tmp = y[idx];
+    std::uniform_int_distribution<int> noise( 0, 200 );
+
+    // Add noise
+    int draw = antithetic ? 200 - noise( generator ) : noise( generator );
+    tmp = tmp*(1+ Scalar( noiseLevel(idx) )*( draw - 100 ) / Scalar( 100 ));
+
+    // Add bais
+    tmp = tmp + Scalar( bias(idx) );
+
+    return tmp;
 }
 
 
-void dynamics::setBias( const VectorXf& _bias )
+template <class Model, class Scalar>
+void plantDynamics<Model, Scalar>::setBias( const VectorXf& _bias )
 {
     bias = _bias;
 }
 
 
-void dynamics::setNoise( const VectorXf& _noiseLevel )
+template <class Model, class Scalar>
+void plantDynamics<Model, Scalar>::setNoise( const VectorXf& _noiseLevel )
 {
     noiseLevel = _noiseLevel;
 }
 
+template <class Model, class Scalar>
+void plantDynamics<Model, Scalar>::setBias( unsigned int idx, float _bias )
+{
+    if ( idx >= ny )
+        throw std::invalid_argument("Invalid index for output signal given");
+
+    bias( idx ) = _bias;
+}
+
+template <class Model, class Scalar>
+void plantDynamics<Model, Scalar>::setNoise( unsigned int idx, float _noiseLevel )
+{
+    if ( idx >= ny )
+        throw std::invalid_argument("Invalid index for output signal given");
+
+    noiseLevel( idx ) = _noiseLevel;
+}
+
+template <class Model, class Scalar>
+void plantDynamics<Model, Scalar>::setSeed( unsigned int _seed )
+{
+    generator.seed( _seed );
+}
+
+template <class Model, class Scalar>
+void plantDynamics<Model, Scalar>::setAntithetic( bool _antithetic )
+{
+    antithetic = _antithetic;
+}
+
+
+template <class Model, class Scalar>
+bool plantDynamics<Model, Scalar>::isNoisy(  ) const
+{
+    return noiseLevel.size() > 0 && !noiseLevel.isZero( 0 );
+}
+
+
+template <class Model, class Scalar>
+std::string plantDynamics<Model, Scalar>::getGeneratorState(  ) const
+{
+    std::ostringstream stream;
+    stream << generator;
+    return stream.str();
+}
+
+template <class Model, class Scalar>
+void plantDynamics<Model, Scalar>::setGeneratorState( const std::string& _state )
+{
+    std::istringstream stream( _state );
+    stream >> generator;
+
+    if ( stream.fail() )
+        throw std::invalid_argument("Invalid noise generator state given");
+}
+
+
+template <class Model, class Scalar>
+void plantDynamics<Model, Scalar>::setParameter( const std::string& name, double value )
+{
+    std::shared_ptr<Model> newModel = std::make_shared<Model>( *model );
+    newModel->setParameter( name, value );
+    model = newModel;
+}
+
+
+template <class Model, class Scalar>
+double plantDynamics<Model, Scalar>::getParameter( const std::string& name ) const
+{
+    return model->getParameter( name );
+}
+
 
-void dynamics::resetDynamics( const VectorXf& offsets )
+template <class Model, class Scalar>
+void plantDynamics<Model, Scalar>::setModel( std::shared_ptr<const Model> _model )
+{
+    if ( !_model )
+        throw std::invalid_argument("No plant model given");
+
+    model = _model;
+}
+
+
+template <class Model, class Scalar>
+std::shared_ptr<const Model> plantDynamics<Model, Scalar>::getModel(  ) const
+{
+    return model;
+}
+
+
+template <class Model, class Scalar>
+void plantDynamics<Model, Scalar>::setIntegrator( const std::string& name )
+{
+    if ( name == forwardEuler::NAME )
+        useIntegrator<forwardEuler>();
+    else if ( name == heun::NAME )
+        useIntegrator<heun>();
+    else if ( name == kutta3::NAME )
+        useIntegrator<kutta3>();
+    else if ( name == classicalRungeKutta4::NAME )
+        useIntegrator<classicalRungeKutta4>();
+    else if ( name == dormandPrince5::NAME )
+        useIntegrator<dormandPrince5>();
+    else
+        throw std::invalid_argument("Unknown integration scheme " + name);
+}
+
+
+template <class Model, class Scalar>
+const std::string& plantDynamics<Model, Scalar>::getIntegrator(  ) const
+{
+    return integratorName;
+}
+
+
+template <class Model, class Scalar>
+unsigned int plantDynamics<Model, Scalar>::getIntegratorEvaluations(  ) const
+{
+    return integratorEvaluations;
+}
+
+
+template <class Model, class Scalar>
+void plantDynamics<Model, Scalar>::hashConfiguration( configHash& hash ) const
+{
+    model->hashConfiguration( hash );
+    hash.add( (unsigned int) sizeof( Scalar ) );
+    hash.add( samplingTime );
+
+    hash.add( nx );
+    hash.add( nu );
+    hash.add( ny );
+
+    hash.add( &run, sizeof( run ) );
+
+    hash.add( integratorName );
+    hash.add( bias );
+    hash.add( noiseLevel );
+
+    // Result only depends on generator when noise is active
+    if ( isNoisy() )
+    {
+        hash.add( getGeneratorState() );
+        hash.add( (unsigned int) antithetic );
+    }
+}
+
+
+template <class Model, class Scalar>
+void plantDynamics<Model, Scalar>::resetDynamics( const VectorXf& offsets )
 {   
     for (unsigned int i=0; i<nx; i++)
     {   
-        state(i) = initState(i)*(1+offsets(i));
+        run.state[i] = Scalar( initState(i) )*(1+Scalar( offsets(i) ));
     }
-    time = initTime;
-    lastU = VectorXf::Zero( nu );
+    run.time = initTime;
+    for (unsigned int i=0; i<nu; i++)
+        run.lastU[i] = 0.0;
+    run.omega = 0.0;
 }
 
 
+template <class Model, class Scalar>
+VectorX<Scalar> plantDynamics<Model, Scalar>::getState(  ) const
+{
+    return Map<const VectorX<Scalar> >( run.state, nx );
+}
 
-//
-// PRIVATE MEMBER FUNCTIONS:
-//
 
-void dynamics::updateState( const VectorXf& _u )
-{   
-    omega = (_u(0)-lastU(0))/(samplingTime*0.01);
-    lastU = _u;
+template <class Model, class Scalar>
+VectorX<Scalar> plantDynamics<Model, Scalar>::getOutput(  ) const
+{
+    VectorX<Scalar> y( ny );
+    model->outputMap( run.state, y.data() );
+    return y;
+}
+
 
-    // Evaluation at start of interval
-    k1 = rocketDynamics(time, state, _u);
+template <class Model, class Scalar>
+Scalar plantDynamics<Model, Scalar>::getTime(  ) const
+{
+    return run.time;
+}
 
-    // Evaluation at midway of interval
-    k2 = rocketDynamics(time + 1/2*samplingTime, state + samplingTime*k1/2.0, _u);
 
-    k3 = rocketDynamics(time + 1/2*samplingTime, state + samplingTime*k2/2.0, _u);
+template <class Model, class Scalar>
+Scalar plantDynamics<Model, Scalar>::getOmega(  ) const
+{
+    return run.omega;
+}
 
-    // Evaluation at end of interval
-    k4 = rocketDynamics(time + samplingTime, state + samplingTime*k3, _u);
 
-    // Update system dynamics properties   
-    state = state + samplingTime*(k1 + 2.0*k2 + 2.0*k3 + k4)/6.0;
-    time = time + samplingTime;
+template <class Model, class Scalar>
+const runState<Model, Scalar>& plantDynamics<Model, Scalar>::getRunState(  ) const
+{
+    return run;
 }
 
 
-VectorXf dynamics::rocketDynamics( float _t, VectorXf _state, const VectorXf& _u )
+template <class Model, class Scalar>
+void plantDynamics<Model, Scalar>::setRunState( const runState<Model, Scalar>& _run )
 {
-    float xbr = _u(0);
+    memcpy( &run, &_run, sizeof( run ) );
+}
 
-    density = density_sea * exp(-_state[1] / 8000.0);
-    V = sqrt(pow(_state[2], 2) + pow(_state[3], 2));
-    M = V/sqrt(1.4*287*278);
-    Cd_val = p00 + p10*xbr + p01*M + p20*xbr*xbr + p11*M*xbr + p02*M*M + p21*xbr*xbr*M + p12*xbr*M*M + p03*M*M*M;
 
-    stateDerivative[0] = _state[2];               // x_dot = Vx
-    stateDerivative[1] = _state[3];               // y_dot = Vy
-    stateDerivative[2] = - 1.0/2.0 * density * A * Cd_val * V * _state[2] / mass;  // Vx_dot
-    stateDerivative[3] = -g - 1.0/2.0 * density * A * Cd_val * V * _state[3] / mass;  // Vy_dot
 
-    return stateDerivative;
+//
+// PRIVATE MEMBER FUNCTIONS:
+//
+
+template <class Model, class Scalar>
+void plantDynamics<Model, Scalar>::updateState( const VectorX<Scalar>& _u )
+{   
+    Scalar u[Model::NU], h = samplingTime;
+    for ( unsigned int i=0; i<Model::NU; i++ )
+        u[i] = _u(i);
+
+    run.omega = (u[0]-run.lastU[0])/(h*Scalar( 0.01 ));
+    for ( unsigned int i=0; i<Model::NU; i++ )
+        run.lastU[i] = u[i];
+
+    // Unrolled step of the selected scheme, model equations inlined
+    integrator( *model, run.time, h, run.state, u );
+    run.time = run.time + h;
 }
+
+
+template <class Model, class Scalar>
+template <class Tableau>
+void plantDynamics<Model, Scalar>::useIntegrator(  )
+{
+    integrator = &explicitRungeKutta<Tableau, Model, Scalar>;
+    integratorName = Tableau::NAME;
+    integratorEvaluations = butcherEvaluations<Tableau>();
+}
+
+
+//
+// EXPLICIT INSTANTIATIONS:
+//
+
+template class plantDynamics<rocketModel, float>;
+template class plantDynamics<rocketModel, double>;
+template class plantDynamics<poweredAscentModel, float>;
+template class plantDynamics<poweredAscentModel, double>;
+
+template plantDynamics<rocketModel, float>::plantDynamics( const plantDynamics<rocketModel, double>& );
+template plantDynamics<rocketModel, double>::plantDynamics( const plantDynamics<rocketModel, float>& );
+template plantDynamics<poweredAscentModel, float>::plantDynamics( const plantDynamics<poweredAscentModel, double>& );
+template plantDynamics<poweredAscentModel, double>::plantDynamics( const plantDynamics<poweredAscentModel, float>& );
@@ -7,6 +7,11 @@
 
 #include "../header.h"    // #include header
 
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 
 
 MatrixXf loadFromFile(string FileName, int row, int col)
@@ -26,6 +31,34 @@ MatrixXf loadFromFile(string FileName, int row, int col)
 }
 
 
+MatrixXf loadFromFile(string FileName)
+{
+    if (trajectoryCodec::isTrajectory(FileName)) {
+        trajectoryCodec codec;
+        codec.open(FileName);
+        return codec.read();
+    }
+
+    ifstream File(FileName);
+    if (!File.is_open())
+        throw std::invalid_argument("Unable to open file " + FileName);
+
+    // Determine grid dimensions
+    int row = 0, col = 0;
+    string line;
+    while (getline(File, line)) {
+        if (line.empty())
+            continue;
+        if (row == 0)
+            col = count(line.begin(), line.end(), ',') + 1;
+        row++;
+    }
+    File.close();
+
+    return loadFromFile(FileName, row, col);
+}
+
+
 void saveToFile(MatrixXf &data, int rows, int cols, string FileName)
 {
     ofstream File; File.open(FileName);
@@ -39,4 +72,43 @@ void saveToFile(MatrixXf &data, int rows, int cols, string FileName)
         File << line << "\n";
     }
     File.close();
-}
\ No newline at end of file
+}
+
+
+void parallelFor(unsigned int n, unsigned int nThreads, const std::function<void(unsigned int)>& fn, const string& item)
+{
+    if ( nThreads == 0 )
+        nThreads = std::max( 1u, std::thread::hardware_concurrency() );
+    nThreads = std::min( nThreads, std::max( 1u, n ) );
+
+    std::atomic<unsigned int> next( 0 );
+    std::mutex errorMutex;
+    std::string firstError;
+    std::vector<std::thread> pool;
+
+    for ( unsigned int t=0; t<nThreads; ++t )
+    {
+        pool.push_back( std::thread( [&]()
+        {
+            unsigned int k;
+            while ( ( k = next++ ) < n )
+            {
+                try
+                {
+                    fn( k );
+                }
+                catch ( const std::exception& e )
+                {
+                    std::lock_guard<std::mutex> lock( errorMutex );
+                    if ( firstError.empty() )
+                        firstError = item + " " + std::to_string( k ) + ": " + e.what();
+                }
+            }
+        } ) );
+    }
+    for ( unsigned int t=0; t<pool.size(); ++t )
+        pool[t].join();
+
+    if ( !firstError.empty() )
+        throw std::runtime_error( firstError );
+}
@@ -0,0 +1,423 @@
+/**
+ *	\file src/identification.cpp
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#include "../header.h"    // #include header
+
+
+/** Central difference step for a variable of the given magnitude
+ */
+static double differenceStep( double value )
+{
+    return 1e-6*std::max( 1.0, std::abs( value ) );
+}
+
+
+//
+// PUBLIC MEMBER FUNCTIONS:
+//
+
+template <class Model>
+parameterIdentification<Model>::parameterIdentification( std::shared_ptr<const Model> _model, const std::string& _integrator )
+{
+    if ( !_model )
+        throw std::invalid_argument("No plant model given");
+
+    model = _model;
+    weights = VectorXd::Ones( Model::NY );
+
+    if ( _integrator == forwardEuler::NAME )
+        useScheme<forwardEuler>();
+    else if ( _integrator == heun::NAME )
+        useScheme<heun>();
+    else if ( _integrator == kutta3::NAME )
+        useScheme<kutta3>();
+    else if ( _integrator == classicalRungeKutta4::NAME )
+        useScheme<classicalRungeKutta4>();
+    else if ( _integrator == dormandPrince5::NAME )
+        useScheme<dormandPrince5>();
+    else
+        throw std::invalid_argument("Unknown integration scheme " + _integrator);
+}
+
+
+template <class Model>
+parameterIdentification<Model>::~parameterIdentification(  ){}
+
+
+template <class Model>
+void parameterIdentification<Model>::addLog( const VectorXd& initState, double initTime, double samplingTime,
+                                             const MatrixXd& outputs, const MatrixXd& inputs )
+{
+    if ( initState.size() != Model::NX || outputs.rows() != Model::NY || inputs.rows() != Model::NU )
+        throw std::invalid_argument("Incorrect dimensions of flight log given");
+    if ( outputs.cols() != inputs.cols() || outputs.cols() < 2 )
+        throw std::invalid_argument("Flight log needs outputs and inputs of at least two samples");
+    if ( samplingTime <= 0.0 )
+        throw std::invalid_argument("Sampling time must be positive");
+
+    logs.push_back( { initState, initTime, samplingTime, outputs, inputs } );
+}
+
+
+template <class Model>
+void parameterIdentification<Model>::addLogFromFiles( const std::string& prefix, double initTime, double samplingTime,
+                                                      const std::string& extension )
+{
+    MatrixXf states = loadFromFile( prefix + "state" + extension );
+    MatrixXf outputs = loadFromFile( prefix + "output" + extension );
+    MatrixXf inputs = loadFromFile( prefix + "input" + extension );
+
+    if ( states.rows() < Model::NX || states.cols() == 0 )
+        throw std::runtime_error("State file " + prefix + "state" + extension + " does not match model");
+
+    addLog( states.col(0).head( Model::NX ).template cast<double>(), initTime, samplingTime,
+            outputs.cast<double>(), inputs.cast<double>() );
+}
+
+
+template <class Model>
+unsigned int parameterIdentification<Model>::getNumLogs(  ) const
+{
+    return logs.size();
+}
+
+
+template <class Model>
+void parameterIdentification<Model>::setOutputWeights( const VectorXd& _weights )
+{
+    if ( _weights.size() != Model::NY || _weights.minCoeff() <= 0.0 )
+        throw std::invalid_argument("Invalid output weights given");
+
+    weights = _weights;
+}
+
+
+template <class Model>
+VectorXd parameterIdentification<Model>::fit( const std::vector<std::string>& names, unsigned int maxIterations, unsigned int nThreads )
+{
+    unsigned int np = names.size();
+    if ( np == 0 )
+        throw std::invalid_argument("No parameters to fit given");
+    if ( logs.empty() )
+        throw std::runtime_error("No flight logs added");
+
+    VectorXd values( np );
+    for ( unsigned int i=0; i<np; ++i )
+        values(i) = model->getParameter( names[i] );
+
+    MatrixXd JtJ, trialJtJ;
+    VectorXd Jtr, trialJtr;
+    unsigned int nResiduals;
+    double cost = evaluate( createModels( names, values ), true, nThreads, JtJ, Jtr, nResiduals );
+    logger::info( "Identification: ", logs.size(), " logs, ", nResiduals, " residuals, initial RMS ",
+                  sqrt( 2.0*cost/nResiduals ) );
+
+    double lambda = 1e-3;
+    unsigned int iteration = 0;
+    while ( iteration < maxIterations )
+    {
+        // Damping scaled by the curvature of every parameter (units drop out)
+        VectorXd scale = JtJ.diagonal().cwiseMax( 1e-12*JtJ.diagonal().maxCoeff() ).cwiseMax( 1e-300 );
+
+        bool accepted = false;
+        double trialCost = cost;
+        VectorXd step;
+        while ( !accepted && lambda < 1e12 )
+        {
+            MatrixXd damped = JtJ;
+            damped.diagonal() += lambda*scale;
+            step = damped.ldlt().solve( -Jtr );
+
+            trialCost = evaluate( createModels( names, values + step ), true, nThreads, trialJtJ, trialJtr, nResiduals );
+            accepted = std::isfinite( trialCost ) && trialCost < cost;
+
+            if ( accepted )
+                lambda = std::max( lambda/10.0, 1e-12 );
+            else
+                lambda *= 10.0;
+        }
+        if ( !accepted )
+            break;
+
+        double decrease = ( cost - trialCost )/cost;
+        iteration++;
+        values += step;
+        cost = trialCost;
+        JtJ.swap( trialJtJ );
+        Jtr.swap( trialJtr );
+
+        logger::debug( "Iteration: ", iteration, " RMS: ", sqrt( 2.0*cost/nResiduals ), " lambda: ", lambda );
+
+        if ( decrease < 1e-10 || step.cwiseAbs().cwiseQuotient( values.cwiseAbs().cwiseMax( 1e-12 ) ).maxCoeff() < 1e-9 )
+            break;
+    }
+
+    // Standard errors from the Gauss-Newton covariance, rank decided on the correlation matrix
+    residual = sqrt( 2.0*cost/nResiduals );
+    double variance = 2.0*cost/std::max<int>( 1, (int) nResiduals - (int) np );
+    VectorXd scale = JtJ.diagonal().cwiseSqrt();
+    FullPivLU<MatrixXd> lu( scale.cwiseInverse().asDiagonal()*JtJ*scale.cwiseInverse().asDiagonal() );
+    lu.setThreshold( 1e-10 );
+    if ( !scale.allFinite() || scale.minCoeff() <= 0.0 || lu.rank() < (int) np )
+    {
+        logger::warning( "Identification: parameters are not independent, standard errors undefined" );
+        standardErrors = VectorXd::Constant( np, INFINITY );
+    }
+    else
+        standardErrors = ( variance*lu.inverse().diagonal() ).cwiseSqrt().cwiseQuotient( scale );
+
+    std::shared_ptr<Model> fitted = std::make_shared<Model>( *model );
+    for ( unsigned int i=0; i<np; ++i )
+    {
+        fitted->setParameter( names[i], values(i) );
+        logger::info( names[i], ": ", values(i), " +/- ", standardErrors(i) );
+    }
+    model = fitted;
+
+    logger::info( "Identification: RMS ", residual, " after ", iteration, " iterations" );
+    return values;
+}
+
+
+template <class Model>
+const VectorXd& parameterIdentification<Model>::getStandardErrors(  ) const
+{
+    return standardErrors;
+}
+
+
+template <class Model>
+double parameterIdentification<Model>::getResidual(  ) const
+{
+    return residual;
+}
+
+
+template <class Model>
+std::shared_ptr<const Model> parameterIdentification<Model>::getModel(  ) const
+{
+    return model;
+}
+
+
+
+//
+// PRIVATE MEMBER FUNCTIONS:
+//
+
+template <class Model>
+typename parameterIdentification<Model>::fitModels parameterIdentification<Model>::createModels( const std::vector<std::string>& names,
+                                                                                                const VectorXd& values ) const
+{
+    fitModels models = { *model, {}, {}, VectorXd( names.size() ) };
+    for ( unsigned int i=0; i<names.size(); ++i )
+        models.nominal.setParameter( names[i], values(i) );
+
+    for ( unsigned int i=0; i<names.size(); ++i )
+    {
+        models.steps(i) = differenceStep( values(i) );
+        models.plus.push_back( models.nominal );
+        models.minus.push_back( models.nominal );
+        models.plus[i].setParameter( names[i], values(i) + models.steps(i) );
+        models.minus[i].setParameter( names[i], values(i) - models.steps(i) );
+    }
+    return models;
+}
+
+
+template <class Model>
+double parameterIdentification<Model>::evaluate( const fitModels& models, bool jacobian, unsigned int nThreads,
+                                                 MatrixXd& JtJ, VectorXd& Jtr, unsigned int& nResiduals ) const
+{
+    unsigned int np = models.steps.size();
+    std::vector<double> costs( logs.size() );
+    std::vector<unsigned int> counts( logs.size() );
+    std::vector<MatrixXd> logJtJ( logs.size() );
+    std::vector<VectorXd> logJtr( logs.size() );
+
+    // Logs are replayed in parallel, the models are shared (read only)
+    parallelFor( logs.size(), nThreads, [&]( unsigned int l )
+    {
+        VectorXd residuals;
+        MatrixXd J;
+        replay( models, logs[l], jacobian, residuals, J );
+        costs[l] = 0.5*residuals.squaredNorm();
+        counts[l] = ( !logs[l].outputs.rightCols( logs[l].outputs.cols() - 1 ).array().isNaN() ).count();
+        if ( jacobian )
+        {
+            logJtJ[l] = J.transpose()*J;
+            logJtr[l] = J.transpose()*residuals;
+        }
+    }, "Log" );
+
+    // Sum in log order
+    double cost = 0.0;
+    nResiduals = 0;
+    JtJ = MatrixXd::Zero( np, np );
+    Jtr = VectorXd::Zero( np );
+    for ( unsigned int l=0; l<logs.size(); ++l )
+    {
+        cost += costs[l];
+        nResiduals += counts[l];
+        if ( jacobian )
+        {
+            JtJ += logJtJ[l];
+            Jtr += logJtr[l];
+        }
+    }
+    return cost;
+}
+
+
+template <class Model>
+void parameterIdentification<Model>::replay( const fitModels& models, const flightLog& log, bool jacobian,
+                                             VectorXd& residuals, MatrixXd& J ) const
+{
+    const unsigned int NX = Model::NX, NU = Model::NU, NY = Model::NY;
+    unsigned int np = jacobian ? models.steps.size() : 0;
+    unsigned int N = log.outputs.cols() - 1;
+
+    // State in column 0, sensitivity to parameter i in column i+1
+    MatrixXd Z = MatrixXd::Zero( NX, 1 + np );
+    Z.col(0) = log.initState;
+    std::vector<MatrixXd> k( stages, MatrixXd( NX, 1 + np ) );
+    MatrixXd tmp( NX, 1 + np );
+
+    residuals.resize( NY*N );
+    J.resize( NY*N, np );
+
+    double u[NU], x[NX], y[NY], yPlus[NY], yMinus[NY];
+    MatrixXd C( NY, NX );
+    double t = log.initTime;
+
+    for ( unsigned int s=0; s<N; ++s )
+    {
+        for ( unsigned int i=0; i<NU; ++i )
+            u[i] = log.inputs( i, s+1 );
+
+        (this->*stepper)( models, t, log.samplingTime, u, Z, k, tmp );
+        t += log.samplingTime;
+
+        for ( unsigned int i=0; i<NX; ++i )
+            x[i] = Z( i, 0 );
+        models.nominal.outputMap( x, y );
+
+        // Output sensitivities dy/dp = dh/dx S
+        if ( jacobian )
+        {
+            for ( unsigned int j=0; j<NX; ++j )
+            {
+                double d = differenceStep( x[j] );
+                x[j] += d;      models.nominal.outputMap( x, yPlus );
+                x[j] -= 2.0*d;  models.nominal.outputMap( x, yMinus );
+                x[j] += d;
+                for ( unsigned int i=0; i<NY; ++i )
+                    C(i,j) = ( yPlus[i] - yMinus[i] )/( 2.0*d );
+            }
+            J.middleRows( NY*s, NY ) = weights.asDiagonal()*C*Z.rightCols( np );
+        }
+
+        for ( unsigned int i=0; i<NY; ++i )
+        {
+            // Missing measurement: no residual
+            if ( std::isnan( log.outputs( i, s+1 ) ) )
+            {
+                residuals( NY*s + i ) = 0.0;
+                J.row( NY*s + i ).setZero();
+            }
+            else
+                residuals( NY*s + i ) = weights(i)*( y[i] - log.outputs( i, s+1 ) );
+        }
+
+        if ( !Z.col(0).allFinite() )
+            throw std::runtime_error("Replay diverged at time " + std::to_string( t ));
+    }
+}
+
+
+template <class Model>
+void parameterIdentification<Model>::augmentedRhs( const fitModels& models, double t, const MatrixXd& Z, const double* u, MatrixXd& dZ ) const
+{
+    const unsigned int NX = Model::NX;
+    unsigned int np = Z.cols() - 1;
+
+    double x[NX], f[NX], fPlus[NX], fMinus[NX];
+    for ( unsigned int i=0; i<NX; ++i )
+        x[i] = Z( i, 0 );
+
+    models.nominal.rhs( t, x, u, f );
+    for ( unsigned int i=0; i<NX; ++i )
+        dZ( i, 0 ) = f[i];
+    if ( np == 0 )
+        return;
+
+    // df/dp, then df/dx S column by column of df/dx
+    for ( unsigned int p=0; p<np; ++p )
+    {
+        models.plus[p].rhs( t, x, u, fPlus );
+        models.minus[p].rhs( t, x, u, fMinus );
+        for ( unsigned int i=0; i<NX; ++i )
+            dZ( i, p+1 ) = ( fPlus[i] - fMinus[i] )/( 2.0*models.steps(p) );
+    }
+
+    for ( unsigned int j=0; j<NX; ++j )
+    {
+        double d = differenceStep( x[j] );
+        x[j] += d;      models.nominal.rhs( t, x, u, fPlus );
+        x[j] -= 2.0*d;  models.nominal.rhs( t, x, u, fMinus );
+        x[j] += d;
+
+        for ( unsigned int i=0; i<NX; ++i )
+        {
+            double dfdx = ( fPlus[i] - fMinus[i] )/( 2.0*d );
+            if ( dfdx != 0.0 )
+                dZ.row(i).tail( np ) += dfdx*Z.row(j).tail( np );
+        }
+    }
+}
+
+
+template <class Model>
+template <class Tableau>
+void parameterIdentification<Model>::useScheme(  )
+{
+    stepper = &parameterIdentification::augmentedStep<Tableau>;
+    stages = Tableau::STAGES;
+}
+
+
+template <class Model>
+template <class Tableau>
+void parameterIdentification<Model>::augmentedStep( const fitModels& models, double t, double h, const double* u, MatrixXd& Z,
+                                                    std::vector<MatrixXd>& k, MatrixXd& tmp ) const
+{
+    // Stages that do not contribute to the solution are skipped, as in explicitRungeKutta
+    for ( unsigned int i=0; i<Tableau::STAGES; ++i )
+    {
+        if ( !butcherStageUsed<Tableau>( i ) )
+            continue;
+
+        tmp = Z;
+        for ( unsigned int j=0; j<i; ++j )
+            if ( Tableau::a[i][j] != 0.0 )
+                tmp += ( h*Tableau::a[i][j] )*k[j];
+        augmentedRhs( models, t + Tableau::c[i]*h, tmp, u, k[i] );
+    }
+
+    for ( unsigned int j=0; j<Tableau::STAGES; ++j )
+        if ( Tableau::b[j] != 0.0 )
+            Z += ( h*Tableau::b[j] )*k[j];
+}
+
+
+
+//
+// EXPLICIT INSTANTIATIONS:
+//
+
+template class parameterIdentification<rocketModel>;
+template class parameterIdentification<poweredAscentModel>;
@@ -0,0 +1,186 @@
+/**
+ *	\file src/journal.cpp
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#include "../header.h"    // #include header
+
+#include <cstdio>
+#include <cinttypes>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+
+/** Flush file to disk so that it survives a crash or preemption
+ */
+static void syncFile( FILE* file )
+{
+    fflush( file );
+#ifdef _WIN32
+    _commit( _fileno( file ) );
+#else
+    fsync( fileno( file ) );
+#endif
+}
+
+
+//
+// PUBLIC MEMBER FUNCTIONS:
+//
+
+journal::journal(  )
+{
+    nRecords = 0;
+    campaign = 0;
+}
+
+
+journal::journal( std::string _fileName )
+{
+    fileName = _fileName;
+    checkpointName = _fileName + ".chk";
+    nRecords = 0;
+    campaign = 0;
+}
+
+
+journal::~journal(  ){}
+
+
+unsigned int journal::resume( uint64_t _campaign, MatrixXf& records, std::vector<std::string>& rngState )
+{
+    records.resize( 0, 0 );
+    rngState.clear();
+    nRecords = 0;
+    campaign = _campaign;
+
+    // Read checkpoint, no checkpoint means a fresh campaign
+    ifstream checkpoint( checkpointName );
+    string line;
+
+    if ( !checkpoint.is_open() || !getline( checkpoint, line ) )
+    {
+        FILE* file = fopen( fileName.c_str(), "w" );
+        if ( file == NULL )
+            throw std::runtime_error("Unable to create journal file " + fileName);
+        fclose( file );
+        return 0;
+    }
+
+    // Header: campaign hash and number of completed points
+    uint64_t checkpointCampaign = 0;
+    unsigned int nCheckpoint = 0;
+    std::istringstream header( line );
+    if ( !( header >> std::hex >> checkpointCampaign >> std::dec >> nCheckpoint ) || checkpointCampaign != campaign )
+        throw std::runtime_error("Journal " + fileName + " belongs to a different campaign (remove it and its checkpoint to start afresh)");
+
+    while ( getline( checkpoint, line ) )
+        rngState.push_back( line );
+    checkpoint.close();
+
+    // Read journal records up to the checkpoint
+    ifstream File( fileName );
+    std::vector<string> lines;
+    while ( lines.size() < nCheckpoint && getline( File, line ) )
+        lines.push_back( line );
+    File.close();
+
+    if ( lines.size() < nCheckpoint )
+        throw std::runtime_error("Journal " + fileName + " is shorter than its checkpoint");
+
+    for ( unsigned int k=0; k<lines.size(); ++k )
+    {
+        std::vector<float> values;
+        string entry;
+        std::istringstream stream( lines[k] );
+        while ( getline( stream, entry, ',' ) )
+            values.push_back( stof( entry ) );
+
+        if ( k == 0 )
+            records.resize( nCheckpoint, values.size() );
+        if ( (Index) values.size() != records.cols() )
+            throw std::runtime_error("Inconsistent record length in journal " + fileName);
+
+        for ( unsigned int j=0; j<values.size(); ++j )
+            records(k,j) = values[j];
+    }
+
+    // Discard records written after the last checkpoint
+    string tmpName = fileName + ".tmp";
+    FILE* file = fopen( tmpName.c_str(), "w" );
+    if ( file == NULL )
+        throw std::runtime_error("Unable to write journal file " + fileName);
+    for ( unsigned int k=0; k<lines.size(); ++k )
+        fprintf( file, "%s\n", lines[k].c_str() );
+    syncFile( file );
+    fclose( file );
+
+#ifdef _WIN32
+    std::remove( fileName.c_str() );
+#endif
+    std::rename( tmpName.c_str(), fileName.c_str() );
+
+    nRecords = nCheckpoint;
+    return nRecords;
+}
+
+
+void journal::append( const VectorXf& record, const std::vector<std::string>& rngState )
+{
+    // Nine significant digits restore every float exactly on resume
+    string line = "";
+    char value[32];
+    for ( unsigned int j=0; j<record.size(); ++j )
+    {
+        snprintf( value, sizeof( value ), "%.9g,", record(j) );
+        line.append( value );
+    }
+    line.pop_back();
+
+    FILE* file = fopen( fileName.c_str(), "a" );
+    if ( file == NULL )
+        throw std::runtime_error("Unable to append to journal file " + fileName);
+    fprintf( file, "%s\n", line.c_str() );
+    syncFile( file );
+    fclose( file );
+
+    nRecords++;
+    writeCheckpoint( rngState );
+}
+
+
+bool journal::isActive(  ) const
+{
+    return !fileName.empty();
+}
+
+
+
+//
+// PRIVATE MEMBER FUNCTIONS:
+//
+
+void journal::writeCheckpoint( const std::vector<std::string>& rngState )
+{
+    string tmpName = checkpointName + ".tmp";
+
+    FILE* file = fopen( tmpName.c_str(), "w" );
+    if ( file == NULL )
+        throw std::runtime_error("Unable to write checkpoint file " + checkpointName);
+
+    fprintf( file, "%016" PRIx64 " %u\n", campaign, nRecords );
+    for ( unsigned int i=0; i<rngState.size(); ++i )
+        fprintf( file, "%s\n", rngState[i].c_str() );
+    syncFile( file );
+    fclose( file );
+
+#ifdef _WIN32
+    std::remove( checkpointName.c_str() );
+#endif
+    std::rename( tmpName.c_str(), checkpointName.c_str() );
+}
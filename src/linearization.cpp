@@ -0,0 +1,343 @@
+/**
+ *	\file src/linearization.cpp
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#include "../header.h"    // #include header
+
+
+/** Central difference step for a variable of the given magnitude
+ */
+static double differenceStep( double value )
+{
+    return 1e-6*std::max( 1.0, std::abs( value ) );
+}
+
+
+//
+// PUBLIC MEMBER FUNCTIONS:
+//
+
+template <class Model>
+linearAnalysis<Model>::linearAnalysis( std::shared_ptr<const Model> _model, double _samplingTime, const std::string& _integrator,
+                                       unsigned int _nFrequencies )
+{
+    if ( Model::NU != 1 )
+        throw std::invalid_argument("Linear analysis requires a single control input");
+    if ( _samplingTime <= 0.0 || _nFrequencies < 2 )
+        throw std::invalid_argument("Invalid sampling time or number of frequencies given");
+
+    model = _model;
+    samplingTime = _samplingTime;
+
+    if ( _integrator == forwardEuler::NAME )
+        useScheme<forwardEuler>();
+    else if ( _integrator == heun::NAME )
+        useScheme<heun>();
+    else if ( _integrator == kutta3::NAME )
+        useScheme<kutta3>();
+    else if ( _integrator == classicalRungeKutta4::NAME )
+        useScheme<classicalRungeKutta4>();
+    else if ( _integrator == dormandPrince5::NAME )
+        useScheme<dormandPrince5>();
+    else
+        throw std::invalid_argument("Unknown integration scheme " + _integrator);
+
+    // Three decades up to the Nyquist frequency
+    double nyquist = M_PI/samplingTime;
+    frequencies.resize( _nFrequencies );
+    for ( unsigned int k=0; k<_nFrequencies; ++k )
+        frequencies(k) = nyquist*pow( 10.0, -3.0 + 3.0*k/( _nFrequencies - 1 ) );
+}
+
+
+template <class Model>
+linearAnalysis<Model>::~linearAnalysis(  ){}
+
+
+template <class Model>
+void linearAnalysis<Model>::addOperatingPoint( double time, const VectorXd& state, const VectorXd& input )
+{
+    const unsigned int NX = Model::NX, NU = Model::NU, NY = Model::NY;
+    if ( state.size() != NX || input.size() != NU )
+        throw std::invalid_argument("Incorrect dimensions of operating point given");
+
+    operatingPoint p;
+    p.time = time;
+    p.A.resize( NX, NX ); p.B.resize( NX, NU ); p.C.resize( NY, NX );
+    MatrixXd Ad( NX, NX ), Bd( NX, NU );
+
+    double x[NX], u[NU], fPlus[NX], fMinus[NX], yPlus[NY], yMinus[NY];
+    for ( unsigned int i=0; i<NX; ++i ) x[i] = state(i);
+    for ( unsigned int i=0; i<NU; ++i ) u[i] = input(i);
+
+    // Equations of motion, output map and integration step, perturbed in every state
+    for ( unsigned int j=0; j<NX; ++j )
+    {
+        double d = differenceStep( x[j] ), nominal = x[j];
+
+        x[j] = nominal + d;
+        model->rhs( time, x, u, fPlus );
+        model->outputMap( x, yPlus );
+        x[j] = nominal - d;
+        model->rhs( time, x, u, fMinus );
+        model->outputMap( x, yMinus );
+        x[j] = nominal;
+
+        for ( unsigned int i=0; i<NX; ++i )
+            p.A(i,j) = ( fPlus[i] - fMinus[i] )/( 2*d );
+        for ( unsigned int i=0; i<NY; ++i )
+            p.C(i,j) = ( yPlus[i] - yMinus[i] )/( 2*d );
+
+        std::copy( x, x+NX, fPlus );
+        fPlus[j] += d;
+        stepper( *model, time, samplingTime, fPlus, u );
+        std::copy( x, x+NX, fMinus );
+        fMinus[j] -= d;
+        stepper( *model, time, samplingTime, fMinus, u );
+        for ( unsigned int i=0; i<NX; ++i )
+            Ad(i,j) = ( fPlus[i] - fMinus[i] )/( 2*d );
+    }
+
+    // ... and in every input (held over the step)
+    for ( unsigned int j=0; j<NU; ++j )
+    {
+        double d = differenceStep( u[j] ), nominal = u[j];
+
+        u[j] = nominal + d;
+        model->rhs( time, x, u, fPlus );
+        u[j] = nominal - d;
+        model->rhs( time, x, u, fMinus );
+        for ( unsigned int i=0; i<NX; ++i )
+            p.B(i,j) = ( fPlus[i] - fMinus[i] )/( 2*d );
+
+        u[j] = nominal + d;
+        std::copy( x, x+NX, fPlus );
+        stepper( *model, time, samplingTime, fPlus, u );
+        u[j] = nominal - d;
+        std::copy( x, x+NX, fMinus );
+        stepper( *model, time, samplingTime, fMinus, u );
+        u[j] = nominal;
+        for ( unsigned int i=0; i<NX; ++i )
+            Bd(i,j) = ( fPlus[i] - fMinus[i] )/( 2*d );
+    }
+
+    // Observable modes: row space of the observability matrix (feedback cannot move the others)
+    MatrixXd observability( NY*NX, NX );
+    MatrixXd CA = p.C;
+    for ( unsigned int k=0; k<NX; ++k, CA = CA*Ad )
+        observability.middleRows( k*NY, NY ) = CA;
+
+    JacobiSVD<MatrixXd> svd( observability, ComputeFullV );
+    unsigned int rank = 0;
+    while ( rank < NX && svd.singularValues()( rank ) > 1e-9*svd.singularValues()(0) )
+        rank++;
+
+    MatrixXd V = svd.matrixV().leftCols( rank );
+    p.Ad = V.transpose()*Ad*V;
+    p.Bd = V.transpose()*Bd;
+    p.Cd = p.C*V;
+
+    // Plant response and PID terms per unit gain on the unit circle, z = exp( j w h )
+    unsigned int nFrequencies = frequencies.size();
+    p.response.resize( 3*NY, nFrequencies );
+    MatrixXcd identity = MatrixXcd::Identity( rank, rank );
+    MatrixXcd Ac = p.Ad, Bc = p.Bd, Cc = p.Cd;
+
+    for ( unsigned int k=0; k<nFrequencies; ++k )
+    {
+        std::complex<double> z = std::exp( std::complex<double>( 0.0, frequencies(k)*samplingTime ) );
+        VectorXcd plant = Cc*( z*identity - Ac ).partialPivLu().solve( Bc );
+
+        std::complex<double> integral = samplingTime*z/( z - 1.0 );         // I_k = I_k-1 + h e_k
+        std::complex<double> difference = ( z - 1.0 )/( samplingTime*z );   // ( e_k - e_k-1 )/h
+        p.response.col(k) << plant, integral*plant, difference*plant;
+    }
+
+    points.push_back( p );
+}
+
+
+template <class Model>
+unsigned int linearAnalysis<Model>::getNumOperatingPoints(  ) const
+{
+    return points.size();
+}
+
+
+template <class Model>
+void linearAnalysis<Model>::getJacobians( unsigned int k, MatrixXd& A, MatrixXd& B, MatrixXd& C ) const
+{
+    if ( k >= points.size() )
+        throw std::invalid_argument("Invalid operating point given");
+
+    A = points[k].A;
+    B = points[k].B;
+    C = points[k].C;
+}
+
+
+template <class Model>
+MatrixXd linearAnalysis<Model>::closedLoopMatrix( unsigned int k, const VectorXd& gains ) const
+{
+    const unsigned int NY = Model::NY;
+    if ( k >= points.size() )
+        throw std::invalid_argument("Invalid operating point given");
+    if ( gains.size() != 3*NY )
+        throw std::invalid_argument("Incorrect number of gains given");
+
+    const operatingPoint& p = points[k];
+    double h = samplingTime;
+    unsigned int n = p.Ad.rows();
+
+    // Integrator states only for outputs with an integral gain, previous errors only with a derivative gain
+    std::vector<unsigned int> integrators, differences;
+    for ( unsigned int i=0; i<NY; ++i )
+    {
+        if ( gains(NY+i) != 0.0 ) integrators.push_back( i );
+        if ( gains(2*NY+i) != 0.0 ) differences.push_back( i );
+    }
+    unsigned int nI = integrators.size(), nD = differences.size();
+
+    // Control law u = F z on the closed-loop state z = [ x; I_k-1; e_k-1 ], with e_k = -C x
+    RowVectorXd F = RowVectorXd::Zero( n + nI + nD );
+    for ( unsigned int i=0; i<NY; ++i )
+        F.head( n ) -= ( gains(i) + h*gains(NY+i) + gains(2*NY+i)/h )*p.Cd.row(i);
+    for ( unsigned int j=0; j<nI; ++j )
+        F( n+j ) = gains( NY + integrators[j] );
+    for ( unsigned int j=0; j<nD; ++j )
+        F( n+nI+j ) = -gains( 2*NY + differences[j] )/h;
+
+    MatrixXd Acl = MatrixXd::Zero( n + nI + nD, n + nI + nD );
+    Acl.topRows( n ) = p.Bd.col(0)*F;
+    Acl.topLeftCorner( n, n ) += p.Ad;
+    for ( unsigned int j=0; j<nI; ++j )
+    {
+        Acl.block( n+j, 0, 1, n ) = -h*p.Cd.row( integrators[j] );
+        Acl( n+j, n+j ) = 1.0;
+    }
+    for ( unsigned int j=0; j<nD; ++j )
+        Acl.block( n+nI+j, 0, 1, n ) = -p.Cd.row( differences[j] );
+
+    return Acl;
+}
+
+
+template <class Model>
+MatrixXf linearAnalysis<Model>::analyze( const MatrixXf& gains ) const
+{
+    const unsigned int NY = Model::NY;
+    if ( gains.cols() != 3*NY )
+        throw std::invalid_argument("Incorrect number of gains given");
+    if ( points.empty() )
+        throw std::runtime_error("No operating points added");
+
+    unsigned int nCombinations = gains.rows();
+    MatrixXf results( nCombinations, 4 );
+    results.col(0).setZero();
+    results.rightCols(3).setConstant( INFINITY );
+
+    MatrixXd G = gains.cast<double>();
+    EigenSolver<MatrixXd> eigen;
+
+    for ( unsigned int k=0; k<points.size(); ++k )
+    {
+        // Loop response of every combination at once (real gains: two real products),
+        // one column per combination
+        MatrixXd loopReal = points[k].response.real().transpose()*G.transpose();
+        MatrixXd loopImag = points[k].response.imag().transpose()*G.transpose();
+
+        for ( unsigned int c=0; c<nCombinations; ++c )
+        {
+            VectorXd combination = G.row(c).transpose();
+            eigen.compute( closedLoopMatrix( k, combination ), false );
+            float radius = eigen.eigenvalues().cwiseAbs().maxCoeff();
+
+            double gainMargin, phaseMargin, bandwidth;
+            margins( loopReal.col(c).data(), loopImag.col(c).data(), gainMargin, phaseMargin, bandwidth );
+
+            results(c,0) = std::max( results(c,0), radius );
+            results(c,1) = std::min( results(c,1), (float) gainMargin );
+            results(c,2) = std::min( results(c,2), (float) phaseMargin );
+            results(c,3) = std::min( results(c,3), (float) bandwidth );
+        }
+    }
+    return results;
+}
+
+
+
+//
+// PRIVATE MEMBER FUNCTIONS:
+//
+
+template <class Model>
+void linearAnalysis<Model>::margins( const double* re, const double* im, double& gainMargin, double& phaseMargin,
+                                     double& bandwidth ) const
+{
+    unsigned int n = frequencies.size();
+    gainMargin = INFINITY;
+    phaseMargin = INFINITY;
+
+    for ( unsigned int k=0; k+1<n; ++k )
+    {
+        // Phase crossover: loop crosses the negative real axis
+        if ( im[k]*im[k+1] <= 0.0 && im[k] != im[k+1] )
+        {
+            double s = im[k]/( im[k] - im[k+1] );
+            double crossing = re[k] + s*( re[k+1] - re[k] );
+            if ( crossing < 0.0 )
+                gainMargin = std::min( gainMargin, -20.0*log10( -crossing ) );
+        }
+
+        // Gain crossover: loop crosses the unit circle
+        double m0 = re[k]*re[k] + im[k]*im[k] - 1.0, m1 = re[k+1]*re[k+1] + im[k+1]*im[k+1] - 1.0;
+        if ( m0*m1 <= 0.0 && m0 != m1 )
+        {
+            double s = m0/( m0 - m1 );
+            double phase = 180.0 + atan2( im[k] + s*( im[k+1] - im[k] ), re[k] + s*( re[k+1] - re[k] ) )*180.0/M_PI;
+            if ( phase > 180.0 )
+                phase -= 360.0;
+            phaseMargin = std::min( phaseMargin, phase );
+        }
+    }
+
+    // At the Nyquist frequency (z = -1) the loop is real
+    if ( re[n-1] < 0.0 && std::abs( im[n-1] ) <= 1e-9*std::abs( re[n-1] ) )
+        gainMargin = std::min( gainMargin, -20.0*log10( -re[n-1] ) );
+
+    // Bandwidth: complementary sensitivity |L/(1+L)| 3 dB below its low-frequency value
+    auto sensitivity2 = [&]( unsigned int k )
+    {
+        return ( re[k]*re[k] + im[k]*im[k] )/( ( 1.0 + re[k] )*( 1.0 + re[k] ) + im[k]*im[k] );
+    };
+    double low2 = sensitivity2( 0 );
+    bandwidth = frequencies( n-1 );
+    for ( unsigned int k=0; k<n; ++k )
+    {
+        if ( sensitivity2( k ) < low2/2.0 )
+        {
+            bandwidth = frequencies(k);
+            break;
+        }
+    }
+}
+
+
+template <class Model>
+template <class Tableau>
+void linearAnalysis<Model>::useScheme(  )
+{
+    stepper = &explicitRungeKutta<Tableau, Model, double>;
+}
+
+
+
+//
+// EXPLICIT INSTANTIATIONS:
+//
+
+template class linearAnalysis<rocketModel>;
+template class linearAnalysis<poweredAscentModel>;
@@ -0,0 +1,324 @@
+/**
+ *	\file src/logger.cpp
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#include "../header.h"    // #include header
+
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+typedef std::chrono::steady_clock logClock;
+
+static const unsigned int BUFFER_CAPACITY = 1024;     // Records per thread buffer
+
+static const char* LEVEL_NAMES[] = { "DEBUG", "INFO", "WARNING", "ERROR" };
+
+
+struct logRecord
+{
+    logger::level lvl;
+    logClock::time_point time;
+    std::function<void( std::ostream& )> format;
+};
+
+
+/** Single-producer single-consumer ring buffer of one thread
+ */
+struct threadBuffer
+{
+    logRecord records[BUFFER_CAPACITY];
+    std::atomic<unsigned int> head{ 0 };        // Next record to be drained (background thread)
+    std::atomic<unsigned int> tail{ 0 };        // Next free slot (owning thread)
+    std::atomic<unsigned int> dropped{ 0 };     // Records dropped because the buffer was full
+    std::atomic<bool> orphaned{ false };        // Owning thread has exited
+};
+
+
+struct progressCounter::state
+{
+    std::string task;
+    unsigned int total;
+    std::atomic<unsigned int> done{ 0 };
+    std::atomic<bool> finished{ false };
+    logClock::time_point start;
+    logClock::time_point lastReport;
+};
+
+
+/** Background thread draining the thread buffers and reporting progress
+ */
+class logWriter
+{
+    public:
+        static logWriter& instance(  )
+        {
+            static logWriter writer;
+            return writer;
+        }
+
+        logWriter(  )
+        {
+            worker = std::thread( &logWriter::run, this );
+        }
+
+        ~logWriter(  )
+        {
+            {
+                std::lock_guard<std::mutex> lock( mutex );
+                stop = true;
+            }
+            wake.notify_all();
+            worker.join();
+        }
+
+        threadBuffer& buffer(  )
+        {
+            // Registered once per thread; the buffer outlives the thread until it is drained
+            struct owner
+            {
+                std::shared_ptr<threadBuffer> buffer;
+                ~owner(  ) { if ( buffer ) buffer->orphaned = true; }
+            };
+            static thread_local owner local;
+
+            if ( !local.buffer )
+            {
+                local.buffer = std::make_shared<threadBuffer>();
+                std::lock_guard<std::mutex> lock( mutex );
+                buffers.push_back( local.buffer );
+            }
+            return *local.buffer;
+        }
+
+        void addProgress( const std::shared_ptr<progressCounter::state>& progress )
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            counters.push_back( progress );
+        }
+
+        void flush(  )
+        {
+            std::unique_lock<std::mutex> lock( mutex );
+            unsigned long long request = ++flushRequested;
+            wake.notify_all();
+            flushed.wait( lock, [&]() { return flushCompleted >= request; } );
+        }
+
+        std::atomic<float> progressInterval{ 1.0f };
+
+
+    private:
+        void run(  )
+        {
+            std::unique_lock<std::mutex> lock( mutex );
+            while ( true )
+            {
+                wake.wait_for( lock, std::chrono::milliseconds( 50 ), [&]() { return stop || flushRequested > flushCompleted; } );
+
+                bool stopping = stop;
+                unsigned long long request = flushRequested;
+
+                std::vector<std::shared_ptr<threadBuffer> > current = buffers;
+                lock.unlock();
+                drain( current );
+                lock.lock();
+
+                // Buffers of exited threads are dropped once they are empty
+                for ( unsigned int k=0; k<buffers.size(); )
+                {
+                    if ( buffers[k]->orphaned && buffers[k]->head == buffers[k]->tail )
+                        buffers.erase( buffers.begin() + k );
+                    else
+                        ++k;
+                }
+                report();
+
+                flushCompleted = request;
+                flushed.notify_all();
+                if ( stopping )
+                    return;
+            }
+        }
+
+        void drain( const std::vector<std::shared_ptr<threadBuffer> >& current )
+        {
+            std::vector<logRecord> pending;
+            unsigned int nDropped = 0;
+
+            for ( unsigned int k=0; k<current.size(); ++k )
+            {
+                threadBuffer& b = *current[k];
+                unsigned int h = b.head.load( std::memory_order_relaxed );
+                unsigned int t = b.tail.load( std::memory_order_acquire );
+                for ( ; h != t; ++h )
+                    pending.push_back( std::move( b.records[h % BUFFER_CAPACITY] ) );
+                b.head.store( h, std::memory_order_release );
+                nDropped += b.dropped.exchange( 0 );
+            }
+
+            std::stable_sort( pending.begin(), pending.end(),
+                              []( const logRecord& a, const logRecord& b ) { return a.time < b.time; } );
+
+            for ( unsigned int k=0; k<pending.size(); ++k )
+            {
+                std::ostream& stream = ( pending[k].lvl >= logger::WARNING ) ? std::cerr : std::cout;
+                if ( pending[k].lvl != logger::INFO )
+                    stream << LEVEL_NAMES[pending[k].lvl] << ": ";
+                pending[k].format( stream );
+                stream << '\n';
+            }
+            if ( nDropped > 0 )
+                std::cerr << "WARNING: " << nDropped << " log records dropped (buffer full)\n";
+
+            std::cout.flush();
+            std::cerr.flush();
+        }
+
+        void report(  )
+        {
+            logClock::time_point now = logClock::now();
+            bool show = logger::enabled( logger::INFO );
+
+            for ( unsigned int k=0; k<counters.size(); )
+            {
+                // Finished counters have logged their final count themselves
+                progressCounter::state& p = *counters[k];
+                if ( p.finished )
+                {
+                    counters.erase( counters.begin() + k );
+                    continue;
+                }
+
+                double elapsed = std::chrono::duration<double>( now - p.start ).count();
+                double sinceReport = std::chrono::duration<double>( now - p.lastReport ).count();
+                if ( show && sinceReport >= progressInterval )
+                {
+                    unsigned int done = p.done;
+                    double rate = done/elapsed;
+
+                    std::cout << p.task << ": " << done;
+                    if ( p.total > 0 )
+                        std::cout << "/" << p.total;
+                    std::cout << " done, " << std::fixed << std::setprecision( 0 ) << rate << " runs/s";
+                    if ( p.total > 0 && rate > 0.0 )
+                        std::cout << ", ETA " << ( p.total - done )/rate << " s";
+                    std::cout << std::defaultfloat << std::setprecision( 6 ) << std::endl;
+                    p.lastReport = now;
+                }
+                ++k;
+            }
+        }
+
+        std::thread worker;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable flushed;
+        bool stop = false;
+        unsigned long long flushRequested = 0;
+        unsigned long long flushCompleted = 0;
+
+        std::vector<std::shared_ptr<threadBuffer> > buffers;
+        std::vector<std::shared_ptr<progressCounter::state> > counters;
+};
+
+
+//
+// PUBLIC MEMBER FUNCTIONS:
+//
+
+std::atomic<int> logger::lowestLevel( logger::INFO );
+
+
+void logger::setLevel( level lowest )
+{
+    lowestLevel.store( lowest, std::memory_order_relaxed );
+}
+
+
+bool logger::enabled( level lvl )
+{
+    return lvl >= lowestLevel.load( std::memory_order_relaxed ) && lvl != OFF;
+}
+
+
+void logger::setProgressInterval( float seconds )
+{
+    logWriter::instance().progressInterval = seconds;
+}
+
+
+void logger::flush(  )
+{
+    logWriter::instance().flush();
+}
+
+
+progressCounter::progressCounter( const std::string& task, unsigned int total )
+{
+    progress = std::make_shared<state>();
+    progress->task = task;
+    progress->total = total;
+    progress->start = progress->lastReport = logClock::now();
+
+    logWriter::instance().addProgress( progress );
+}
+
+
+progressCounter::~progressCounter(  )
+{
+    double elapsed = std::chrono::duration<double>( logClock::now() - progress->start ).count();
+    unsigned int done = progress->done;
+
+    std::ostringstream message;
+    message << progress->task << ": " << done;
+    if ( progress->total > 0 )
+        message << "/" << progress->total;
+    message << " done in " << std::fixed << std::setprecision( 1 ) << elapsed << " s ("
+            << std::setprecision( 0 ) << ( elapsed > 0.0 ? done/elapsed : 0.0 ) << " runs/s)";
+    logger::info( message.str() );
+
+    progress->finished = true;
+}
+
+
+void progressCounter::advance( unsigned int n )
+{
+    progress->done.fetch_add( n, std::memory_order_relaxed );
+}
+
+
+//
+// PRIVATE MEMBER FUNCTIONS:
+//
+
+void logger::append( level lvl, std::function<void( std::ostream& )>&& format )
+{
+    threadBuffer& b = logWriter::instance().buffer();
+
+    unsigned int t = b.tail.load( std::memory_order_relaxed );
+    if ( t - b.head.load( std::memory_order_acquire ) >= BUFFER_CAPACITY )
+    {
+        // Warnings and errors are never lost: wait for the background thread to drain the buffer
+        if ( lvl < WARNING )
+        {
+            b.dropped.fetch_add( 1, std::memory_order_relaxed );
+            return;
+        }
+        while ( t - b.head.load( std::memory_order_acquire ) >= BUFFER_CAPACITY )
+            logWriter::instance().flush();
+    }
+
+    logRecord& record = b.records[t % BUFFER_CAPACITY];
+    record.lvl = lvl;
+    record.time = logClock::now();
+    record.format = std::move( format );
+    b.tail.store( t + 1, std::memory_order_release );
+}
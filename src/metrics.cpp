@@ -0,0 +1,151 @@
+/**
+ *	\file src/metrics.cpp
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#include "../header.h"    // #include header
+
+
+//
+// METRIC REDUCERS:
+//
+
+void actuatorTravelMetric::reset(  )
+{
+    travel = 0.0;
+    lastU.resize( 0 );
+}
+
+
+void actuatorTravelMetric::update( const metricSample& sample )
+{
+    if ( sample.dt <= 0.0f )
+        return;
+
+    if ( lastU.size() == sample.u.size() )
+        travel += ( sample.u - lastU ).cwiseAbs().sum();
+    else
+        travel += sample.u.cwiseAbs().sum();        // Travel from the retracted position
+
+    lastU = sample.u;
+}
+
+
+void rmsTrackingErrorMetric::update( const metricSample& sample )
+{
+    if ( idx >= sample.error.size() )
+        throw std::invalid_argument("Invalid index for tracking error given");
+
+    sum += sample.dt * sample.error(idx) * sample.error(idx);
+    duration += sample.dt;
+}
+
+
+
+//
+// PUBLIC MEMBER FUNCTIONS:
+//
+
+metricSet::metricSet(  ){}
+
+
+metricSet::metricSet( const std::vector<std::string>& _names )
+{
+    for ( unsigned int i=0; i<_names.size(); ++i )
+        add( _names[i] );
+}
+
+
+metricSet::metricSet( const metricSet& rhs )
+{
+    *this = rhs;
+}
+
+
+metricSet& metricSet::operator=( const metricSet& rhs )
+{
+    if ( this == &rhs )
+        return *this;
+
+    names = rhs.names;
+    reducers.clear();
+    for ( unsigned int i=0; i<rhs.reducers.size(); ++i )
+        reducers.push_back( std::unique_ptr<metricReducer>( rhs.reducers[i]->clone() ) );
+
+    return *this;
+}
+
+
+metricSet::~metricSet(  ){}
+
+
+void metricSet::add( const std::string& name )
+{
+    if      ( name == "apogee" )            add( name, new apogeeMetric() );
+    else if ( name == "apogeeTime" )        add( name, new apogeeTimeMetric() );
+    else if ( name == "apogeeDeviation" )   add( name, new apogeeDeviationMetric() );
+    else if ( name == "peakOmega" )         add( name, new peakOmegaMetric() );
+    else if ( name == "actuatorTravel" )    add( name, new actuatorTravelMetric() );
+    else if ( name == "saturationTime" )    add( name, new saturationTimeMetric() );
+    else if ( name == "rmsAltitudeError" )  add( name, new rmsTrackingErrorMetric( 0 ) );
+    else if ( name == "rmsVelocityError" )  add( name, new rmsTrackingErrorMetric( 1 ) );
+    else
+        throw std::invalid_argument("Unknown metric " + name);
+}
+
+
+void metricSet::add( const std::string& name, metricReducer* reducer )
+{
+    if ( !reducer )
+        throw std::invalid_argument("No metric reducer given");
+
+    names.push_back( name );
+    reducers.push_back( std::unique_ptr<metricReducer>( reducer ) );
+    reducers.back()->reset();
+}
+
+
+void metricSet::reset(  )
+{
+    for ( unsigned int i=0; i<reducers.size(); ++i )
+        reducers[i]->reset();
+}
+
+
+void metricSet::update( const metricSample& sample )
+{
+    for ( unsigned int i=0; i<reducers.size(); ++i )
+        reducers[i]->update( sample );
+}
+
+
+void metricSet::getValues( VectorXf& values ) const
+{
+    values.resize( reducers.size() );
+    for ( unsigned int i=0; i<reducers.size(); ++i )
+        values(i) = reducers[i]->value();
+}
+
+
+const std::vector<std::string>& metricSet::getNames(  ) const
+{
+    return names;
+}
+
+
+unsigned int metricSet::size(  ) const
+{
+    return reducers.size();
+}
+
+
+void metricSet::hashConfiguration( configHash& hash ) const
+{
+    for ( unsigned int i=0; i<names.size(); ++i )
+    {
+        hash.add( names[i] );
+        reducers[i]->hashConfiguration( hash );
+    }
+}
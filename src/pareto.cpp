@@ -0,0 +1,346 @@
+/**
+ *	\file src/pareto.cpp
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#include "../header.h"    // #include header
+
+
+//
+// PUBLIC MEMBER FUNCTIONS:
+//
+
+paretoOptimizer::paretoOptimizer( const VectorXf& _lower, const VectorXf& _upper, unsigned int _populationSize,
+                                  unsigned int seed, unsigned int _archiveSize )
+{
+    if ( _lower.size() == 0 || _lower.size() != _upper.size() || ( _upper - _lower ).minCoeff() <= 0.0f )
+        throw std::invalid_argument("Invalid variable bounds given");
+    if ( _populationSize < 4 || _populationSize % 2 != 0 )
+        throw std::invalid_argument("Population size must be even and at least 4");
+
+    lower = _lower;
+    upper = _upper;
+    populationSize = _populationSize;
+    archiveSize = std::max( _archiveSize, _populationSize );
+    generator.seed( seed );
+
+    // Initial population spread over the bounds
+    MatrixXf unit = sampler::latinHypercube( populationSize, lower.size(), seed ).cast<float>();
+    candidates = ( unit.array().rowwise()*( upper - lower ).transpose().array() ).rowwise() + lower.transpose().array();
+}
+
+
+paretoOptimizer::~paretoOptimizer(  ){}
+
+
+const MatrixXf& paretoOptimizer::getCandidates(  ) const
+{
+    return candidates;
+}
+
+
+void paretoOptimizer::update( const MatrixXf& objectives, const VectorXf& violations )
+{
+    if ( objectives.rows() != candidates.rows() || violations.size() != candidates.rows() )
+        throw std::invalid_argument("Number of evaluations does not match number of candidates");
+    if ( populationObjectives.size() > 0 && objectives.cols() != populationObjectives.cols() )
+        throw std::invalid_argument("Number of objectives changed");
+
+    updateArchive( objectives, violations );
+
+    // Parents and offspring compete for the next population
+    unsigned int nParents = population.rows();
+    MatrixXf variables( nParents + candidates.rows(), lower.size() );
+    MatrixXf allObjectives( nParents + candidates.rows(), objectives.cols() );
+    VectorXf allViolations( nParents + candidates.rows() );
+    if ( nParents > 0 )
+    {
+        variables << population, candidates;
+        allObjectives << populationObjectives, objectives;
+        allViolations << populationViolations, violations;
+    }
+    else
+    {
+        variables = candidates;
+        allObjectives = objectives;
+        allViolations = violations;
+    }
+
+    std::vector<std::vector<unsigned int> > fronts = sortFronts( allObjectives, allViolations );
+
+    std::vector<unsigned int> selected;
+    std::vector<int> ranks;
+    std::vector<float> distances;
+    for ( unsigned int r=0; r<fronts.size() && selected.size() < populationSize; ++r )
+    {
+        VectorXf distance = crowding( allObjectives, fronts[r] );
+
+        // Last front that fits partially: least crowded members first
+        std::vector<unsigned int> order( fronts[r].size() );
+        for ( unsigned int j=0; j<order.size(); ++j )
+            order[j] = j;
+        std::stable_sort( order.begin(), order.end(), [&]( unsigned int a, unsigned int b ) { return distance(a) > distance(b); } );
+
+        for ( unsigned int j=0; j<order.size() && selected.size() < populationSize; ++j )
+        {
+            selected.push_back( fronts[r][order[j]] );
+            ranks.push_back( r );
+            distances.push_back( distance( order[j] ) );
+        }
+    }
+
+    unsigned int n = selected.size();
+    population.resize( n, lower.size() );
+    populationObjectives.resize( n, objectives.cols() );
+    populationViolations.resize( n );
+    populationRank.resize( n );
+    populationCrowding.resize( n );
+    for ( unsigned int j=0; j<n; ++j )
+    {
+        population.row(j) = variables.row( selected[j] );
+        populationObjectives.row(j) = allObjectives.row( selected[j] );
+        populationViolations(j) = allViolations( selected[j] );
+        populationRank(j) = ranks[j];
+        populationCrowding(j) = distances[j];
+    }
+
+    createOffspring();
+    generation++;
+}
+
+
+void paretoOptimizer::getFront( MatrixXf& variables, MatrixXf& objectives ) const
+{
+    variables = archiveVariables;
+    objectives = archiveObjectives;
+}
+
+
+unsigned int paretoOptimizer::getGeneration(  ) const
+{
+    return generation;
+}
+
+
+
+//
+// PRIVATE MEMBER FUNCTIONS:
+//
+
+bool paretoOptimizer::dominates( const float* fa, float va, const float* fb, float vb, unsigned int nObjectives )
+{
+    if ( va > 0.0f || vb > 0.0f )
+        return va < vb;
+
+    bool better = false;
+    for ( unsigned int i=0; i<nObjectives; ++i )
+    {
+        if ( fa[i] > fb[i] )
+            return false;
+        if ( fa[i] < fb[i] )
+            better = true;
+    }
+    return better;
+}
+
+
+std::vector<std::vector<unsigned int> > paretoOptimizer::sortFronts( const MatrixXf& objectives, const VectorXf& violations )
+{
+    unsigned int n = objectives.rows(), m = objectives.cols();
+    MatrixXf rows = objectives.transpose();        // Objectives of a candidate contiguous
+
+    std::vector<std::vector<unsigned int> > dominated( n );
+    std::vector<unsigned int> dominatedBy( n, 0 );
+    std::vector<std::vector<unsigned int> > fronts( 1 );
+
+    for ( unsigned int a=0; a<n; ++a )
+    {
+        for ( unsigned int b=a+1; b<n; ++b )
+        {
+            if ( dominates( rows.col(a).data(), violations(a), rows.col(b).data(), violations(b), m ) )
+            {
+                dominated[a].push_back( b );
+                dominatedBy[b]++;
+            }
+            else if ( dominates( rows.col(b).data(), violations(b), rows.col(a).data(), violations(a), m ) )
+            {
+                dominated[b].push_back( a );
+                dominatedBy[a]++;
+            }
+        }
+    }
+
+    for ( unsigned int a=0; a<n; ++a )
+        if ( dominatedBy[a] == 0 )
+            fronts[0].push_back( a );
+
+    while ( !fronts.back().empty() )
+    {
+        std::vector<unsigned int> next;
+        for ( unsigned int a : fronts.back() )
+            for ( unsigned int b : dominated[a] )
+                if ( --dominatedBy[b] == 0 )
+                    next.push_back( b );
+        fronts.push_back( next );
+    }
+    fronts.pop_back();
+    return fronts;
+}
+
+
+VectorXf paretoOptimizer::crowding( const MatrixXf& objectives, const std::vector<unsigned int>& front )
+{
+    unsigned int n = front.size();
+    VectorXf distance = VectorXf::Zero( n );
+    if ( n <= 2 )
+        return VectorXf::Constant( n, INFINITY );
+
+    std::vector<unsigned int> order( n );
+    for ( unsigned int i=0; i<objectives.cols(); ++i )
+    {
+        for ( unsigned int j=0; j<n; ++j )
+            order[j] = j;
+        std::sort( order.begin(), order.end(),
+                   [&]( unsigned int a, unsigned int b ) { return objectives( front[a], i ) < objectives( front[b], i ); } );
+
+        // Boundary solutions are always kept
+        float range = objectives( front[order[n-1]], i ) - objectives( front[order[0]], i );
+        distance( order[0] ) = distance( order[n-1] ) = INFINITY;
+        if ( range <= 0.0f )
+            continue;
+
+        for ( unsigned int j=1; j+1<n; ++j )
+            distance( order[j] ) += ( objectives( front[order[j+1]], i ) - objectives( front[order[j-1]], i ) )/range;
+    }
+    return distance;
+}
+
+
+void paretoOptimizer::updateArchive( const MatrixXf& objectives, const VectorXf& violations )
+{
+    unsigned int m = objectives.cols();
+    std::vector<VectorXf> variables, values;
+    for ( unsigned int j=0; j<archiveVariables.rows(); ++j )
+    {
+        variables.push_back( archiveVariables.row(j).transpose() );
+        values.push_back( archiveObjectives.row(j).transpose() );
+    }
+
+    for ( unsigned int c=0; c<objectives.rows(); ++c )
+    {
+        if ( violations(c) > 0.0f || !objectives.row(c).allFinite() )
+            continue;
+
+        VectorXf f = objectives.row(c).transpose();
+        bool isDominated = false;
+        for ( unsigned int j=0; j<values.size() && !isDominated; ++j )
+            isDominated = dominates( values[j].data(), 0.0f, f.data(), 0.0f, m ) || values[j] == f;
+        if ( isDominated )
+            continue;
+
+        // Remove members dominated by the new solution
+        for ( unsigned int j=0; j<values.size(); )
+        {
+            if ( dominates( f.data(), 0.0f, values[j].data(), 0.0f, m ) )
+            {
+                values.erase( values.begin() + j );
+                variables.erase( variables.begin() + j );
+            }
+            else
+                ++j;
+        }
+        values.push_back( f );
+        variables.push_back( candidates.row(c).transpose() );
+    }
+
+    archiveVariables.resize( variables.size(), lower.size() );
+    archiveObjectives.resize( values.size(), m );
+    for ( unsigned int j=0; j<values.size(); ++j )
+    {
+        archiveVariables.row(j) = variables[j].transpose();
+        archiveObjectives.row(j) = values[j].transpose();
+    }
+
+    // Thin out the most crowded solutions
+    while ( archiveObjectives.rows() > archiveSize )
+    {
+        std::vector<unsigned int> all( archiveObjectives.rows() );
+        for ( unsigned int j=0; j<all.size(); ++j )
+            all[j] = j;
+        VectorXf distance = crowding( archiveObjectives, all );
+
+        unsigned int worst;
+        distance.minCoeff( &worst );
+        unsigned int last = archiveObjectives.rows() - 1;
+        archiveVariables.row( worst ) = archiveVariables.row( last );
+        archiveObjectives.row( worst ) = archiveObjectives.row( last );
+        archiveVariables.conservativeResize( last, NoChange );
+        archiveObjectives.conservativeResize( last, NoChange );
+    }
+}
+
+
+void paretoOptimizer::createOffspring(  )
+{
+    unsigned int d = lower.size();
+    std::uniform_real_distribution<float> uniform( 0.0f, 1.0f );
+    candidates.resize( populationSize, d );
+
+    for ( unsigned int c=0; c<populationSize; c+=2 )
+    {
+        // Parents in variables scaled to [0, 1]
+        VectorXf x1 = ( population.row( tournament() ).transpose() - lower ).cwiseQuotient( upper - lower );
+        VectorXf x2 = ( population.row( tournament() ).transpose() - lower ).cwiseQuotient( upper - lower );
+
+        // Simulated binary crossover (probability 0.9, half of the variables)
+        if ( uniform( generator ) < 0.9f )
+        {
+            for ( unsigned int i=0; i<d; ++i )
+            {
+                if ( uniform( generator ) > 0.5f )
+                    continue;
+
+                float r = uniform( generator );
+                float beta = ( r <= 0.5f ) ? pow( 2.0f*r, 1.0f/( crossoverIndex + 1.0f ) )
+                                           : pow( 1.0f/( 2.0f*( 1.0f - r ) ), 1.0f/( crossoverIndex + 1.0f ) );
+                float a = x1(i), b = x2(i);
+                x1(i) = 0.5f*( ( 1.0f + beta )*a + ( 1.0f - beta )*b );
+                x2(i) = 0.5f*( ( 1.0f - beta )*a + ( 1.0f + beta )*b );
+            }
+        }
+
+        // Polynomial mutation (probability 1/d per variable)
+        for ( VectorXf* x : { &x1, &x2 } )
+        {
+            for ( unsigned int i=0; i<d; ++i )
+            {
+                if ( uniform( generator ) >= 1.0f/d )
+                    continue;
+
+                float r = uniform( generator );
+                float delta = ( r < 0.5f ) ? pow( 2.0f*r, 1.0f/( mutationIndex + 1.0f ) ) - 1.0f
+                                           : 1.0f - pow( 2.0f*( 1.0f - r ), 1.0f/( mutationIndex + 1.0f ) );
+                (*x)(i) += delta;
+            }
+        }
+
+        x1 = x1.cwiseMax( 0.0f ).cwiseMin( 1.0f );
+        x2 = x2.cwiseMax( 0.0f ).cwiseMin( 1.0f );
+        candidates.row(c) = ( lower + x1.cwiseProduct( upper - lower ) ).transpose();
+        candidates.row(c+1) = ( lower + x2.cwiseProduct( upper - lower ) ).transpose();
+    }
+}
+
+
+unsigned int paretoOptimizer::tournament(  )
+{
+    std::uniform_int_distribution<unsigned int> pick( 0, population.rows()-1 );
+    unsigned int a = pick( generator ), b = pick( generator );
+
+    // Lower rank wins, then larger crowding distance
+    if ( populationRank(a) != populationRank(b) )
+        return ( populationRank(a) < populationRank(b) ) ? a : b;
+    return ( populationCrowding(a) >= populationCrowding(b) ) ? a : b;
+}
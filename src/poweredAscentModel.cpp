@@ -0,0 +1,84 @@
+/**
+ *	\file src/poweredAscentModel.cpp
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#include "../header.h"    // #include header
+
+
+//
+// PUBLIC MEMBER FUNCTIONS:
+//
+
+poweredAscentModel::poweredAscentModel(  ){}
+
+
+poweredAscentModel::~poweredAscentModel(  ){}
+
+
+void poweredAscentModel::setParameter( const std::string& name, double value )
+{
+    if      ( name == "p00" ) p00 = value;
+    else if ( name == "p10" ) p10 = value;
+    else if ( name == "p01" ) p01 = value;
+    else if ( name == "p20" ) p20 = value;
+    else if ( name == "p11" ) p11 = value;
+    else if ( name == "p02" ) p02 = value;
+    else if ( name == "p21" ) p21 = value;
+    else if ( name == "p12" ) p12 = value;
+    else if ( name == "p03" ) p03 = value;
+    else if ( name == "g" ) g = value;
+    else if ( name == "density_sea" ) density_sea = value;
+    else if ( name == "A" ) A = value;
+    else if ( name == "dryMass" ) dryMass = value;
+    else if ( name == "thrust" ) thrust = value;
+    else if ( name == "burnTime" ) burnTime = value;
+    else if ( name == "Isp" ) Isp = value;
+    else if ( name == "launchAngle" ) launchAngle = value;
+    else
+        throw std::invalid_argument("Unknown model parameter " + name);
+}
+
+
+double poweredAscentModel::getParameter( const std::string& name ) const
+{
+    if      ( name == "p00" ) return p00;
+    else if ( name == "p10" ) return p10;
+    else if ( name == "p01" ) return p01;
+    else if ( name == "p20" ) return p20;
+    else if ( name == "p11" ) return p11;
+    else if ( name == "p02" ) return p02;
+    else if ( name == "p21" ) return p21;
+    else if ( name == "p12" ) return p12;
+    else if ( name == "p03" ) return p03;
+    else if ( name == "g" ) return g;
+    else if ( name == "density_sea" ) return density_sea;
+    else if ( name == "A" ) return A;
+    else if ( name == "dryMass" ) return dryMass;
+    else if ( name == "thrust" ) return thrust;
+    else if ( name == "burnTime" ) return burnTime;
+    else if ( name == "Isp" ) return Isp;
+    else if ( name == "launchAngle" ) return launchAngle;
+    else
+        throw std::invalid_argument("Unknown model parameter " + name);
+}
+
+
+void poweredAscentModel::hashConfiguration( configHash& hash ) const
+{
+    hash.add( modelVersion );
+
+    hash.add( p00 ); hash.add( p10 ); hash.add( p01 );
+    hash.add( p20 ); hash.add( p11 ); hash.add( p02 );
+    hash.add( p21 ); hash.add( p12 ); hash.add( p03 );
+    hash.add( g );
+    hash.add( density_sea );
+    hash.add( A );
+    hash.add( dryMass );
+    hash.add( thrust );
+    hash.add( burnTime );
+    hash.add( Isp );
+    hash.add( launchAngle );
+}
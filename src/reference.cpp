@@ -0,0 +1,261 @@
+/**
+ *	\file src/reference.cpp
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#include "../header.h"    // #include header
+
+
+//
+// PUBLIC MEMBER FUNCTIONS:
+//
+
+referenceTrajectory::referenceTrajectory(  )
+{
+    type = NONE;
+    nSignals = 0;
+    t0 = 0.0;
+    t1 = 0.0;
+    nSegments = 0;
+    h = 0.0;
+}
+
+
+referenceTrajectory::~referenceTrajectory(  ){}
+
+
+void referenceTrajectory::setMonomial( const MatrixXf& _coeff )
+{
+    if ( _coeff.cols() == 0 )
+        throw std::invalid_argument("No polynomial coefficients given");
+
+    type = MONOMIAL;
+    nSignals = _coeff.rows();
+    coeff = _coeff.cast<double>();
+}
+
+
+void referenceTrajectory::fitChebyshev( const VectorXf& _t, const MatrixXf& _data, unsigned int _order )
+{
+    unsigned int N = _t.size();
+
+    if ( _data.cols() != N )
+        throw std::invalid_argument("Number of samples does not match number of sample times");
+    if ( N < _order+1 )
+        throw std::invalid_argument("Not enough samples for requested Chebyshev order");
+
+    t0 = _t(0);
+    t1 = _t(N-1);
+
+    // Chebyshev basis evaluated on normalized interval [-1, 1]
+    MatrixXd T( N, _order+1 );
+    for ( unsigned int k=0; k<N; ++k )
+    {
+        double s = ( 2.0*_t(k) - (t0 + t1) ) / (t1 - t0);
+
+        T(k,0) = 1.0;
+        if ( _order > 0 )
+            T(k,1) = s;
+        for ( unsigned int j=2; j<=_order; ++j )
+            T(k,j) = 2.0*s*T(k,j-1) - T(k,j-2);
+    }
+
+    // Least-squares solution of T*c = data' for all signals at once
+    MatrixXd c = T.colPivHouseholderQr().solve( _data.transpose().cast<double>() );
+
+    type = CHEBYSHEV;
+    nSignals = _data.rows();
+    coeff = c.transpose();
+}
+
+
+void referenceTrajectory::fitSpline( const VectorXf& _t, const MatrixXf& _data, unsigned int _nSegments )
+{
+    unsigned int N = _t.size();
+
+    if ( _data.cols() != N )
+        throw std::invalid_argument("Number of samples does not match number of sample times");
+    if ( _nSegments < 1 || N < 2 )
+        throw std::invalid_argument("Not enough samples or segments for spline fit");
+
+    t0 = _t(0);
+    t1 = _t(N-1);
+    nSegments = _nSegments;
+    h = (t1 - t0) / nSegments;
+    nSignals = _data.rows();
+
+    // Sample data at uniformly spaced knots (linear interpolation between samples)
+    MatrixXd knots( nSignals, nSegments+1 );
+    unsigned int k = 0;
+    for ( unsigned int i=0; i<=nSegments; ++i )
+    {
+        double tk = t0 + i*h;
+        while ( k < N-2 && _t(k+1) < tk )
+            k++;
+
+        double w = ( tk - _t(k) ) / ( _t(k+1) - _t(k) );
+        for ( unsigned int j=0; j<nSignals; ++j )
+            knots(j,i) = (1.0 - w)*_data(j,k) + w*_data(j,k+1);
+    }
+
+    // Solve tridiagonal system for knot second derivatives (natural end conditions)
+    coeff = MatrixXd::Zero( nSignals, 4*nSegments );
+    VectorXd M = VectorXd::Zero( nSegments+1 );
+    VectorXd cp( nSegments+1 );
+    VectorXd dp( nSegments+1 );
+
+    for ( unsigned int j=0; j<nSignals; ++j )
+    {
+        // Forward sweep (Thomas algorithm), system: M_{i-1} + 4 M_i + M_{i+1} = rhs_i
+        cp(0) = 0.0; dp(0) = 0.0;
+        for ( unsigned int i=1; i<nSegments; ++i )
+        {
+            double rhs = 6.0/(h*h) * ( knots(j,i+1) - 2.0*knots(j,i) + knots(j,i-1) );
+            double m = 4.0 - cp(i-1);
+            cp(i) = 1.0/m;
+            dp(i) = ( rhs - dp(i-1) )/m;
+        }
+
+        // Back substitution
+        M(nSegments) = 0.0;
+        for ( int i=nSegments-1; i>=1; --i )
+            M(i) = dp(i) - cp(i)*M(i+1);
+        M(0) = 0.0;
+
+        // Local cubic per segment: y = a + b*s + c*s^2 + d*s^3 with s = t - t_i
+        for ( unsigned int i=0; i<nSegments; ++i )
+        {
+            coeff(j,4*i)   = ( M(i+1) - M(i) ) / (6.0*h);
+            coeff(j,4*i+1) = M(i)/2.0;
+            coeff(j,4*i+2) = ( knots(j,i+1) - knots(j,i) )/h - h*( 2.0*M(i) + M(i+1) )/6.0;
+            coeff(j,4*i+3) = knots(j,i);
+        }
+    }
+
+    type = SPLINE;
+}
+
+
+template <class Scalar>
+void referenceTrajectory::evaluate( double _t, VectorX<Scalar>& _y ) const
+{
+    _y.resize( nSignals );
+
+    switch ( type )
+    {
+        case MONOMIAL:
+        {
+            // Horner scheme
+            for ( unsigned int i=0; i<nSignals; ++i )
+            {
+                double tmp = coeff(i,0);
+                for ( unsigned int j=1; j<coeff.cols(); ++j )
+                    tmp = tmp*_t + coeff(i,j);
+                _y(i) = tmp;
+            }
+            break;
+        }
+        case CHEBYSHEV:
+        {
+            // Clenshaw recurrence on normalized time
+            double s = ( 2.0*_t - (t0 + t1) ) / (t1 - t0);
+            unsigned int n = coeff.cols();
+
+            for ( unsigned int i=0; i<nSignals; ++i )
+            {
+                double b1 = 0.0, b2 = 0.0;
+                for ( int j=n-1; j>=1; --j )
+                {
+                    double tmp = 2.0*s*b1 - b2 + coeff(i,j);
+                    b2 = b1;
+                    b1 = tmp;
+                }
+                _y(i) = s*b1 - b2 + coeff(i,0);
+            }
+            break;
+        }
+        case SPLINE:
+        {
+            // Knot-span index from uniform knot spacing, clamped to end segments
+            int idx = (int) floor( (_t - t0)/h );
+            if ( idx < 0 )
+                idx = 0;
+            if ( idx > (int) nSegments-1 )
+                idx = nSegments-1;
+
+            double s = _t - ( t0 + idx*h );
+            for ( unsigned int i=0; i<nSignals; ++i )
+                _y(i) = ( ( coeff(i,4*idx)*s + coeff(i,4*idx+1) )*s + coeff(i,4*idx+2) )*s + coeff(i,4*idx+3);
+            break;
+        }
+        default:
+            _y.setZero();
+    }
+}
+
+
+VectorXf referenceTrajectory::maxError( const VectorXf& _t, const MatrixXf& _data ) const
+{
+    VectorXf err = VectorXf::Zero( nSignals );
+    VectorXf y( nSignals );
+
+    for ( unsigned int k=0; k<_t.size(); ++k )
+    {
+        evaluate( _t(k), y );
+        for ( unsigned int i=0; i<nSignals; ++i )
+            err(i) = std::max( err(i), std::abs( y(i) - _data(i,k) ) );
+    }
+    return err;
+}
+
+
+unsigned int referenceTrajectory::getNumSignals(  ) const
+{
+    return nSignals;
+}
+
+
+referenceTrajectory::representation referenceTrajectory::getType(  ) const
+{
+    return type;
+}
+
+
+const MatrixXd& referenceTrajectory::getCoefficients(  ) const
+{
+    return coeff;
+}
+
+
+double referenceTrajectory::getStartTime(  ) const
+{
+    return t0;
+}
+
+
+double referenceTrajectory::getEndTime(  ) const
+{
+    return t1;
+}
+
+
+void referenceTrajectory::hashConfiguration( configHash& hash ) const
+{
+    hash.add( (unsigned int) type );
+    hash.add( nSignals );
+    hash.add( t0 );
+    hash.add( t1 );
+    hash.add( nSegments );
+    hash.add( coeff );
+}
+
+
+
+//
+// EXPLICIT INSTANTIATIONS:
+//
+
+template void referenceTrajectory::evaluate( double, VectorXf& ) const;
+template void referenceTrajectory::evaluate( double, VectorXd& ) const;
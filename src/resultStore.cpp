@@ -0,0 +1,464 @@
+/**
+ *	\file src/resultStore.cpp
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#include "../header.h"    // #include header
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char headerMagic[8] = { 'R','S','T','O','R','E','0','1' };
+static const char trailerMagic[8] = { 'R','S','T','O','R','E','I','X' };
+
+
+/** Compress a chunk: per column XOR with the previous value (consecutive runs differ in
+ *  few bits), byte planes of all values (the unchanged high bytes form long runs) and
+ *  run-length coding of the planes (PackBits)
+ */
+static void compressChunk( const MatrixXf& rows, unsigned int nRows, std::string& out )
+{
+    unsigned int nCols = rows.cols();
+    std::vector<unsigned char> planes( 4*(size_t) nRows*nCols );
+
+    size_t n = 0;
+    for ( unsigned int c=0; c<nCols; ++c )
+    {
+        uint32_t previous = 0;
+        std::vector<uint32_t> delta( nRows );
+        for ( unsigned int r=0; r<nRows; ++r )
+        {
+            float value = rows(r,c);
+            uint32_t bits;
+            memcpy( &bits, &value, 4 );
+            delta[r] = bits ^ previous;
+            previous = bits;
+        }
+        for ( unsigned int b=0; b<4; ++b )
+            for ( unsigned int r=0; r<nRows; ++r )
+                planes[n++] = ( delta[r] >> (8*b) ) & 0xff;
+    }
+
+    // PackBits: control c < 128: c+1 literal bytes, c >= 128: byte repeated c-125 times
+    out.clear();
+    size_t i = 0;
+    while ( i < planes.size() )
+    {
+        size_t run = 1;
+        while ( i+run < planes.size() && planes[i+run] == planes[i] && run < 130 )
+            run++;
+
+        if ( run >= 3 )
+        {
+            out.push_back( (char) ( run + 125 ) );
+            out.push_back( (char) planes[i] );
+            i += run;
+            continue;
+        }
+
+        size_t start = i, length = 0;
+        while ( i < planes.size() && length < 128 )
+        {
+            if ( i+2 < planes.size() && planes[i] == planes[i+1] && planes[i] == planes[i+2] )
+                break;
+            i++; length++;
+        }
+        out.push_back( (char) ( length - 1 ) );
+        out.append( (const char*) &planes[start], length );
+    }
+}
+
+
+/** Decompress a chunk written by compressChunk
+ */
+static void decompressChunk( const unsigned char* data, size_t size, unsigned int nRows, unsigned int nCols, MatrixXf& rows )
+{
+    std::vector<unsigned char> planes( 4*(size_t) nRows*nCols );
+
+    size_t n = 0, i = 0;
+    while ( i < size && n < planes.size() )
+    {
+        unsigned int control = data[i++];
+        if ( control < 128 )
+        {
+            size_t length = control + 1;
+            if ( i+length > size || n+length > planes.size() )
+                break;
+            memcpy( &planes[n], data+i, length );
+            i += length; n += length;
+        }
+        else
+        {
+            size_t run = control - 125;
+            if ( i >= size || n+run > planes.size() )
+                break;
+            memset( &planes[n], data[i++], run );
+            n += run;
+        }
+    }
+    if ( n != planes.size() )
+        throw std::runtime_error("Corrupt chunk in result store");
+
+    rows.resize( nRows, nCols );
+    n = 0;
+    for ( unsigned int c=0; c<nCols; ++c )
+    {
+        std::vector<uint32_t> delta( nRows, 0 );
+        for ( unsigned int b=0; b<4; ++b )
+            for ( unsigned int r=0; r<nRows; ++r )
+                delta[r] |= (uint32_t) planes[n++] << (8*b);
+
+        uint32_t previous = 0;
+        for ( unsigned int r=0; r<nRows; ++r )
+        {
+            uint32_t bits = delta[r] ^ previous;
+            previous = bits;
+            float value;
+            memcpy( &value, &bits, 4 );
+            rows(r,c) = value;
+        }
+    }
+}
+
+
+/** Read a value from mapped memory, checking the bounds of the file
+ */
+template <class T>
+static T readValue( const unsigned char* data, size_t size, size_t& pos )
+{
+    if ( pos + sizeof( T ) > size )
+        throw std::runtime_error("Truncated result store");
+
+    T value;
+    memcpy( &value, data+pos, sizeof( T ) );
+    pos += sizeof( T );
+    return value;
+}
+
+
+
+//
+// PUBLIC MEMBER FUNCTIONS:
+//
+
+resultStore::resultStore(  )
+{
+    chunkRows = 0;
+    nRows = 0;
+    nBuffered = 0;
+    mapped = NULL;
+    mappedSize = 0;
+}
+
+
+resultStore::~resultStore(  )
+{
+    try
+    {
+        close();
+    }
+    catch ( const std::exception& e )
+    {
+        std::cerr << "Result store not closed: " << e.what() << std::endl;
+    }
+}
+
+
+void resultStore::create( const std::string& fileName, const std::vector<std::string>& _columns, unsigned int _chunkRows )
+{
+    close();
+
+    if ( _columns.empty() || _chunkRows == 0 )
+        throw std::invalid_argument("Result store needs at least one column and one row per chunk");
+
+    output.open( fileName, std::ios::binary | std::ios::trunc );
+    if ( !output.is_open() )
+        throw std::runtime_error("Could not open file " + fileName);
+
+    columns = _columns;
+    chunkRows = _chunkRows;
+    chunks.clear();
+    nRows = 0;
+    buffer.resize( chunkRows, columns.size() );
+    nBuffered = 0;
+
+    // Header: magic, schema, chunk size
+    output.write( headerMagic, 8 );
+    uint32_t nCols = columns.size();
+    output.write( (const char*) &nCols, 4 );
+    for ( unsigned int c=0; c<columns.size(); ++c )
+    {
+        uint16_t length = columns[c].size();
+        output.write( (const char*) &length, 2 );
+        output.write( columns[c].data(), length );
+    }
+    output.write( (const char*) &chunkRows, 4 );
+}
+
+
+void resultStore::append( const VectorXf& row )
+{
+    if ( !output.is_open() )
+        throw std::runtime_error("Result store is not open for writing");
+    if ( row.size() != (Index) columns.size() )
+        throw std::invalid_argument("Number of values does not match number of columns");
+
+    buffer.row( nBuffered++ ) = row.transpose();
+    nRows++;
+
+    if ( nBuffered == chunkRows )
+        flushChunk();
+}
+
+
+void resultStore::append( const MatrixXf& rows )
+{
+    for ( unsigned int r=0; r<rows.rows(); ++r )
+        append( VectorXf( rows.row(r).transpose() ) );
+}
+
+
+void resultStore::open( const std::string& fileName )
+{
+    close();
+
+#ifdef _WIN32
+    std::ifstream File( fileName, std::ios::binary );
+    if ( !File.is_open() )
+        throw std::runtime_error("Could not open file " + fileName);
+    fileData.assign( std::istreambuf_iterator<char>( File ), std::istreambuf_iterator<char>() );
+    mapped = fileData.data();
+    mappedSize = fileData.size();
+#else
+    int fd = ::open( fileName.c_str(), O_RDONLY );
+    if ( fd < 0 )
+        throw std::runtime_error("Could not open file " + fileName);
+
+    struct stat info;
+    if ( fstat( fd, &info ) != 0 || info.st_size == 0 )
+    {
+        ::close( fd );
+        throw std::runtime_error("Empty result store " + fileName);
+    }
+
+    void* address = mmap( NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+    ::close( fd );
+    if ( address == MAP_FAILED )
+        throw std::runtime_error("Could not map file " + fileName);
+
+    mapped = (const unsigned char*) address;
+    mappedSize = info.st_size;
+#endif
+
+    try
+    {
+        // Header
+        size_t pos = 0;
+        if ( mappedSize < 8 || memcmp( mapped, headerMagic, 8 ) != 0 )
+            throw std::runtime_error("Not a result store: " + fileName);
+        pos = 8;
+
+        uint32_t nCols = readValue<uint32_t>( mapped, mappedSize, pos );
+        columns.resize( nCols );
+        for ( unsigned int c=0; c<nCols; ++c )
+        {
+            uint16_t length = readValue<uint16_t>( mapped, mappedSize, pos );
+            if ( pos + length > mappedSize )
+                throw std::runtime_error("Truncated result store");
+            columns[c].assign( (const char*) mapped+pos, length );
+            pos += length;
+        }
+        chunkRows = readValue<uint32_t>( mapped, mappedSize, pos );
+
+        // Trailer
+        if ( mappedSize < 20 || memcmp( mapped+mappedSize-8, trailerMagic, 8 ) != 0 )
+            throw std::runtime_error("Result store was not closed properly: " + fileName);
+        pos = mappedSize - 20;
+        uint64_t indexOffset = readValue<uint64_t>( mapped, mappedSize, pos );
+        uint32_t nChunks = readValue<uint32_t>( mapped, mappedSize, pos );
+
+        // Index
+        pos = indexOffset;
+        chunks.resize( nChunks );
+        nRows = 0;
+        for ( unsigned int k=0; k<nChunks; ++k )
+        {
+            chunks[k].offset = readValue<uint64_t>( mapped, mappedSize, pos );
+            chunks[k].size = readValue<uint32_t>( mapped, mappedSize, pos );
+            chunks[k].rows = readValue<uint32_t>( mapped, mappedSize, pos );
+            chunks[k].min.resize( nCols );
+            chunks[k].max.resize( nCols );
+            for ( unsigned int c=0; c<nCols; ++c )
+                chunks[k].min(c) = readValue<float>( mapped, mappedSize, pos );
+            for ( unsigned int c=0; c<nCols; ++c )
+                chunks[k].max(c) = readValue<float>( mapped, mappedSize, pos );
+
+            if ( chunks[k].offset + chunks[k].size > indexOffset )
+                throw std::runtime_error("Corrupt index in result store " + fileName);
+            nRows += chunks[k].rows;
+        }
+    }
+    catch ( ... )
+    {
+        close();
+        throw;
+    }
+}
+
+
+void resultStore::close(  )
+{
+    if ( output.is_open() )
+    {
+        if ( nBuffered > 0 )
+            flushChunk();
+
+        // Index and trailer
+        uint64_t indexOffset = output.tellp();
+        for ( unsigned int k=0; k<chunks.size(); ++k )
+        {
+            output.write( (const char*) &chunks[k].offset, 8 );
+            output.write( (const char*) &chunks[k].size, 4 );
+            output.write( (const char*) &chunks[k].rows, 4 );
+            output.write( (const char*) chunks[k].min.data(), 4*columns.size() );
+            output.write( (const char*) chunks[k].max.data(), 4*columns.size() );
+        }
+        uint32_t nChunks = chunks.size();
+        output.write( (const char*) &indexOffset, 8 );
+        output.write( (const char*) &nChunks, 4 );
+        output.write( trailerMagic, 8 );
+        output.close();
+
+        if ( output.fail() )
+            throw std::runtime_error("Could not write result store");
+    }
+
+    if ( mapped )
+    {
+#ifndef _WIN32
+        munmap( (void*) mapped, mappedSize );
+#endif
+        fileData.clear();
+        mapped = NULL;
+        mappedSize = 0;
+    }
+}
+
+
+const std::vector<std::string>& resultStore::getColumns(  ) const
+{
+    return columns;
+}
+
+
+unsigned int resultStore::columnIndex( const std::string& name ) const
+{
+    for ( unsigned int c=0; c<columns.size(); ++c )
+        if ( columns[c] == name )
+            return c;
+
+    throw std::invalid_argument("Unknown column " + name);
+}
+
+
+uint64_t resultStore::getNumRows(  ) const
+{
+    return nRows;
+}
+
+
+unsigned int resultStore::getNumChunks(  ) const
+{
+    return chunks.size();
+}
+
+
+void resultStore::getChunkRange( unsigned int chunk, VectorXf& min, VectorXf& max ) const
+{
+    if ( chunk >= chunks.size() )
+        throw std::invalid_argument("Invalid chunk index given");
+
+    min = chunks[chunk].min;
+    max = chunks[chunk].max;
+}
+
+
+void resultStore::readChunk( unsigned int chunk, MatrixXf& rows ) const
+{
+    if ( !mapped )
+        throw std::runtime_error("Result store is not open for reading");
+    if ( chunk >= chunks.size() )
+        throw std::invalid_argument("Invalid chunk index given");
+
+    const chunkInfo& info = chunks[chunk];
+    decompressChunk( mapped + info.offset, info.size, info.rows, columns.size(), rows );
+}
+
+
+unsigned int resultStore::query( const std::vector<rangeCondition>& conditions, MatrixXf& rows ) const
+{
+    std::vector<unsigned int> index( conditions.size() );
+    for ( unsigned int j=0; j<conditions.size(); ++j )
+        index[j] = columnIndex( conditions[j].column );
+
+    std::vector<VectorXf> selected;
+    unsigned int nScanned = 0;
+    MatrixXf chunkData;
+
+    for ( unsigned int k=0; k<chunks.size(); ++k )
+    {
+        // Skip chunk if its range misses any condition
+        bool overlap = true;
+        for ( unsigned int j=0; j<conditions.size() && overlap; ++j )
+            overlap = chunks[k].max( index[j] ) >= conditions[j].lower && chunks[k].min( index[j] ) <= conditions[j].upper;
+        if ( !overlap )
+            continue;
+
+        readChunk( k, chunkData );
+        nScanned++;
+
+        for ( unsigned int r=0; r<chunkData.rows(); ++r )
+        {
+            bool match = true;
+            for ( unsigned int j=0; j<conditions.size() && match; ++j )
+                match = chunkData( r, index[j] ) >= conditions[j].lower && chunkData( r, index[j] ) <= conditions[j].upper;
+            if ( match )
+                selected.push_back( chunkData.row(r).transpose() );
+        }
+    }
+
+    rows.resize( selected.size(), columns.size() );
+    for ( unsigned int r=0; r<selected.size(); ++r )
+        rows.row(r) = selected[r].transpose();
+
+    return nScanned;
+}
+
+
+
+//
+// PRIVATE MEMBER FUNCTIONS:
+//
+
+void resultStore::flushChunk(  )
+{
+    chunkInfo info;
+    info.offset = output.tellp();
+    info.rows = nBuffered;
+    info.min = buffer.topRows( nBuffered ).colwise().minCoeff().transpose();
+    info.max = buffer.topRows( nBuffered ).colwise().maxCoeff().transpose();
+
+    std::string compressed;
+    compressChunk( buffer, nBuffered, compressed );
+    info.size = compressed.size();
+    output.write( compressed.data(), compressed.size() );
+
+    chunks.push_back( info );
+    nBuffered = 0;
+}
@@ -0,0 +1,256 @@
+/**
+ *	\file src/sampler.cpp
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#include "../header.h"    // #include header
+
+#include <cstdint>
+#include <numeric>
+
+
+// Sobol direction numbers (Joe & Kuo), dimensions 2 ... 16: degree s, coefficients a, initial m_1 ... m_s
+static const unsigned int sobolDegree[15]       = { 1, 2, 3, 3, 4, 4, 5, 5, 5, 5, 5, 5, 6, 6, 6 };
+static const unsigned int sobolCoefficient[15]  = { 0, 1, 1, 2, 1, 4, 2, 4, 7, 11, 13, 14, 1, 13, 16 };
+static const unsigned int sobolInitial[15][6]   = { { 1 },
+                                                    { 1, 3 },
+                                                    { 1, 3, 1 },
+                                                    { 1, 1, 1 },
+                                                    { 1, 1, 3, 3 },
+                                                    { 1, 3, 5, 13 },
+                                                    { 1, 1, 5, 5, 17 },
+                                                    { 1, 1, 5, 5, 5 },
+                                                    { 1, 1, 7, 11, 19 },
+                                                    { 1, 1, 5, 1, 1 },
+                                                    { 1, 1, 1, 3, 11 },
+                                                    { 1, 3, 5, 5, 31 },
+                                                    { 1, 3, 3, 9, 7, 49 },
+                                                    { 1, 1, 1, 15, 21, 21 },
+                                                    { 1, 3, 1, 13, 27, 49 } };
+
+
+//
+// PUBLIC MEMBER FUNCTIONS:
+//
+
+MatrixXd sampler::latinHypercube( unsigned int n, unsigned int dim, unsigned int seed )
+{
+    std::mt19937 generator( seed );
+    std::uniform_real_distribution<double> uniform( 0.0, 1.0 );
+
+    MatrixXd samples( n, dim );
+    std::vector<unsigned int> strata( n );
+
+    // One sample per stratum in every dimension, strata randomly paired across dimensions
+    for ( unsigned int j=0; j<dim; ++j )
+    {
+        std::iota( strata.begin(), strata.end(), 0 );
+        std::shuffle( strata.begin(), strata.end(), generator );
+
+        for ( unsigned int k=0; k<n; ++k )
+            samples(k,j) = ( strata[k] + uniform( generator ) ) / n;
+    }
+    return samples;
+}
+
+
+MatrixXd sampler::sobol( unsigned int n, unsigned int dim, unsigned int skip )
+{
+    if ( dim > 16 )
+        throw std::invalid_argument("Sobol sequence supports at most 16 dimensions");
+
+    const unsigned int L = 32;                              // Number of bits
+    std::vector<std::array<uint32_t, 32> > V( dim );        // Direction numbers
+
+    for ( unsigned int j=0; j<dim; ++j )
+    {
+        if ( j == 0 )
+        {
+            for ( unsigned int i=0; i<L; ++i )
+                V[j][i] = 1u << (L-1-i);
+            continue;
+        }
+
+        unsigned int s = sobolDegree[j-1];
+        unsigned int a = sobolCoefficient[j-1];
+
+        for ( unsigned int i=0; i<L; ++i )
+        {
+            if ( i < s )
+                V[j][i] = sobolInitial[j-1][i] << (L-1-i);
+            else
+            {
+                V[j][i] = V[j][i-s] ^ ( V[j][i-s] >> s );
+                for ( unsigned int k=1; k<s; ++k )
+                    V[j][i] ^= ( ( a >> (s-1-k) ) & 1u ) * V[j][i-k];
+            }
+        }
+    }
+
+    // Gray code construction
+    MatrixXd samples( n, dim );
+    std::vector<uint32_t> X( dim, 0 );
+
+    for ( unsigned int idx=0; idx<n+skip; ++idx )
+    {
+        if ( idx >= skip )
+            for ( unsigned int j=0; j<dim; ++j )
+                samples(idx-skip,j) = X[j] / 4294967296.0;
+
+        // Index of rightmost zero bit of idx
+        unsigned int c = 0;
+        unsigned int value = idx;
+        while ( value & 1u )
+        {
+            value >>= 1;
+            c++;
+        }
+
+        for ( unsigned int j=0; j<dim; ++j )
+            X[j] ^= V[j][c];
+    }
+    return samples;
+}
+
+
+MatrixXd sampler::scrambledSobol( unsigned int n, unsigned int dim, unsigned int seed )
+{
+    MatrixXd samples = sobol( n, dim );
+    std::mt19937 generator( seed );
+
+    for ( unsigned int j=0; j<dim; ++j )
+    {
+        uint32_t scramble = generator();
+        for ( unsigned int k=0; k<n; ++k )
+        {
+            // Hash-based nested uniform scramble (Laine-Karras permutation on the reversed bits):
+            // every digit is flipped depending on the digits above it
+            uint32_t x = reverseBits( (uint32_t) ( samples(k,j) * 4294967296.0 ) );
+            x += scramble;
+            x ^= x * 0x6c50b47cu;
+            x ^= x * 0xb82f1e52u;
+            x ^= x * 0xc7afe638u;
+            x ^= x * 0x8d22f6e6u;
+            samples(k,j) = ( reverseBits( x ) + 0.5 ) / 4294967296.0;
+        }
+    }
+    return samples;
+}
+
+
+MatrixXd sampler::smolyak( unsigned int dim, unsigned int level, VectorXd& weights )
+{
+    if ( dim == 0 || level == 0 )
+        throw std::invalid_argument("Sparse grid dimension and level must be positive");
+
+    // All points lie on the finest Clenshaw-Curtis grid of the given level
+    unsigned int q = dim + level - 1;
+    int mFine = ( level == 1 ) ? 1 : ( 1 << (level-1) ) + 1;
+
+    std::vector<VectorXd> ruleWeights( level+1 );
+    for ( unsigned int l=1; l<=level; ++l )
+        ruleWeights[l] = clenshawCurtisWeights( l );
+
+    std::map<std::vector<int>, double> grid;
+
+    // Combination technique over multi-indices i (i_k >= 1, q-dim+1 <= |i| <= q)
+    std::vector<unsigned int> index( dim, 1 );
+    while ( true )
+    {
+        unsigned int norm = std::accumulate( index.begin(), index.end(), 0u );
+
+        if ( norm + dim > q )       // norm >= q-dim+1 (note dim <= q)
+        {
+            unsigned int r = q - norm;
+            double coefficient = ( r % 2 == 0 ) ? 1.0 : -1.0;
+            for ( unsigned int k=0; k<r; ++k )          // binomial(dim-1, r)
+                coefficient *= (double) (dim-1-k) / (k+1);
+
+            // Tensor product of 1D rules
+            std::vector<unsigned int> point( dim, 0 );
+            while ( true )
+            {
+                std::vector<int> key( dim );
+                double w = coefficient;
+                for ( unsigned int k=0; k<dim; ++k )
+                {
+                    unsigned int l = index[k];
+                    key[k] = ( l == 1 ) ? (mFine-1)/2 : point[k] << (level-l);
+                    w *= ruleWeights[l]( point[k] );
+                }
+                grid[key] += w;
+
+                // Next point of tensor grid
+                unsigned int k = 0;
+                while ( k < dim && ++point[k] == ruleWeights[index[k]].size() )
+                    point[k++] = 0;
+                if ( k == dim )
+                    break;
+            }
+        }
+
+        // Next multi-index with |i| <= q
+        unsigned int k = 0;
+        while ( k < dim )
+        {
+            index[k]++;
+            if ( std::accumulate( index.begin(), index.end(), 0u ) <= q )
+                break;
+            index[k++] = 1;
+        }
+        if ( k == dim )
+            break;
+    }
+
+    MatrixXd points( grid.size(), dim );
+    weights.resize( grid.size() );
+
+    unsigned int i = 0;
+    for ( std::map<std::vector<int>, double>::iterator it=grid.begin(); it!=grid.end(); ++it, ++i )
+    {
+        for ( unsigned int k=0; k<dim; ++k )
+            points(i,k) = ( mFine == 1 ) ? 0.5 : 0.5*( 1.0 - cos( M_PI*it->first[k]/(mFine-1) ) );
+        weights(i) = it->second;
+    }
+    return points;
+}
+
+
+
+//
+// PRIVATE MEMBER FUNCTIONS:
+//
+
+VectorXd sampler::clenshawCurtisWeights( unsigned int level )
+{
+    if ( level == 1 )
+        return VectorXd::Ones( 1 );
+
+    unsigned int n = 1 << (level-1);
+    VectorXd w( n+1 );
+
+    for ( unsigned int j=0; j<=n; ++j )
+    {
+        double sum = 0.0;
+        for ( unsigned int k=1; k<=n/2; ++k )
+        {
+            double b = ( 2*k == n ) ? 1.0 : 2.0;
+            sum += b / (4.0*k*k - 1.0) * cos( 2.0*k*j*M_PI/n );
+        }
+        double c = ( j == 0 || j == n ) ? 1.0 : 2.0;
+        w(j) = 0.5 * c/n * ( 1.0 - sum );
+    }
+    return w;
+}
+
+
+uint32_t sampler::reverseBits( uint32_t x )
+{
+    x = ( ( x >> 1 ) & 0x55555555u ) | ( ( x & 0x55555555u ) << 1 );
+    x = ( ( x >> 2 ) & 0x33333333u ) | ( ( x & 0x33333333u ) << 2 );
+    x = ( ( x >> 4 ) & 0x0f0f0f0fu ) | ( ( x & 0x0f0f0f0fu ) << 4 );
+    x = ( ( x >> 8 ) & 0x00ff00ffu ) | ( ( x & 0x00ff00ffu ) << 8 );
+    return ( x >> 16 ) | ( x << 16 );
+}
@@ -12,10 +12,12 @@
 // PUBLIC MEMBER FUNCTIONS:
 //
 
-saturator::saturator(  ){}
+template <class Scalar>
+scalarSaturator<Scalar>::scalarSaturator(  ){}
 
 
-saturator::saturator( unsigned int _nU, float _samplingTime )
+template <class Scalar>
+scalarSaturator<Scalar>::scalarSaturator( unsigned int _nU, float _samplingTime )
 {   
     lowerLimitControls = VectorXf::Ones( _nU )*1000000;
     upperLimitControls = VectorXf::Ones( _nU )*1000000;
@@ -28,11 +30,13 @@ saturator::saturator( unsigned int _nU, float _samplingTime )
 
     nU = _nU;
     samplingTime = _samplingTime;
-    lastU = VectorXf::Zero( _nU );
+    lastU = VectorX<Scalar>::Zero( _nU );
+    saturated = false;
 }
 
 
-saturator::saturator( const saturator& rhs )
+template <class Scalar>
+scalarSaturator<Scalar>::scalarSaturator( const scalarSaturator& rhs )
 {
     lowerLimitControls = rhs.lowerLimitControls;
     upperLimitControls = rhs.upperLimitControls;
@@ -42,18 +46,45 @@ saturator::saturator( const saturator& rhs )
 
     bias = rhs.bias;
     noiseLevel = rhs.noiseLevel;
+    generator = rhs.generator;
+    antithetic = rhs.antithetic;
 
     nU = rhs.nU;
     samplingTime = rhs.samplingTime;
     lastU = rhs.lastU;
+    saturated = rhs.saturated;
 }
 
 
-saturator::~saturator(  ){}
+template <class Scalar>
+template <class Other>
+scalarSaturator<Scalar>::scalarSaturator( const scalarSaturator<Other>& rhs )
+{
+    lowerLimitControls = rhs.lowerLimitControls;
+    upperLimitControls = rhs.upperLimitControls;
+
+    lowerRateLimitControls = rhs.lowerRateLimitControls;
+    upperRateLimitControls = rhs.upperRateLimitControls;
+
+    bias = rhs.bias;
+    noiseLevel = rhs.noiseLevel;
+    generator = rhs.generator;
+    antithetic = rhs.antithetic;
+
+    nU = rhs.nU;
+    samplingTime = rhs.samplingTime;
+    lastU = rhs.lastU.template cast<Scalar>();
+    saturated = rhs.saturated;
+}
+
 
+template <class Scalar>
+scalarSaturator<Scalar>::~scalarSaturator(  ){}
 
 
-void saturator::setControlLowerLimit( const VectorXf& _lowerLimit )
+
+template <class Scalar>
+void scalarSaturator<Scalar>::setControlLowerLimit( const VectorXf& _lowerLimit )
 {
     if ( _lowerLimit.size() != nU )
         throw std::invalid_argument("Incorrect number of control limits given");
@@ -61,7 +92,8 @@ void saturator::setControlLowerLimit( const VectorXf& _lowerLimit )
     lowerLimitControls = _lowerLimit;
 }
 
-void saturator::setControlLowerLimit( unsigned int idx, float _lowerLimit )
+template <class Scalar>
+void scalarSaturator<Scalar>::setControlLowerLimit( unsigned int idx, float _lowerLimit )
 {
     if ( idx >= nU )
         throw std::invalid_argument("Invalid index for control signal given");
@@ -69,7 +101,8 @@ void saturator::setControlLowerLimit( unsigned int idx, float _lowerLimit )
     lowerLimitControls( idx ) = _lowerLimit;
 }
 
-void saturator::setControlUpperLimit( const VectorXf& _upperLimit )
+template <class Scalar>
+void scalarSaturator<Scalar>::setControlUpperLimit( const VectorXf& _upperLimit )
 {
     if ( _upperLimit.size() != nU )
         throw std::invalid_argument("Incorrect number of control limits given");
@@ -77,7 +110,8 @@ void saturator::setControlUpperLimit( const VectorXf& _upperLimit )
     upperLimitControls = _upperLimit;
 }
 
-void saturator::setControlUpperLimit( unsigned int idx, float _upperLimit )
+template <class Scalar>
+void scalarSaturator<Scalar>::setControlUpperLimit( unsigned int idx, float _upperLimit )
 {
     if ( idx >= nU )
         throw std::invalid_argument("Invalid index for control signal given");
@@ -86,7 +120,8 @@ void saturator::setControlUpperLimit( unsigned int idx, float _upperLimit )
 }
 
 
-void saturator::setControlLowerRateLimit( const VectorXf& _lowerRateLimit )
+template <class Scalar>
+void scalarSaturator<Scalar>::setControlLowerRateLimit( const VectorXf& _lowerRateLimit )
 {
     if ( _lowerRateLimit.size() != nU )
         throw std::invalid_argument("Incorrect number of control rate limits given");
@@ -94,7 +129,8 @@ void saturator::setControlLowerRateLimit( const VectorXf& _lowerRateLimit )
     lowerRateLimitControls = _lowerRateLimit;
 }
 
-void saturator::setControlLowerRateLimit( unsigned int idx, float _lowerRateLimit )
+template <class Scalar>
+void scalarSaturator<Scalar>::setControlLowerRateLimit( unsigned int idx, float _lowerRateLimit )
 {
     if ( idx >= nU )
         throw std::invalid_argument("Invalid index for control signal given");
@@ -102,7 +138,8 @@ void saturator::setControlLowerRateLimit( unsigned int idx, float _lowerRateLimi
     lowerRateLimitControls( idx ) = _lowerRateLimit;
 }
 
-void saturator::setControlUpperRateLimit( const VectorXf& _upperRateLimit )
+template <class Scalar>
+void scalarSaturator<Scalar>::setControlUpperRateLimit( const VectorXf& _upperRateLimit )
 {
     if ( _upperRateLimit.size() != nU )
         throw std::invalid_argument("Incorrect number of control rate limits given");
@@ -110,7 +147,8 @@ void saturator::setControlUpperRateLimit( const VectorXf& _upperRateLimit )
     upperRateLimitControls = _upperRateLimit;
 }
 
-void saturator::setControlUpperRateLimit( unsigned int idx, float _upperRateLimit )
+template <class Scalar>
+void scalarSaturator<Scalar>::setControlUpperRateLimit( unsigned int idx, float _upperRateLimit )
 {
     if ( idx >= nU )
         throw std::invalid_argument("Invalid index for control signal given");
@@ -119,20 +157,108 @@ void saturator::setControlUpperRateLimit( unsigned int idx, float _upperRateLimi
 }
 
 
-void saturator::setBias( const VectorXf& _bias )
+template <class Scalar>
+void scalarSaturator<Scalar>::setBias( const VectorXf& _bias )
 {
     bias = _bias;
 }
 
-void saturator::setNoise( const VectorXf& _noiseLevel )
+template <class Scalar>
+void scalarSaturator<Scalar>::setNoise( const VectorXf& _noiseLevel )
 {
     noiseLevel = _noiseLevel;
 }
 
+template <class Scalar>
+void scalarSaturator<Scalar>::setBias( unsigned int idx, float _bias )
+{
+    if ( idx >= nU )
+        throw std::invalid_argument("Invalid index for control signal given");
+
+    bias( idx ) = _bias;
+}
+
+template <class Scalar>
+void scalarSaturator<Scalar>::setNoise( unsigned int idx, float _noiseLevel )
+{
+    if ( idx >= nU )
+        throw std::invalid_argument("Invalid index for control signal given");
+
+    noiseLevel( idx ) = _noiseLevel;
+}
+
+template <class Scalar>
+void scalarSaturator<Scalar>::setSeed( unsigned int _seed )
+{
+    generator.seed( _seed );
+}
+
+template <class Scalar>
+void scalarSaturator<Scalar>::setAntithetic( bool _antithetic )
+{
+    antithetic = _antithetic;
+}
+
+template <class Scalar>
+bool scalarSaturator<Scalar>::isNoisy(  ) const
+{
+    return noiseLevel.size() > 0 && !noiseLevel.isZero( 0 );
+}
+
+template <class Scalar>
+std::string scalarSaturator<Scalar>::getGeneratorState(  ) const
+{
+    std::ostringstream stream;
+    stream << generator;
+    return stream.str();
+}
+
+template <class Scalar>
+void scalarSaturator<Scalar>::setGeneratorState( const std::string& _state )
+{
+    std::istringstream stream( _state );
+    stream >> generator;
+
+    if ( stream.fail() )
+        throw std::invalid_argument("Invalid noise generator state given");
+}
+
 
-void saturator::resetSaturator(  )
+template <class Scalar>
+void scalarSaturator<Scalar>::hashConfiguration( configHash& hash ) const
 {
-    lastU = VectorXf::Zero( nU );
+    hash.add( (unsigned int) sizeof( Scalar ) );
+    hash.add( nU );
+    hash.add( samplingTime );
+    hash.add( lowerLimitControls );
+    hash.add( upperLimitControls );
+    hash.add( lowerRateLimitControls );
+    hash.add( upperRateLimitControls );
+    hash.add( bias );
+    hash.add( noiseLevel );
+    hash.add( lastU );
+
+    // Result only depends on generator when noise is active
+    if ( isNoisy() )
+    {
+        hash.add( getGeneratorState() );
+        hash.add( (unsigned int) antithetic );
+    }
+}
+
+
+template <class Scalar>
+bool scalarSaturator<Scalar>::isSaturated(  ) const
+{
+    return saturated;
+}
+
+
+template <class Scalar>
+void scalarSaturator<Scalar>::resetSaturator(  )
+{
+    lastU = VectorX<Scalar>::Zero( nU );
+    saturated = false;
 }
 
 
@@ -141,45 +267,69 @@ void saturator::resetSaturator(  )
 // PROTECTED MEMBER FUNCTIONS:
 //
 
-void saturator::saturate( VectorXf& _u )
+template <class Scalar>
+void scalarSaturator<Scalar>::saturate( VectorX<Scalar>& _u )
 {   
     // consistency check
     if ( _u.size() != nU )
         throw std::invalid_argument("Incorrect number of control signals given");
 
     // Set upper and lower bounds
-    VectorXf Uub( upperLimitControls );
-    VectorXf Ulb( lowerLimitControls );
+    VectorX<Scalar> Uub( upperLimitControls.cast<Scalar>() );
+    VectorX<Scalar> Ulb( lowerLimitControls.cast<Scalar>() );
+    Scalar h = samplingTime;
 
     for ( unsigned int i=0; i<nU; ++i )
     {
-        if (lastU(i) + samplingTime*lowerRateLimitControls(i) > Ulb(i))
-            Ulb(i) = lastU(i) + samplingTime*lowerRateLimitControls(i);
-        if (lastU(i) + samplingTime*upperRateLimitControls(i) < Uub(i))
-            Uub(i) = lastU(i) + samplingTime*upperRateLimitControls(i);
+        if (lastU(i) + h*Scalar( lowerRateLimitControls(i) ) > Ulb(i))
+            Ulb(i) = lastU(i) + h*Scalar( lowerRateLimitControls(i) );
+        if (lastU(i) + h*Scalar( upperRateLimitControls(i) ) < Uub(i))
+            Uub(i) = lastU(i) + h*Scalar( upperRateLimitControls(i) );
     }
 
     // Update control input
+    saturated = false;
     for ( unsigned int i=0; i<nU; ++i )
     {
         if (_u(i) > Uub(i))
+        {
             _u(i) = Uub(i);
+            saturated = true;
+        }
         if (_u(i) < Ulb(i))
+        {
             _u(i) = Ulb(i);
+            saturated = true;
+        }
     }
     lastU = _u;
 
+    std::uniform_int_distribution<int> noise( 0, 200 );
+
     for ( unsigned int i=0; i<nU; i++ )
     { 
         // Add bias 
-        _u(i) = _u(i) + bias(i);
+        _u(i) = _u(i) + Scalar( bias(i) );
         
-        if (_u(i) < lowerLimitControls(i))
+        if (_u(i) < Scalar( lowerLimitControls(i) ))
             _u(i) = lowerLimitControls(i);
-        if (_u(i) > upperLimitControls(i))
+        if (_u(i) > Scalar( upperLimitControls(i) ))
             _u(i) = upperLimitControls(i);
         
         // Add noise
-        _u(i) = _u(i)*(1+ noiseLevel(i)*( rand() % 201 - 100.0) / 100.0);
+        int draw = antithetic ? 200 - noise( generator ) : noise( generator );
+        _u(i) = _u(i)*(1+ Scalar( noiseLevel(i) )*( draw - 100 ) / Scalar( 100 ));
     }
-}
\ No newline at end of file
+}
+
+
+
+//
+// EXPLICIT INSTANTIATIONS:
+//
+
+template class scalarSaturator<float>;
+template class scalarSaturator<double>;
+
+template scalarSaturator<float>::scalarSaturator( const scalarSaturator<double>& );
+template scalarSaturator<double>::scalarSaturator( const scalarSaturator<float>& );
@@ -0,0 +1,333 @@
+/**
+ *	\file src/scenario.cpp
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#include "../header.h"    // #include header
+
+#include <atomic>
+#include <thread>
+
+
+/** Remove leading and trailing white space
+ */
+static string trim( const string& str )
+{
+    size_t first = str.find_first_not_of( " \t\r" );
+    if ( first == string::npos )
+        return "";
+    size_t last = str.find_last_not_of( " \t\r" );
+    return str.substr( first, last-first+1 );
+}
+
+
+//
+// PUBLIC MEMBER FUNCTIONS:
+//
+
+scenarioRunner::scenarioRunner(  ){}
+
+
+scenarioRunner::~scenarioRunner(  ){}
+
+
+void scenarioRunner::load( const std::string& fileName )
+{
+    ifstream File( fileName );
+    if ( !File.is_open() )
+        throw std::invalid_argument("Unable to open scenario file " + fileName);
+
+    settings defaults;
+    settings* current = NULL;
+    string line;
+    unsigned int lineNumber = 0;
+
+    // First pass collects sections, defaults are merged afterwards
+    std::vector<settings> sections;
+    std::vector<string> sectionNames;
+
+    while ( getline( File, line ) )
+    {
+        lineNumber++;
+        line = trim( line.substr( 0, line.find( '#' ) ) );
+        if ( line.empty() )
+            continue;
+
+        if ( line[0] == '[' )
+        {
+            if ( line.back() != ']' )
+                throw std::invalid_argument("Invalid section header in line " + to_string( lineNumber ));
+
+            string name = trim( line.substr( 1, line.size()-2 ) );
+            if ( name == "defaults" )
+                current = &defaults;
+            else
+            {
+                sectionNames.push_back( name );
+                sections.push_back( settings() );
+                current = &sections.back();
+            }
+            continue;
+        }
+
+        size_t pos = line.find( '=' );
+        if ( pos == string::npos || current == NULL )
+            throw std::invalid_argument("Invalid scenario setting in line " + to_string( lineNumber ));
+
+        (*current)[ trim( line.substr( 0, pos ) ) ] = trim( line.substr( pos+1 ) );
+    }
+
+    for ( unsigned int i=0; i<sections.size(); ++i )
+    {
+        settings scenario = defaults;
+        for ( settings::const_iterator it=sections[i].begin(); it!=sections[i].end(); ++it )
+            scenario[it->first] = it->second;
+
+        names.push_back( sectionNames[i] );
+        scenarios.push_back( scenario );
+    }
+}
+
+
+void scenarioRunner::run( unsigned int nThreads )
+{
+    // Per-scenario runs, built from prototypes shared by identical configurations (per plant model)
+    std::vector<std::function<void()> > runs( scenarios.size() );
+
+    std::map<uint64_t, std::pair<PIDcontroller, dynamics> > rocketPrototypes;
+    std::map<uint64_t, std::pair<PIDcontroller, plantDynamics<poweredAscentModel> > > poweredAscentPrototypes;
+
+    for ( unsigned int k=0; k<scenarios.size(); ++k )
+    {
+        string model = getString( scenarios[k], "model", "rocket" );
+
+        if ( model == "rocket" )
+            runs[k] = createRun( k, rocketPrototypes );
+        else if ( model == "poweredAscent" )
+            runs[k] = createRun( k, poweredAscentPrototypes );
+        else
+            throw std::invalid_argument("Unknown plant model " + model + " in scenario " + names[k]);
+    }
+
+    unsigned int nPrototypes = rocketPrototypes.size() + poweredAscentPrototypes.size();
+    logger::info( "Running ", scenarios.size(), " scenarios (", nPrototypes, " distinct configurations)" );
+
+    // Run scenarios on thread pool
+    if ( nThreads == 0 )
+        nThreads = std::max( 1u, std::thread::hardware_concurrency() );
+
+    std::atomic<unsigned int> next( 0 );
+    std::vector<string> errors( scenarios.size() );
+    std::vector<std::thread> pool;
+    progressCounter progress( "Scenarios", scenarios.size() );
+
+    for ( unsigned int t=0; t<nThreads; ++t )
+    {
+        pool.push_back( std::thread( [&]()
+        {
+            unsigned int k;
+            while ( ( k = next++ ) < scenarios.size() )
+            {
+                try
+                {
+                    runs[k]();
+                }
+                catch ( const std::exception& e )
+                {
+                    errors[k] = e.what();
+                }
+                progress.advance();
+            }
+        } ) );
+    }
+    for ( unsigned int t=0; t<pool.size(); ++t )
+        pool[t].join();
+
+    // Report failed scenarios
+    unsigned int nFailed = 0;
+    for ( unsigned int k=0; k<scenarios.size(); ++k )
+    {
+        if ( !errors[k].empty() )
+        {
+            logger::error( "Scenario ", names[k], " failed: ", errors[k] );
+            nFailed++;
+        }
+    }
+    logger::flush();
+    if ( nFailed > 0 )
+        throw std::runtime_error( to_string( nFailed ) + " scenarios failed" );
+}
+
+
+unsigned int scenarioRunner::size(  ) const
+{
+    return scenarios.size();
+}
+
+
+
+//
+// PRIVATE MEMBER FUNCTIONS:
+//
+
+template <class Model>
+std::function<void()> scenarioRunner::createRun( unsigned int k,
+                                                 std::map<uint64_t, std::pair<PIDcontroller, plantDynamics<Model> > >& prototypes )
+{
+    const settings& scenario = scenarios[k];
+
+    string type = getString( scenario, "type", "simulate" );
+    float simulationTime = getFloat( scenario, "simulationTime", 20.0 );
+    VectorXf initState = getVector( scenario, "initState" );
+
+    if ( type != "simulate" && type != "tune" && type != "robustness" )
+        throw std::invalid_argument("Unknown scenario type " + type + " in scenario " + names[k]);
+
+    float samplingTime = getFloat( scenario, "samplingTime", 0.05 );
+    unsigned int nx = initState.size();
+    unsigned int ny = Model::NY;
+    unsigned int nu = Model::NU;
+
+    // Hash of controller and plant configuration
+    configHash hash;
+    for ( settings::const_iterator it=scenario.begin(); it!=scenario.end(); ++it )
+    {
+        if ( it->first == "type" || it->first == "simulationTime" || it->first == "output" ||
+             it->first == "journal" || it->first == "cache" )
+            continue;
+        hash.add( it->first );
+        hash.add( it->second );
+    }
+
+    if ( prototypes.find( hash.value() ) == prototypes.end() )
+    {
+        /* Controller */
+        PIDcontroller PID( ny, nu, samplingTime );
+
+        PID.setProportionalGains( getVector( scenario, "pGains" ) );
+        PID.setIntegralGains( getVector( scenario, "iGains" ) );
+        PID.setDerivativeGains( getVector( scenario, "dGains" ) );
+
+        PID.setControlLowerLimit( getVector( scenario, "lowerLimit" ) );
+        PID.setControlUpperLimit( getVector( scenario, "upperLimit" ) );
+        PID.setControlLowerRateLimit( getVector( scenario, "lowerRateLimit" ) );
+        PID.setControlUpperRateLimit( getVector( scenario, "upperRateLimit" ) );
+
+        PID.setBias( getVector( scenario, "actuatorBias", VectorXf::Zero( nu ) ) );
+        PID.setNoise( getVector( scenario, "actuatorNoise", VectorXf::Zero( nu ) ) );
+
+        if ( scenario.count( "reference" ) )
+            PID.setReference( getReference( scenario ) );
+
+        /* System dynamics */
+        plantDynamics<Model> Rocket( nx, nu, ny, initState, samplingTime, getFloat( scenario, "initTime", 0.0 ) );
+
+        Rocket.setBias( getVector( scenario, "sensorBias", VectorXf::Zero( ny ) ) );
+        Rocket.setNoise( getVector( scenario, "sensorNoise", VectorXf::Zero( ny ) ) );
+        Rocket.setIntegrator( getString( scenario, "integrator", classicalRungeKutta4::NAME ) );
+
+        if ( scenario.count( "seed" ) )
+        {
+            unsigned int seed = stoul( scenario.at( "seed" ) );
+            Rocket.setSeed( seed );
+            PID.setSeed( seed+1 );
+        }
+
+        prototypes[hash.value()] = std::make_pair( PID, Rocket );
+    }
+
+    std::pair<PIDcontroller, plantDynamics<Model> >& prototype = prototypes.at( hash.value() );
+    std::shared_ptr<closedLoopSimulator<Model, float> > sim =
+        std::make_shared<closedLoopSimulator<Model, float> >( nx, nu, ny, prototype.first, prototype.second, samplingTime );
+    sim->setOutputPrefix( getString( scenario, "output", "../data/" + names[k] + "_" ) );
+    sim->setJournal( getString( scenario, "journal", "" ) );
+    sim->setCache( getString( scenario, "cache", "" ) );
+
+    std::vector<std::string> metricNames;
+    std::istringstream metricStream( getString( scenario, "metrics", "" ) );
+    std::string metricName;
+    while ( metricStream >> metricName )
+        metricNames.push_back( metricName );
+    sim->setMetrics( metricNames );
+
+    return [sim, type, simulationTime, initState]()
+    {
+        if ( type == "simulate" )
+            sim->simulate( simulationTime, true );
+        else if ( type == "tune" )
+            sim->tune();
+        else
+            sim->robustness( initState );
+    };
+}
+
+
+std::string scenarioRunner::getString( const settings& scenario, const std::string& key, const std::string& defaultValue ) const
+{
+    settings::const_iterator it = scenario.find( key );
+    return ( it == scenario.end() ) ? defaultValue : it->second;
+}
+
+
+float scenarioRunner::getFloat( const settings& scenario, const std::string& key, float defaultValue ) const
+{
+    settings::const_iterator it = scenario.find( key );
+    return ( it == scenario.end() ) ? defaultValue : stof( it->second );
+}
+
+
+VectorXf scenarioRunner::getVector( const settings& scenario, const std::string& key ) const
+{
+    settings::const_iterator it = scenario.find( key );
+    if ( it == scenario.end() )
+        throw std::invalid_argument("Missing scenario setting " + key);
+
+    std::vector<float> values;
+    std::istringstream stream( it->second );
+    float value;
+    while ( stream >> value )
+        values.push_back( value );
+
+    return Map<VectorXf>( values.data(), values.size() );
+}
+
+
+VectorXf scenarioRunner::getVector( const settings& scenario, const std::string& key, const VectorXf& defaultValue ) const
+{
+    if ( scenario.find( key ) == scenario.end() )
+        return defaultValue;
+    return getVector( scenario, key );
+}
+
+
+std::shared_ptr<const referenceTrajectory> scenarioRunner::getReference( const settings& scenario )
+{
+    string fileName = getString( scenario, "reference", "" );
+    string fit = getString( scenario, "referenceFit", "chebyshev 12" );
+    VectorXf timing = getVector( scenario, "referenceTime" );          // start time, time step
+
+    string key = fileName + "|" + fit + "|" + to_string( timing(0) ) + "|" + to_string( timing(1) );
+    if ( references.count( key ) )
+        return references[key];
+
+    MatrixXf data = loadFromFile( fileName );
+    VectorXf t = VectorXf::LinSpaced( data.cols(), timing(0), timing(0) + (data.cols()-1)*timing(1) );
+
+    string method;
+    unsigned int order;
+    std::istringstream stream( fit );
+    stream >> method >> order;
+
+    std::shared_ptr<referenceTrajectory> ref = std::make_shared<referenceTrajectory>(  );
+    if ( method == "chebyshev" )
+        ref->fitChebyshev( t, data, order );
+    else if ( method == "spline" )
+        ref->fitSpline( t, data, order );
+    else
+        throw std::invalid_argument("Unknown reference fit " + fit);
+
+    references[key] = ref;
+    return ref;
+}
@@ -0,0 +1,93 @@
+/**
+ *	\file src/scheduler.cpp
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#include "../header.h"    // #include header
+
+#include <numeric>
+
+
+//
+// PUBLIC MEMBER FUNCTIONS:
+//
+
+multiRateScheduler::multiRateScheduler(  ){}
+
+
+multiRateScheduler::~multiRateScheduler(  ){}
+
+
+void multiRateScheduler::addTask( const std::string& name, unsigned long rateNum, unsigned long rateDen,
+                                  std::function<void( double )> task )
+{
+    if ( rateNum == 0 || rateDen == 0 )
+        throw std::invalid_argument("Task rate must be positive");
+
+    unsigned long d = std::gcd( rateNum, rateDen );
+
+    names.push_back( name );
+    rateNums.push_back( rateNum/d );
+    rateDens.push_back( rateDen/d );
+    tasks.push_back( task );
+    executions.push_back( 0 );
+}
+
+
+void multiRateScheduler::run( double startTime, double duration )
+{
+    unsigned int nTasks = tasks.size();
+    if ( nTasks == 0 )
+        return;
+
+    // Base tick is the gcd of all periods rateDen/rateNum: gcd(rateDen) / lcm(rateNum)
+    unsigned long lcmNum = 1, gcdDen = 0;
+    for ( unsigned int i=0; i<nTasks; ++i )
+    {
+        lcmNum = std::lcm( lcmNum, rateNums[i] );
+        gcdDen = std::gcd( gcdDen, rateDens[i] );
+    }
+    double tick = (double) gcdDen / lcmNum;
+
+    // Periods in integer ticks
+    std::vector<unsigned long> period( nTasks );
+    std::vector<unsigned long> next( nTasks, 0 );
+    for ( unsigned int i=0; i<nTasks; ++i )
+    {
+        period[i] = ( rateDens[i] / gcdDen ) * ( lcmNum / rateNums[i] );
+        executions[i] = 0;
+    }
+
+    unsigned long lastTick = (unsigned long) floor( duration/tick + 1e-9 );
+
+    // Visit only ticks at which a task is due
+    while ( true )
+    {
+        unsigned long now = *std::min_element( next.begin(), next.end() );
+        if ( now >= lastTick )
+            break;
+
+        double t = startTime + now*tick;
+        for ( unsigned int i=0; i<nTasks; ++i )
+        {
+            if ( next[i] == now )
+            {
+                tasks[i]( t );
+                executions[i]++;
+                next[i] += period[i];
+            }
+        }
+    }
+}
+
+
+unsigned long multiRateScheduler::getExecutions( const std::string& name ) const
+{
+    for ( unsigned int i=0; i<names.size(); ++i )
+        if ( names[i] == name )
+            return executions[i];
+
+    throw std::invalid_argument("Unknown task " + name);
+}
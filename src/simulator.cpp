@@ -7,20 +7,28 @@
 
 #include "../header.h"    // #include header
 
+#include <chrono>
+
+#ifdef __linux__
+#include <dlfcn.h>
+#endif
+
 
 //
 // PUBLIC MEMBER FUNCTIONS:
 //
 
-simulator::simulator(  ){}
+template <class Model, class Scalar>
+closedLoopSimulator<Model, Scalar>::closedLoopSimulator(  ){}
 
 
-simulator::simulator(   unsigned int _nx,
-                        unsigned int _nu,
-                        unsigned int _ny,
-                        PIDcontroller& controller,
-                        dynamics& system,
-                        float _samplingTime )
+template <class Model, class Scalar>
+closedLoopSimulator<Model, Scalar>::closedLoopSimulator(   unsigned int _nx,
+                                                    unsigned int _nu,
+                                                    unsigned int _ny,
+                                                    scalarPIDcontroller<Scalar>& controller,
+                                                    plantDynamics<Model, Scalar>& system,
+                                                    float _samplingTime )
 {
     nx = _nx;
     nu = _nu;
@@ -33,130 +41,399 @@ simulator::simulator(   unsigned int _nx,
 }
 
 
-void simulator::simulate( float simulationTime, bool saveData )
-{   
-    // Simulation points
+template <class Model, class Scalar>
+void closedLoopSimulator<Model, Scalar>::simulate( float simulationTime, bool saveData )
+{
+    closedLoop( simulationTime, saveData, NULL, 1 );
+}
+
+
+template <class Model, class Scalar>
+float closedLoopSimulator<Model, Scalar>::simulateInto( float simulationTime, float* metricValues, float* trajectory, unsigned int decimation )
+{
+    if ( decimation == 0 )
+        throw std::invalid_argument("Trajectory decimation must be positive");
+
+    if ( trajectory )
+    {
+        Map<MatrixXf> states( trajectory, nx, trajectorySamples( simulationTime, decimation ) );
+        closedLoop( simulationTime, false, &states, decimation );
+    }
+    else
+        closedLoop( simulationTime, false, NULL, decimation );
+
+    if ( metricValues )
+    {
+        Map<VectorXf> values( metricValues, metrics.size() );
+        VectorXf tmp;
+        metrics.getValues( tmp );
+        values = tmp;
+    }
+    return apogee.value();
+}
+
+
+template <class Model, class Scalar>
+unsigned int closedLoopSimulator<Model, Scalar>::trajectorySamples( float simulationTime, unsigned int decimation ) const
+{
     int Nsim = (int) simulationTime/Rocket.samplingTime;
+    return Nsim/decimation + 1;
+}
+
+
+
+template <class Model, class Scalar>
+void closedLoopSimulator<Model, Scalar>::simulateMultiRate( float simulationTime, unsigned int plantRate, const VectorXi& sensorRates,
+                                   unsigned int actuatorRate, unsigned int controllerRate, bool saveData )
+{
+    if ( sensorRates.size() != ny )
+        throw std::invalid_argument("Number of sensor rates does not match number of outputs");
+    if ( std::abs( controllerRate*samplingTime - 1.0 ) > 1e-4 )
+        throw std::invalid_argument("Controller rate does not match controller sampling time");
+
+    // Plant step of this run, restored on return (also when a task throws)
+    struct samplingTimeGuard
+    {
+        plantDynamics<Model, Scalar>& plant;
+        float samplingTime;
+        ~samplingTimeGuard(  ) { plant.samplingTime = samplingTime; }
+    } guard = { Rocket, Rocket.samplingTime };
+    Rocket.samplingTime = 1.0/plantRate;
+
+    // Held signals
+    VectorX<Scalar> y = Rocket.getOutput();
+    VectorX<Scalar> command = VectorX<Scalar>::Zero( nu );
+    VectorX<Scalar> u = VectorX<Scalar>::Zero( nu );
+    VectorX<Scalar> lastU = VectorX<Scalar>::Zero( nu );
+    Scalar omega = 0.0;
+
+    // Data saving at controller rate
+    int Nsim = (int) round( simulationTime*controllerRate );
+    int k = 0;
 
-    // Determine data saving
     if (saveData)
-    {        
-        X = MatrixXf::Zero(nx+1, Nsim+1); X(seq(0, nx-1), 0) = Rocket.state;
-        Y = MatrixXf::Zero(ny, Nsim+1); X(0, 0) = Rocket.state[1]; X(1, 0) = Rocket.state[3];
-        U = MatrixXf::Zero(1, Nsim+1); U(0, 0) = 0.0;
+    {
+        X = MatrixXf::Zero(nx+1, Nsim+1); X(seq(0, nx-1), 0) = Rocket.getState().template cast<float>();
+        Y = MatrixXf::Zero(ny, Nsim+1); Y(seq(0, ny-1), 0) = y.template cast<float>();
+        U = MatrixXf::Zero(1, Nsim+1);
     }
-    else
-        X = MatrixXf::Zero(1, Nsim+1); X(0, 0) = Rocket.state(1);
 
-    // Control and output vectors
-    VectorXf u;
-    VectorXf y(ny); y << Rocket.state[1], Rocket.state[3];
-    
     // Initialize controller
-    PID.init( y, Rocket.time );
+    PID.init( y, Rocket.getTime() );
 
-    // Run closed-loop simulation
-    for (int i = 0; i < Nsim; ++i)
+    // Initialize streaming metrics with the initial state
+    VectorX<Scalar> e = VectorX<Scalar>::Zero( ny );
+    apogee.reset();
+    metrics.reset();
+    updateMetrics( Rocket.getTime(), 0.0f, y, u, e, omega, false );
+
+    // Components in order of execution within one instant
+    multiRateScheduler scheduler;
+
+    for ( unsigned int i=0; i<ny; ++i )
     {
-        PID.step( Rocket.time, y );
-        PID.getU( u );
-        Rocket.step( u,y );
+        scheduler.addTask( "sensor" + std::to_string( i ), sensorRates(i), 1, [&, i]( double /*t*/ )
+        {
+            y(i) = Rocket.measure( i );
+        } );
+    }
+
+    auto store = [&](  )
+    {
+        updateMetrics( Rocket.getTime(), samplingTime, y, command, e, omega, PID.isSaturated() );
 
         if (saveData)
         {
-            // Store data
-            X(seq(0, nx-1), i+1) = Rocket.state;
-            X(nx, i+1) = Rocket.omega;
-            Y(seq(0, ny-1), i+1) = y;
-            U(0, i+1) = u(0);
+            X(seq(0, nx-1), k) = Rocket.getState().template cast<float>();
+            X(nx, k) = omega;
+            Y(seq(0, ny-1), k) = y.template cast<float>();
+        }
+    };
 
-            if ((i+1)%25 == 0)
-            {
-                std::cout << "Altitude: " << y(0) << " Time: " << Rocket.time << std::endl;
-                std::cout << "Closed-Loop simulation: iteration " << i+1 << " out of " << Nsim << std::endl;
-            }
-        } 
-        else
-            X(0, i+1) = y(0);       // Store altitude data
-    }
+    scheduler.addTask( "controller", controllerRate, 1, [&]( double t )
+    {
+        if ( k > 0 && k <= Nsim )
+            store(  );
+
+        PID.step( t, y );
+        PID.getU( command );
+        PID.getError( e );
+
+        k++;
+        if ( saveData && k <= Nsim )
+            U(0, k) = command(0);
+    } );
+
+    scheduler.addTask( "actuator", actuatorRate, 1, [&]( double /*t*/ )
+    {
+        u = command;
+    } );
+
+    // Stepper motor speed over the actuator period of the applied command
+    scheduler.addTask( "stepper", actuatorRate, 1, [&]( double /*t*/ )
+    {
+        omega = ( u(0) - lastU(0) )*Scalar( actuatorRate )/Scalar( 0.01 );
+        lastU = u;
+    } );
+
+    scheduler.addTask( "plant", plantRate, 1, [&]( double /*t*/ )
+    {
+        Rocket.integrate( u );
+    } );
+
+    scheduler.run( Rocket.getTime(), simulationTime );
+
+    // Final sample
+    k = Nsim;
+    store(  );
 
     // Export data
     if (saveData)
     {
-        saveToFile(X, X.rows(), X.cols(), "../data/state.csv");
-        saveToFile(Y, Y.rows(), Y.cols(), "../data/output.csv");
-        saveToFile(U, U.rows(), U.cols(), "../data/input.csv");
+        saveTrajectories(  );
+        printMetrics(  );
     }
 }
 
 
-void simulator::tune(  )
+template <class Model, class Scalar>
+void closedLoopSimulator<Model, Scalar>::tune(  )
 {   
     unsigned int k = 1;                 // counter
     float res = 0.1;                    // gain resolution
     float bestDev = 1000.0;             // best obtained target deviation
-    VectorXf gains(3);                  // corresponding gains^
+    VectorXf gains = VectorXf::Zero(3); // corresponding gains
+
+    // Resume from journal of an interrupted campaign
+    MatrixXf records;
+    std::vector<std::string> rngState;
+    unsigned int nDone = 0;
+
+    if ( campaignJournal.isActive() )
+    {
+        nDone = campaignJournal.resume( campaignKey( "tune", 0, 1 ), records, rngState );
+        if ( nDone > 0 )
+            setGeneratorStates( rngState );
+        if ( nDone > 0 && records.cols() != 4 + metrics.size() )
+            throw std::runtime_error("Journal does not match chosen metrics");
+    }
+
+    MatrixXf metricTable( 41*41, metrics.size() );     // Metrics of every gain combination
+    MatrixXf deviations( 41*41, 1 );                    // Deviation of every gain combination
+    progressCounter progress( "Gain tuning [" + outputPrefix + "]", 41*41 - nDone );
+
+    // Linearized pre-screen: only promising combinations are simulated (same order as the loops below)
+    std::vector<bool> promising( 41*41, true );
+    if ( screenTimes.size() > 0 )
+    {
+        MatrixXf grid = MatrixXf::Zero( 41*41, 6 );
+        for ( unsigned int j=0; j<41*41; ++j )
+        {
+            grid(j,0) = -3.0; grid(j,1) = ( (int) j/41 - 20 )*res;     // Proportional
+            grid(j,4) = -7.0; grid(j,5) = ( (int) j%41 - 20 )*res;     // Derivative
+        }
+
+        MatrixXf screen = screenGains( grid, screenTimes, 20.0 );
+        unsigned int nPromising = 0;
+        for ( unsigned int j=0; j<41*41; ++j )
+        {
+            promising[j] = screen(j,0) < 1.0f && screen(j,1) >= minGainMargin && screen(j,2) >= minPhaseMargin;
+            nPromising += promising[j];
+        }
+        logger::info( "Gain screen: ", nPromising, " of ", 41*41, " combinations promising" );
+    }
+
+    // Gains of combination j (same order as the loops below)
+    auto gainWeights = [&]( unsigned int j, VectorXf& pWeights, VectorXf& iWeights, VectorXf& dWeights )
+    {
+        pWeights.resize( 2 ); pWeights << -3.0, ( (int) j/41 - 20 )*res;
+        iWeights.resize( 2 ); iWeights << 0.0, 0.0;
+        dWeights.resize( 2 ); dWeights << -7.0, ( (int) j%41 - 20 )*res;
+    };
+
+    // Without noise a run only depends on its gains: the remaining runs are simulated together,
+    // sharing the plant integration while their commands are identical
+    std::vector<int> forkedRow( 41*41, -1 );
+    MatrixXf forked;
+    if ( !Rocket.isNoisy() && !PID.isNoisy() )
+    {
+        Rocket.resetDynamics();
+        std::vector<scalarPIDcontroller<Scalar> > controllers;
+        VectorXf pWeights, iWeights, dWeights;
+        VectorXf result;
+
+        for ( unsigned int j=nDone; j<41*41; ++j )
+        {
+            if ( !promising[j] )
+                continue;
+
+            scalarPIDcontroller<Scalar> candidate( PID );
+            gainWeights( j, pWeights, iWeights, dWeights );
+            candidate.setProportionalGains( pWeights );
+            candidate.setIntegralGains( iWeights );
+            candidate.setDerivativeGains( dWeights );
+            candidate.resetController();
+            candidate.resetSaturator();
+
+            if ( cache.isActive() && cache.lookup( runKey( candidate, 20.0 ), result ) )
+                continue;
+
+            forkedRow[j] = controllers.size();
+            controllers.push_back( candidate );
+        }
+
+        if ( !controllers.empty() )
+        {
+            unsigned long plantSteps;
+            forked = forkedSweep( controllers, 20.0, plantSteps );
+
+            unsigned long sequentialSteps = controllers.size()*(unsigned long) ( 20.0/Rocket.samplingTime );
+            logger::info( "Shared-prefix sweep: ", plantSteps, " plant steps instead of ", sequentialSteps,
+                          " for ", controllers.size(), " runs" );
+
+            if ( cache.isActive() )
+                for ( unsigned int m=0; m<controllers.size(); ++m )
+                    cache.store( runKey( controllers[m], 20.0 ), forked.row(m).transpose() );
+        }
+    }
 
     for (int i=-20; i <= 20.0; i++) {
         for (int ii=0; ii <= 0; ii++) {
             for (int iii=-20; iii <=20.0; iii++) {
-                /* Reset controller and dynamics */
-                Rocket.resetDynamics();
-                PID.resetController();
-                PID.resetSaturator();
+                float dev;
 
-                /* Vary controller gains */
-                VectorXf pWeights( 2 );
-                pWeights(0) = -3.0;
-                pWeights(1) = i*res;
+                if ( k <= nDone )
+                {
+                    /* Completed in previous run */
+                    dev = records(k-1,0);
+                    metricTable.row(k-1) = records.block(k-1,4,1,metrics.size());
+                }
+                else
+                {
+                    if ( promising[k-1] )
+                    {
+                        /* Reset controller and dynamics */
+                        Rocket.resetDynamics();
+                        PID.resetController();
+                        PID.resetSaturator();
 
-                VectorXf iWeights( 2 );
-                iWeights(0) = 0.0;
-                iWeights(1) = ii*res;
+                        /* Vary controller gains */
+                        VectorXf pWeights, iWeights, dWeights;
+                        gainWeights( k-1, pWeights, iWeights, dWeights );
 
-                VectorXf dWeights( 2 );
-                dWeights(0) = -7.0;
-                dWeights(1) = iii*res;
+                        PID.setProportionalGains( pWeights );
+                        PID.setIntegralGains( iWeights );
+                        PID.setDerivativeGains( dWeights );
 
-                PID.setProportionalGains( pWeights );
-                PID.setIntegralGains( iWeights );
-                PID.setDerivativeGains( dWeights );
+                        /* Closed-loop simulation, or its result from the shared-prefix sweep */
+                        if ( forkedRow[k-1] >= 0 )
+                        {
+                            dev = abs( 3500 - forked( forkedRow[k-1], 0 ) );
+                            metricValues = forked.row( forkedRow[k-1] ).tail( metrics.size() ).transpose();
+                        }
+                        else
+                            dev = abs( 3500 - simulateApogee( 20.0 ) );
+                    }
+                    else
+                    {
+                        /* Discarded by the linearized pre-screen */
+                        dev = NAN;
+                        metricValues = VectorXf::Constant( metrics.size(), NAN );
+                    }
+                    metricTable.row(k-1) = metricValues.transpose();
 
-                /* Closed-loop simulation */
-                simulate( 20.0,false );
+                    if ( campaignJournal.isActive() )
+                    {
+                        VectorXf record( 4 + metrics.size() );
+                        record << dev, i*res, ii*res, iii*res, metricValues;
+                        campaignJournal.append( record, getGeneratorStates() );
+                    }
 
-                std::cout << "Round: " << k << std::endl;
-                std::cout << "Difference: " << abs( 3500 - X.maxCoeff() ) << std::endl;
+                    logger::debug( "Round: ", k, " difference: ", dev );
+                    progress.advance();
+                }
+                deviations(k-1,0) = dev;
                 k++;
 
-                if ( abs( 3500 - X.maxCoeff()) < bestDev )
+                if ( dev < bestDev )
                 {
-                     bestDev = abs( 3500 - X.maxCoeff() );
+                     bestDev = dev;
                      gains[0] = i*res; gains[1] = ii*res; gains[2] = iii*res;
                 }
 
             }
         }
     }   
-    std::cout << "Smallest deviation: " << bestDev << std::endl;
-    std::cout << "For combintation of gains: " << gains << std::endl;
+    logger::info( "Smallest deviation: ", bestDev );
+    logger::info( "For combintation of gains: ", gains );
+
+    saveMetrics( metricTable );
+
+    // Gain offsets of every combination
+    MatrixXf gainOffsets( 41*41, 3 );
+    for ( unsigned int j=0; j<41*41; ++j )
+    {
+        gainOffsets(j,0) = ( (int) j/41 - 20 )*res;
+        gainOffsets(j,1) = 0.0;
+        gainOffsets(j,2) = ( (int) j%41 - 20 )*res;
+    }
+    saveStore( { "pGain", "iGain", "dGain" }, gainOffsets, deviations, metricTable );
 }
 
 
-void simulator::robustness( const VectorXf& initState )
+template <class Model, class Scalar>
+void closedLoopSimulator<Model, Scalar>::robustness( const VectorXf& initState, unsigned int shardIndex, unsigned int nShards )
 {
+    if ( nShards == 0 || shardIndex >= nShards )
+        throw std::invalid_argument("Invalid shard index given");
+
     nx = initState.size();
-    unsigned int k = 0;
+    unsigned int k = 0;                 // global point index
+    unsigned int m = 0;                 // point index within shard
     MatrixXf deviations(441,1);
-    MatrixXf stateOffsets(441,4);
+    MatrixXf stateOffsets(441,nx);
+    MatrixXf metricTable(441, metrics.size());
+    std::vector<unsigned int> shardPoints;
+
+    // Resume from journal of an interrupted campaign
+    MatrixXf records;
+    std::vector<std::string> rngState;
+    unsigned int nDone = 0;
+
+    if ( campaignJournal.isActive() )
+    {
+        nDone = campaignJournal.resume( campaignKey( "robustness", shardIndex, nShards ), records, rngState );
+        if ( nDone > 0 )
+            setGeneratorStates( rngState );
+        if ( nDone > 0 && records.cols() != nx + 1 + metrics.size() )
+            throw std::runtime_error("Journal does not match chosen metrics");
+    }
+    progressCounter progress( "Robustness map [" + outputPrefix + "]", ( 441 - shardIndex + nShards - 1 )/nShards - nDone );
 
     for (int i=-10; i <= 10; i++) {
         for (int ii=-10; ii <= 10; ii++) {
+            // Points are dealt round-robin over the shards
+            if ( k % nShards != shardIndex )
+            {
+                k++;
+                continue;
+            }
+            shardPoints.push_back( k );
+
+            if ( m < nDone )
+            {
+                /* Completed in previous run */
+                deviations(k,0) = records(m,0);
+                for (unsigned j=0; j<nx; j++)
+                    stateOffsets(k,j) = records(m,j+1);
+                metricTable.row(k) = records.block(m,nx+1,1,metrics.size());
+                k++; m++;
+                continue;
+            }
+
             /* Reset controller and dynamics */
-            VectorXf offsets(4);                        // State percentage offsets
-            offsets(0) = 0.0;
+            VectorXf offsets = VectorXf::Zero( nx );    // State percentage offsets
             offsets(1) = i*0.10/10.0;
-            offsets(2) = 0.0;
             offsets(3) = ii*0.10/10.0;
 
             Rocket.resetDynamics( offsets );
@@ -164,18 +441,1221 @@ void simulator::robustness( const VectorXf& initState )
             PID.resetSaturator();
 
             /* Closed-loop simulation */
-            simulate( 20.0,false );
+            float apogee = simulateApogee( 20.0 );
 
             /* Save data */
-            deviations(k,0) = 3500 - X.maxCoeff();
+            deviations(k,0) = 3500 - apogee;
             for (unsigned i=0; i<nx; i++)
                 stateOffsets(k,i) = initState(i)*offsets(i);
+            metricTable.row(k) = metricValues.transpose();
+
+            if ( campaignJournal.isActive() )
+            {
+                VectorXf record( nx+1+metrics.size() );
+                record << deviations(k,0), stateOffsets.row(k).transpose(), metricValues;
+                campaignJournal.append( record, getGeneratorStates() );
+            }
  
-            std::cout << "Round: " << k+1 << " offsets " << i << ii << std::endl;
-            std::cout << "Difference: " << abs( 3500 - X.maxCoeff() ) << std::endl;            
-            k++;
+            logger::debug( "Round: ", k+1, " offsets ", i, " ", ii, " difference: ", abs( 3500 - apogee ) );
+            progress.advance();
+            k++; m++;
         }
     }   
-    saveToFile(deviations, deviations.rows(), deviations.cols(), "../data/deviations.csv");
-	saveToFile(stateOffsets, stateOffsets.rows(), stateOffsets.cols(), "../data/stateOffsets.csv");
-}
\ No newline at end of file
+
+    if ( nShards == 1 )
+    {
+        saveToFile(deviations, deviations.rows(), deviations.cols(), outputPrefix + "deviations.csv");
+        saveToFile(stateOffsets, stateOffsets.rows(), stateOffsets.cols(), outputPrefix + "stateOffsets.csv");
+        saveMetrics( metricTable );
+        saveStore( { "altitudeOffset", "velocityOffset" }, gridOffsets( 441 ), deviations, metricTable );
+        return;
+    }
+
+    // Shard result: point index, deviation, state offsets, metrics
+    MatrixXf shard( shardPoints.size(), nx+2+metrics.size() );
+    for ( unsigned int j=0; j<shardPoints.size(); ++j )
+    {
+        shard(j,0) = shardPoints[j];
+        shard(j,1) = deviations(shardPoints[j],0);
+        shard.block(j,2,1,nx) = stateOffsets.row(shardPoints[j]);
+        shard.block(j,nx+2,1,metrics.size()) = metricTable.row(shardPoints[j]);
+    }
+
+    // Write to temporary file first, so a shard file only exists once it is complete
+    std::string fileName = shardFileName( shardIndex, nShards );
+    saveToFile(shard, shard.rows(), shard.cols(), fileName + ".tmp");
+#ifdef _WIN32
+    std::remove( fileName.c_str() );
+#endif
+    std::rename( (fileName + ".tmp").c_str(), fileName.c_str() );
+}
+
+
+template <class Model, class Scalar>
+void closedLoopSimulator<Model, Scalar>::mergeRobustness( unsigned int nShards, unsigned int nPoints )
+{
+    if ( nShards == 0 )
+        throw std::invalid_argument("Invalid number of shards given");
+
+    MatrixXf deviations( nPoints,1 );
+    MatrixXf stateOffsets( nPoints,Model::NX );
+    MatrixXf metricTable( nPoints, metrics.size() );
+    std::vector<bool> found( nPoints, false );
+    std::vector<unsigned int> missingShards;
+
+    for ( unsigned int s=0; s<nShards; ++s )
+    {
+        std::string fileName = shardFileName( s, nShards );
+        ifstream File( fileName );
+        if ( !File.is_open() )
+        {
+            missingShards.push_back( s );
+            continue;
+        }
+        File.close();
+
+        MatrixXf shard = loadFromFile( fileName );
+        for ( unsigned int j=0; j<shard.rows(); ++j )
+        {
+            unsigned int k = (unsigned int) lround( shard(j,0) );
+            if ( k >= nPoints || k % nShards != s || shard.cols() != Model::NX + 2 + metrics.size() )
+                throw std::runtime_error("Invalid record in shard file " + fileName);
+            if ( found[k] )
+                throw std::runtime_error("Duplicate point " + std::to_string( k ) + " in shard file " + fileName);
+
+            deviations(k,0) = shard(j,1);
+            stateOffsets.row(k) = shard.block(j,2,1,Model::NX);
+            metricTable.row(k) = shard.block(j,Model::NX+2,1,metrics.size());
+            found[k] = true;
+        }
+    }
+
+    if ( !missingShards.empty() )
+    {
+        std::string msg = "Missing shards:";
+        for ( unsigned int s=0; s<missingShards.size(); ++s )
+            msg += " " + std::to_string( missingShards[s] );
+        throw std::runtime_error( msg + " (of " + std::to_string( nShards ) + ")" );
+    }
+
+    for ( unsigned int k=0; k<nPoints; ++k )
+        if ( !found[k] )
+            throw std::runtime_error("Missing point " + std::to_string( k ) + " in shard " + std::to_string( k % nShards ));
+
+    saveToFile(deviations, deviations.rows(), deviations.cols(), outputPrefix + "deviations.csv");
+    saveToFile(stateOffsets, stateOffsets.rows(), stateOffsets.cols(), outputPrefix + "stateOffsets.csv");
+    saveMetrics( metricTable );
+    saveStore( { "altitudeOffset", "velocityOffset" }, gridOffsets( nPoints ), deviations, metricTable );
+}
+
+
+template <class Model, class Scalar>
+void closedLoopSimulator<Model, Scalar>::adaptiveRobustness( const VectorXf& initState, float tolerance, unsigned int nCoarse, unsigned int maxLevel )
+{
+    if ( nCoarse == 0 )
+        throw std::invalid_argument("Number of coarse grid cells must be positive");
+
+    nx = initState.size();
+
+    // Integer lattice at finest resolution over offsets [-0.1, 0.1]
+    int nFine = nCoarse << maxLevel;
+    float spacing = 0.2 / nFine;
+    std::map<std::pair<int,int>, float> points;
+    std::map<std::pair<int,int>, VectorXf> pointMetrics;
+    progressCounter progress( "Adaptive robustness map [" + outputPrefix + "]", 0 );
+
+    auto evaluate = [&]( int i, int ii ) -> float
+    {
+        std::pair<int,int> key( i, ii );
+        std::map<std::pair<int,int>, float>::iterator it = points.find( key );
+        if ( it != points.end() )
+            return it->second;
+
+        float dev = offsetDeviation( -0.1 + i*spacing, -0.1 + ii*spacing );
+        points[key] = dev;
+        pointMetrics[key] = metricValues;
+
+        logger::debug( "Round: ", points.size(), " offsets ", i, " ", ii, " difference: ", abs( dev ) );
+        progress.advance();
+        return dev;
+    };
+
+    // Cells to be checked: lower-left lattice corner and size
+    std::vector<std::array<int,3> > cells;
+    int coarseSize = 1 << maxLevel;
+    for ( unsigned int i=0; i<nCoarse; ++i )
+        for ( unsigned int ii=0; ii<nCoarse; ++ii )
+            cells.push_back( { (int) i*coarseSize, (int) ii*coarseSize, coarseSize } );
+
+    while ( !cells.empty() )
+    {
+        std::array<int,3> cell = cells.back(); cells.pop_back();
+        int i = cell[0], ii = cell[1], size = cell[2], half = size/2;
+
+        float f00 = evaluate( i, ii );
+        float f10 = evaluate( i+size, ii );
+        float f01 = evaluate( i, ii+size );
+        float f11 = evaluate( i+size, ii+size );
+
+        if ( size == 1 )
+            continue;
+
+        // Residuals of linear interpolation at center and edge midpoints
+        float err = 0.0;
+        err = std::max( err, std::abs( evaluate( i+half, ii+half ) - (f00 + f10 + f01 + f11)/4.0f ) );
+        err = std::max( err, std::abs( evaluate( i+half, ii ) - (f00 + f10)/2.0f ) );
+        err = std::max( err, std::abs( evaluate( i+half, ii+size ) - (f01 + f11)/2.0f ) );
+        err = std::max( err, std::abs( evaluate( i, ii+half ) - (f00 + f01)/2.0f ) );
+        err = std::max( err, std::abs( evaluate( i+size, ii+half ) - (f10 + f11)/2.0f ) );
+
+        if ( err > tolerance )
+        {
+            cells.push_back( { i, ii, half } );
+            cells.push_back( { i+half, ii, half } );
+            cells.push_back( { i, ii+half, half } );
+            cells.push_back( { i+half, ii+half, half } );
+        }
+    }
+
+    // Export scattered points
+    MatrixXf deviations( points.size(),1 );
+    MatrixXf stateOffsets = MatrixXf::Zero( points.size(),nx );
+    MatrixXf metricTable( points.size(), metrics.size() );
+    unsigned int k = 0;
+
+    for ( std::map<std::pair<int,int>, float>::iterator it=points.begin(); it!=points.end(); ++it, ++k )
+    {
+        deviations(k,0) = it->second;
+        metricTable.row(k) = pointMetrics[it->first].transpose();
+        stateOffsets(k,1) = initState(1)*( -0.1 + it->first.first*spacing );
+        stateOffsets(k,3) = initState(3)*( -0.1 + it->first.second*spacing );
+    }
+
+    logger::info( "Adaptive robustness map: ", points.size(), " simulations, uniform grid at same resolution: ", (nFine+1)*(nFine+1) );
+
+    saveToFile(deviations, deviations.rows(), deviations.cols(), outputPrefix + "deviations.csv");
+	saveToFile(stateOffsets, stateOffsets.rows(), stateOffsets.cols(), outputPrefix + "stateOffsets.csv");
+    saveMetrics( metricTable );
+
+    MatrixXf relativeOffsets( points.size(), 2 );
+    relativeOffsets.col(0) = stateOffsets.col(1) / initState(1);
+    relativeOffsets.col(1) = stateOffsets.col(3) / initState(3);
+    saveStore( { "altitudeOffset", "velocityOffset" }, relativeOffsets, deviations, metricTable );
+}
+
+
+template <class Model, class Scalar>
+void closedLoopSimulator<Model, Scalar>::dispersion( const std::vector<uncertainParameter>& parameters, const MatrixXd& samples,
+                            const VectorXd& weights )
+{
+    if ( samples.cols() != (Index) parameters.size() )
+        throw std::invalid_argument("Number of sample dimensions does not match number of uncertain parameters");
+    if ( weights.size() > 0 && weights.size() != samples.rows() )
+        throw std::invalid_argument("Number of weights does not match number of samples");
+
+    unsigned int n = samples.rows();
+    MatrixXf deviations( n,1 );
+    MatrixXf values( n, parameters.size() );
+    MatrixXf metricTable( n, metrics.size() );
+    progressCounter progress( "Dispersion [" + outputPrefix + "]", n );
+
+    plantDynamics<Model, Scalar> nominalRocket = Rocket;
+    scalarPIDcontroller<Scalar> nominalPID = PID;
+
+    for ( unsigned int k=0; k<n; ++k )
+    {
+        /* Restore nominal configuration, noise streams continue */
+        std::vector<std::string> states = getGeneratorStates();
+        Rocket = nominalRocket;
+        PID = nominalPID;
+        setGeneratorStates( states );
+
+        /* Apply sample */
+        VectorXf offsets = VectorXf::Zero( nx );
+        for ( unsigned int j=0; j<parameters.size(); ++j )
+            values(k,j) = parameters[j].lower + samples(k,j)*( parameters[j].upper - parameters[j].lower );
+        applyUncertainty( parameters, values.row(k).transpose(), Rocket, PID, offsets );
+
+        Rocket.resetDynamics( offsets );
+        PID.resetController();
+        PID.resetSaturator();
+
+        /* Closed-loop simulation */
+        deviations(k,0) = 3500 - simulateApogee( 20.0 );
+        metricTable.row(k) = metricValues.transpose();
+
+        logger::debug( "Round: ", k+1, " out of ", n, " difference: ", abs( deviations(k,0) ) );
+        progress.advance();
+    }
+
+    Rocket = nominalRocket;
+    PID = nominalPID;
+
+    // Statistics of deviation
+    VectorXd w = ( weights.size() > 0 ) ? weights : VectorXd::Constant( n, 1.0/n );
+    VectorXd dev = deviations.col(0).cast<double>();
+    double mean = w.dot( dev );
+    double var = w.dot( ( dev.array() - mean ).square().matrix() );
+
+    logger::info( "Deviation mean: ", mean, " standard deviation: ", sqrt( std::max( var, 0.0 ) ) );
+
+    saveToFile(values, values.rows(), values.cols(), outputPrefix + "dispersionSamples.csv");
+    saveToFile(deviations, deviations.rows(), deviations.cols(), outputPrefix + "deviations.csv");
+    saveMetrics( metricTable );
+
+    std::vector<std::string> names;
+    for ( unsigned int j=0; j<parameters.size(); ++j )
+    {
+        const uncertainParameter& p = parameters[j];
+        bool indexed = p.name == "state" || p.name == "sensorBias" || p.name == "sensorNoise"
+                    || p.name == "actuatorBias" || p.name == "actuatorNoise";
+        names.push_back( indexed ? p.name + std::to_string( p.index ) : p.name );
+    }
+    saveStore( names, values, deviations, metricTable );
+}
+
+
+template <class Model, class Scalar>
+float closedLoopSimulator<Model, Scalar>::compareControllers( const scalarPIDcontroller<Scalar>& candidate, unsigned int nRuns,
+                                                              const std::vector<uncertainParameter>& parameters, bool antithetic,
+                                                              unsigned int nReplicates, unsigned int seed, unsigned int nThreads )
+{
+    // Runs are grouped in units (a run or an antithetic pair) sharing noise streams and parameters
+    unsigned int runsPerUnit = antithetic ? 2 : 1;
+    if ( nRuns == 0 || nRuns % runsPerUnit != 0 )
+        throw std::invalid_argument("Number of runs must be positive and even with antithetic pairs");
+    unsigned int nUnits = nRuns/runsPerUnit;
+
+    if ( parameters.empty() )
+        nReplicates = 1;
+    if ( nReplicates == 0 || nUnits % nReplicates != 0 )
+        throw std::invalid_argument("Number of replicates must divide the number of runs or pairs");
+    if ( nReplicates == 1 && nUnits < 2 )
+        throw std::invalid_argument("At least two runs or pairs are needed to estimate the error");
+    unsigned int unitsPerReplicate = nUnits/nReplicates;
+
+    // One scrambled Sobol point per unit, an independent scramble per replicate
+    MatrixXf values( nUnits, parameters.size() );
+    for ( unsigned int r=0; r<nReplicates && !parameters.empty(); ++r )
+    {
+        MatrixXd samples = sampler::scrambledSobol( unitsPerReplicate, parameters.size(), seed + r );
+        for ( unsigned int j=0; j<parameters.size(); ++j )
+            values.block( r*unitsPerReplicate, j, unitsPerReplicate, 1 ) =
+                ( parameters[j].lower + samples.col(j).array()*( parameters[j].upper - parameters[j].lower ) ).cast<float>();
+    }
+
+    // Noise seeds of every unit, shared by both controllers
+    std::mt19937 seeder( seed );
+    std::vector<unsigned int> noiseSeeds( nUnits );
+    for ( unsigned int u=0; u<nUnits; ++u )
+        noiseSeeds[u] = seeder();
+
+    MatrixXf deviations( nRuns, 2 );
+    progressCounter progress( "Comparison [" + outputPrefix + "]", nRuns );
+
+    // Runs are simulated in parallel
+    parallelFor( nRuns, nThreads, [&]( unsigned int k )
+    {
+        unsigned int u = k/runsPerUnit;
+        bool mirrored = antithetic && k % 2 == 1;
+
+        for ( unsigned int c=0; c<2; ++c )
+        {
+            scalarPIDcontroller<Scalar> runPID( c == 0 ? PID : candidate );
+            plantDynamics<Model, Scalar> runRocket( Rocket );
+            VectorXf offsets = VectorXf::Zero( nx );
+            applyUncertainty( parameters, values.row(u).transpose(), runRocket, runPID, offsets );
+
+            runRocket.setSeed( noiseSeeds[u] );
+            runPID.setSeed( noiseSeeds[u] + 1 );
+            runRocket.setAntithetic( mirrored );
+            runPID.setAntithetic( mirrored );
+            runRocket.resetDynamics( offsets );
+            runPID.resetController();
+            runPID.resetSaturator();
+
+            closedLoopSimulator<Model, Scalar> run( nx, nu, ny, runPID, runRocket, samplingTime );
+            deviations(k,c) = std::abs( 3500 - run.simulateInto( 20.0, NULL ) );
+        }
+        logger::debug( "Run: ", k+1, " out of ", nRuns, " difference: ", deviations(k,1) - deviations(k,0) );
+        progress.advance();
+    }, "Run" );
+
+    saveToFile(deviations, deviations.rows(), deviations.cols(), outputPrefix + "comparison.csv");
+
+    // Achieved variance of the mean difference: from the replicate means with scrambled points,
+    // else from the independent units
+    MatrixXd dev = deviations.cast<double>();
+    VectorXd difference = dev.col(1) - dev.col(0);
+    VectorXd units = Map<const MatrixXd>( difference.data(), runsPerUnit, nUnits ).colwise().mean().transpose();
+    VectorXd groups = units;
+    if ( nReplicates > 1 )
+        groups = Map<const MatrixXd>( units.data(), unitsPerReplicate, nReplicates ).colwise().mean().transpose();
+    double mean = difference.mean();
+    double variance = ( groups.array() - mean ).square().sum()/( groups.size() - 1 )/groups.size();
+
+    // Independent streams: variance of both controllers adds up, nRuns flights each
+    auto sampleVariance = []( const VectorXd& x ) { return ( x.array() - x.mean() ).square().sum()/( x.size() - 1 ); };
+    double independent = ( nRuns > 1 ) ? ( sampleVariance( dev.col(0) ) + sampleVariance( dev.col(1) ) )/nRuns : NAN;
+    double reduction = independent/variance;
+
+    logger::info( "Mean deviation current: ", dev.col(0).mean(), " candidate: ", dev.col(1).mean(),
+                  " difference: ", mean, " +- ", sqrt( variance ), " (standard error)" );
+    logger::info( "Variance reduction: ", reduction, " (", nRuns, " runs equivalent to ", reduction*nRuns,
+                  " independent runs)" );
+    return mean;
+}
+
+
+template <class Model, class Scalar>
+float closedLoopSimulator<Model, Scalar>::comparePrecision( float tolerance )
+{
+    // All-double twin: same configuration, run state and noise generator states
+    plantDynamics<Model, double> referenceRocket( Rocket );
+    scalarPIDcontroller<double> referencePID( PID );
+    closedLoopSimulator<Model, double> reference( nx, nu, ny, referencePID, referenceRocket, samplingTime );
+    reference.setMetrics( metrics );
+    reference.setOutputPrefix( outputPrefix );
+
+    MatrixXf offsets = gridOffsets( 441 );
+    MatrixXf comparison( offsets.rows(), 5 );
+    double time = 0.0, referenceTime = 0.0;
+
+    for ( unsigned int k=0; k<offsets.rows(); ++k )
+    {
+        auto start = std::chrono::steady_clock::now();
+        float deviation = offsetDeviation( offsets(k,0), offsets(k,1) );
+        auto middle = std::chrono::steady_clock::now();
+        float referenceDeviation = reference.offsetDeviation( offsets(k,0), offsets(k,1) );
+        auto end = std::chrono::steady_clock::now();
+
+        time += std::chrono::duration<double>( middle - start ).count();
+        referenceTime += std::chrono::duration<double>( end - middle ).count();
+
+        comparison.row(k) << offsets(k,0), offsets(k,1), deviation, referenceDeviation, deviation - referenceDeviation;
+    }
+
+    float maxDifference = comparison.col(4).cwiseAbs().maxCoeff();
+    float meanDifference = comparison.col(4).cwiseAbs().mean();
+
+    logger::info( "Precision comparison (", ( std::is_same<Scalar, float>::value ? "float" : "double" ),
+                  " vs double) over ", offsets.rows(), " runs" );
+    logger::info( "Apogee difference: largest ", maxDifference, " mean ", meanDifference );
+    logger::info( "Run time: ", time, " s vs ", referenceTime, " s" );
+    logger::info( ( maxDifference <= tolerance ? "Within" : "Exceeds" ), " tolerance of ", tolerance );
+
+    saveToFile(comparison, comparison.rows(), comparison.cols(), outputPrefix + "precisionComparison.csv");
+    return maxDifference;
+}
+
+
+template <class Model, class Scalar>
+float closedLoopSimulator<Model, Scalar>::convergenceStudy( float simulationTime, unsigned int coarsestRate, unsigned int nLevels,
+                                                           float tolerance, unsigned int nThreads )
+{
+    if ( nLevels < 3 )
+        throw std::invalid_argument("Convergence study needs at least three levels");
+    if ( coarsestRate == 0 )
+        throw std::invalid_argument("Plant rate must be positive");
+
+    // Sensors, actuator and controller at the controller rate, only the integration step varies
+    unsigned int controllerRate = (unsigned int) round( 1.0/samplingTime );
+    VectorXi sensorRates = VectorXi::Constant( ny, controllerRate );
+
+    // Differences, orders and extrapolation in double: differences between the finest levels approach float resolution
+    VectorXd steps( nLevels ), apogees( nLevels );
+    for ( unsigned int k=0; k<nLevels; ++k )
+        steps(k) = 1.0/( (double) coarsestRate*( 1u << k ) );
+
+    // Levels are simulated in parallel
+    parallelFor( nLevels, nThreads, [&]( unsigned int k )
+    {
+        scalarPIDcontroller<Scalar> levelPID( PID );
+        plantDynamics<Model, Scalar> levelRocket( Rocket );
+        closedLoopSimulator<Model, Scalar> level( nx, nu, ny, levelPID, levelRocket, samplingTime );
+
+        level.simulateMultiRate( simulationTime, coarsestRate*( 1u << k ), sensorRates,
+                                 controllerRate, controllerRate, false );
+        apogees(k) = level.apogee.value();
+    }, "Level" );
+
+    // Observed order from three consecutive levels: p = log2( |A_k - A_k+1| / |A_k+1 - A_k+2| )
+    VectorXd order = VectorXd::Constant( nLevels, NAN );
+    for ( unsigned int k=0; k+2<nLevels; ++k )
+        order(k) = log2( std::abs( apogees(k) - apogees(k+1) ) / std::abs( apogees(k+1) - apogees(k+2) ) );
+
+    // Richardson extrapolation of the two finest levels with the finest observed order
+    // (without an asymptotic order, errors are taken relative to the finest level)
+    double p = order( nLevels-3 );
+    bool asymptotic = std::isfinite( p ) && p > 0.0;
+    double extrapolated = apogees( nLevels-1 );
+    if ( asymptotic )
+        extrapolated += ( apogees( nLevels-1 ) - apogees( nLevels-2 ) )/( pow( 2.0, p ) - 1.0 );
+
+    MatrixXd study( nLevels, 4 );
+    for ( unsigned int k=0; k<nLevels; ++k )
+        study.row(k) << steps(k), apogees(k), order(k), std::abs( apogees(k) - extrapolated );
+
+    // Largest step for which it and all finer steps are within tolerance
+    float recommended = 0.0;
+    for ( int k=nLevels-1; k>=0 && study(k,3) <= tolerance; --k )
+        recommended = steps(k);
+
+    logger::info( "Integrator: ", Rocket.getIntegrator(), " (", Rocket.getIntegratorEvaluations(), " model evaluations per step)" );
+    for ( unsigned int k=0; k<nLevels; ++k )
+        logger::info( "Step: ", steps(k), " Apogee: ", apogees(k), " Observed order: ", order(k), " Estimated error: ", study(k,3),
+                      " Model evaluations: ", (unsigned long) ( simulationTime/steps(k) )*Rocket.getIntegratorEvaluations() );
+    if ( asymptotic )
+        logger::info( "Extrapolated apogee: ", extrapolated );
+    else
+        logger::info( "No asymptotic convergence at the finest levels, errors relative to the finest level" );
+    if ( recommended > 0.0f )
+        logger::info( "Largest step within tolerance of ", tolerance, ": ", recommended );
+    else
+        logger::info( "No step within tolerance of ", tolerance );
+
+    MatrixXf studyTable = study.cast<float>();
+    saveToFile(studyTable, studyTable.rows(), studyTable.cols(), outputPrefix + "convergence.csv");
+    return recommended;
+}
+
+
+template <class Model, class Scalar>
+unsigned int closedLoopSimulator<Model, Scalar>::paretoTune( const std::vector<tuningParameter>& parameters, unsigned int populationSize,
+                                                             unsigned int nGenerations, float maxOmega, unsigned int seed, unsigned int nThreads )
+{
+    VectorXf lowerBounds( parameters.size() ), upperBounds( parameters.size() );
+    for ( unsigned int j=0; j<parameters.size(); ++j )
+    {
+        lowerBounds(j) = parameters[j].lower;
+        upperBounds(j) = parameters[j].upper;
+    }
+
+    // Unknown settings are reported before any simulation
+    scalarPIDcontroller<Scalar> check( PID );
+    applyTuning( parameters, lowerBounds, check );
+
+    paretoOptimizer optimizer( lowerBounds, upperBounds, populationSize, seed );
+
+    progressCounter progress( "Pareto tuning [" + outputPrefix + "]", populationSize*nGenerations );
+    MatrixXf objectives( populationSize, 3 );
+    VectorXf violations( populationSize );
+    MatrixXf front, frontObjectives;
+
+    for ( unsigned int generation=0; generation<nGenerations; ++generation )
+    {
+        const MatrixXf& candidates = optimizer.getCandidates();
+
+        // Candidates are simulated in parallel
+        parallelFor( populationSize, nThreads, [&]( unsigned int c )
+        {
+            scalarPIDcontroller<Scalar> candidatePID( PID );
+            plantDynamics<Model, Scalar> candidateRocket( Rocket );
+            applyTuning( parameters, candidates.row(c).transpose(), candidatePID );
+            candidateRocket.resetDynamics();
+            candidatePID.resetController();
+            candidatePID.resetSaturator();
+
+            closedLoopSimulator<Model, Scalar> candidate( nx, nu, ny, candidatePID, candidateRocket, samplingTime );
+            candidate.setMetrics( { "actuatorTravel", "peakOmega" } );
+
+            float values[2];
+            float apogeeValue = candidate.simulateInto( 20.0, values );
+            objectives.row(c) << std::abs( 3500 - apogeeValue ), values[0], values[1];
+            violations(c) = std::max( 0.0f, values[1] - maxOmega );
+
+            // Diverged runs are infeasible
+            if ( !objectives.row(c).allFinite() )
+            {
+                objectives.row(c).setConstant( 1e30 );
+                violations(c) = INFINITY;
+            }
+            progress.advance();
+        }, "Candidate" );
+
+        optimizer.update( objectives, violations );
+
+        // Front so far, an interrupted run keeps the last completed generation
+        optimizer.getFront( front, frontObjectives );
+        MatrixXf table( front.rows(), front.cols() + 3 );
+        table << front, frontObjectives;
+        saveToFile(table, table.rows(), table.cols(), outputPrefix + "paretoFront.csv");
+
+        logger::debug( "Generation ", generation+1, ": ", front.rows(), " settings on the Pareto front" );
+    }
+
+    if ( front.rows() > 0 )
+        logger::info( "Pareto front: ", front.rows(), " settings, deviation ", frontObjectives.col(0).minCoeff(), " to ",
+                      frontObjectives.col(0).maxCoeff(), ", peak motor speed ", frontObjectives.col(2).minCoeff(), " to ",
+                      frontObjectives.col(2).maxCoeff() );
+    else
+        logger::warning( "No setting within the motor speed limit of ", maxOmega );
+    return front.rows();
+}
+
+
+template <class Model, class Scalar>
+MatrixXf closedLoopSimulator<Model, Scalar>::screenGains( const MatrixXf& gains, const VectorXf& times, float simulationTime )
+{
+    auto start = std::chrono::steady_clock::now();
+
+    // Operating points on the nominal trajectory, simulated on copies (noise streams untouched)
+    plantDynamics<Model, Scalar> nominalRocket( Rocket );
+    scalarPIDcontroller<Scalar> nominalPID( PID );
+    nominalRocket.resetDynamics();
+    nominalPID.resetController();
+    nominalPID.resetSaturator();
+
+    VectorXf sortedTimes = times;
+    std::sort( sortedTimes.data(), sortedTimes.data() + sortedTimes.size() );
+
+    linearAnalysis<Model> analysis( nominalRocket.getModel(), nominalRocket.samplingTime, nominalRocket.getIntegrator() );
+
+    int Nsim = (int) simulationTime/nominalRocket.samplingTime;
+    float h = nominalRocket.samplingTime;
+    VectorX<Scalar> u;
+    VectorX<Scalar> y = nominalRocket.getOutput();
+    nominalPID.init( y, nominalRocket.getTime() );
+
+    unsigned int next = 0;
+    for ( int i = 0; i < Nsim && next < sortedTimes.size(); ++i )
+    {
+        nominalPID.step( nominalRocket.getTime(), y );
+        nominalPID.getU( u );
+
+        // Operating point at the step nearest to each chosen time
+        while ( next < sortedTimes.size() && sortedTimes(next) < nominalRocket.getTime() + h/2 )
+        {
+            analysis.addOperatingPoint( nominalRocket.getTime(), nominalRocket.getState().template cast<double>(),
+                                        u.template cast<double>() );
+            next++;
+        }
+        nominalRocket.step( u,y );
+    }
+    if ( next < sortedTimes.size() )
+        throw std::invalid_argument("Operating point times beyond the simulation time given");
+
+    MatrixXf results = analysis.analyze( gains );
+    double elapsed = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    unsigned int nStable = ( results.col(0).array() < 1.0f ).count();
+    logger::info( "Linearized screen of ", gains.rows(), " gain combinations at ", sortedTimes.size(), " operating points (", nominalRocket.getIntegrator(), "): ",
+                  nStable, " stable (", elapsed*1e3, " ms)" );
+
+    MatrixXf table( gains.rows(), gains.cols() + results.cols() );
+    table << gains, results;
+    saveToFile(table, table.rows(), table.cols(), outputPrefix + "gainScreen.csv");
+    return results;
+}
+
+
+template <class Model, class Scalar>
+float closedLoopSimulator<Model, Scalar>::verifyGeneratedCode( const std::string& headerFile, const std::string& name, float simulationTime )
+{
+#ifdef __linux__
+    // Wrapper with fixed symbol names around the generated controller
+    std::string base = outputPrefix + name + "_verify";
+    std::ofstream wrapper( base + ".c" );
+    if ( !wrapper.is_open() )
+        throw std::runtime_error("Could not open file " + base + ".c");
+
+    char* headerPath = realpath( headerFile.c_str(), NULL );
+    if ( !headerPath )
+        throw std::runtime_error("Generated header " + headerFile + " not found");
+    wrapper << "#include \"" << headerPath << "\"\n";
+    free( headerPath );
+
+    const std::string real = std::is_same<Scalar, float>::value ? "float" : "double";
+    wrapper << "unsigned long verify_state_size( void ) { return sizeof( " << name << "_state ); }\n";
+    wrapper << "void verify_init( void* state, const " << real << "* y0, double t ) { " << name << "_init( state, y0, t ); }\n";
+    wrapper << "void verify_step( void* state, double t, const " << real << "* y, " << real << "* u ) { " << name << "_step( state, t, y, u ); }\n";
+    wrapper.close();
+
+    const char* compiler = getenv( "CC" );
+    std::string command = std::string( compiler ? compiler : "cc" ) + " -std=c99 -O2 -Wall -Werror -shared -fPIC -o "
+                        + base + ".so " + base + ".c -lm";
+    if ( system( command.c_str() ) != 0 )
+        throw std::runtime_error("Compilation of generated controller failed: " + command);
+
+    void* library = dlopen( ( base + ".so" ).c_str(), RTLD_NOW | RTLD_LOCAL );
+    if ( !library )
+        throw std::runtime_error( std::string( "Could not load generated controller: " ) + dlerror() );
+
+    typedef unsigned long (*sizeFunction)( void );
+    typedef void (*initFunction)( void*, const Scalar*, double );
+    typedef void (*stepFunction)( void*, double, const Scalar*, Scalar* );
+    sizeFunction stateSize = (sizeFunction) dlsym( library, "verify_state_size" );
+    initFunction generatedInit = (initFunction) dlsym( library, "verify_init" );
+    stepFunction generatedStep = (stepFunction) dlsym( library, "verify_step" );
+
+    if ( !stateSize || !generatedInit || !generatedStep )
+    {
+        dlclose( library );
+        throw std::runtime_error("Generated controller is missing functions");
+    }
+
+    /* Reset controller and dynamics */
+    Rocket.resetDynamics();
+    PID.resetController();
+    PID.resetSaturator();
+
+    int Nsim = (int) simulationTime/Rocket.samplingTime;
+    std::vector<char> state( stateSize() );
+    VectorX<Scalar> u, uGenerated( nu );
+    VectorX<Scalar> y = Rocket.getOutput();
+
+    PID.init( y, Rocket.getTime() );
+    generatedInit( state.data(), y.data(), Rocket.getTime() );
+
+    // Step both controllers on the same outputs, the C++ controller closes the loop
+    float maxDifference = 0.0;
+    for (int i = 0; i < Nsim; ++i)
+    {
+        PID.step( Rocket.getTime(), y );
+        PID.getU( u );
+        generatedStep( state.data(), Rocket.getTime(), y.data(), uGenerated.data() );
+
+        maxDifference = std::max( maxDifference, (float) ( u - uGenerated ).cwiseAbs().maxCoeff() );
+        Rocket.step( u,y );
+    }
+    dlclose( library );
+
+    logger::info( "Generated controller ", headerFile, ": largest difference ", maxDifference, " over ", Nsim, " steps" );
+    return maxDifference;
+#else
+    throw std::runtime_error("Verification of generated code is only supported on Linux");
+#endif
+}
+
+
+template <class Model, class Scalar>
+void closedLoopSimulator<Model, Scalar>::setJournal( const std::string& fileName )
+{
+    campaignJournal = journal( fileName );
+}
+
+
+template <class Model, class Scalar>
+void closedLoopSimulator<Model, Scalar>::setCache( const std::string& fileName )
+{
+    cache = resultCache( fileName );
+}
+
+
+template <class Model, class Scalar>
+void closedLoopSimulator<Model, Scalar>::setMetrics( const metricSet& _metrics )
+{
+    metrics = _metrics;
+}
+
+
+template <class Model, class Scalar>
+void closedLoopSimulator<Model, Scalar>::setMetrics( const std::vector<std::string>& names )
+{
+    metrics = metricSet( names );
+}
+
+
+template <class Model, class Scalar>
+void closedLoopSimulator<Model, Scalar>::setResultStore( const std::string& fileName )
+{
+    storeFile = fileName;
+}
+
+
+template <class Model, class Scalar>
+void closedLoopSimulator<Model, Scalar>::setTrajectoryCompression( float tolerance )
+{
+    if ( tolerance < 0.0f )
+        throw std::invalid_argument("Trajectory tolerance must not be negative");
+
+    trajectoryTolerance = tolerance;
+}
+
+
+template <class Model, class Scalar>
+void closedLoopSimulator<Model, Scalar>::setGainScreen( const VectorXf& times, float _minGainMargin, float _minPhaseMargin )
+{
+    screenTimes = times;
+    minGainMargin = _minGainMargin;
+    minPhaseMargin = _minPhaseMargin;
+}
+
+
+template <class Model, class Scalar>
+void closedLoopSimulator<Model, Scalar>::setOutputPrefix( const std::string& prefix )
+{
+    outputPrefix = prefix;
+}
+
+
+
+//
+// PRIVATE MEMBER FUNCTIONS:
+//
+
+template <class Model, class Scalar>
+float closedLoopSimulator<Model, Scalar>::simulateApogee( float simulationTime )
+{
+    VectorXf result;
+    std::vector<std::string> states;
+    uint64_t key = 0;
+
+    // A noisy run draws from the noise streams: a hit continues them from the cached states,
+    // so later runs (and their keys) are the same as without the cache
+    bool noisy = Rocket.isNoisy() || PID.isNoisy();
+
+    if ( cache.isActive() )
+    {
+        key = runKey( PID, simulationTime );
+        if ( cache.lookup( key, result, states ) && result.size() == 2 + metrics.size() && ( !noisy || !states.empty() ) )
+        {
+            if ( noisy )
+                setGeneratorStates( states );
+            metricValues = result.tail( metrics.size() );
+            return result(0);
+        }
+    }
+
+    simulate( simulationTime, false );
+    metrics.getValues( metricValues );
+
+    // Apogee, its time and the chosen metrics
+    if ( cache.isActive() )
+    {
+        result.resize( 2 + metrics.size() );
+        result << apogee.value(), apogee.timeOfApogee(), metricValues;
+        cache.store( key, result, noisy ? getGeneratorStates() : std::vector<std::string>() );
+    }
+    return apogee.value();
+}
+
+
+template <class Model, class Scalar>
+uint64_t closedLoopSimulator<Model, Scalar>::runKey( const scalarPIDcontroller<Scalar>& controller, float simulationTime ) const
+{
+    // Key on everything that determines the run
+    configHash hash;
+    hash.add( simulationTime );
+    hash.add( samplingTime );
+    controller.hashConfiguration( hash );
+    Rocket.hashConfiguration( hash );
+    metrics.hashConfiguration( hash );
+    return hash.value();
+}
+
+
+template <class Model, class Scalar>
+uint64_t closedLoopSimulator<Model, Scalar>::campaignKey( const std::string& campaign, unsigned int shardIndex, unsigned int nShards ) const
+{
+    // Every run starts from the reset controller and dynamics
+    scalarPIDcontroller<Scalar> controller = PID;
+    controller.resetController();
+    controller.resetSaturator();
+
+    plantDynamics<Model, Scalar> plant = Rocket;
+    plant.resetDynamics();
+
+    configHash hash;
+    hash.add( campaign );
+    hash.add( shardIndex );
+    hash.add( nShards );
+    hash.add( samplingTime );
+    hash.add( screenTimes );
+    hash.add( minGainMargin );
+    hash.add( minPhaseMargin );
+    controller.hashConfiguration( hash );
+    plant.hashConfiguration( hash );
+    metrics.hashConfiguration( hash );
+    return hash.value();
+}
+
+
+template <class Model, class Scalar>
+MatrixXf closedLoopSimulator<Model, Scalar>::forkedSweep( std::vector<scalarPIDcontroller<Scalar> >& controllers, float simulationTime,
+                                                          unsigned long& plantSteps )
+{
+    if ( Rocket.isNoisy() )
+        throw std::invalid_argument("Runs with sensor noise cannot share the plant integration");
+    for ( unsigned int m=0; m<controllers.size(); ++m )
+        if ( controllers[m].isNoisy() )
+            throw std::invalid_argument("Runs with actuator noise cannot share the plant integration");
+
+    // Simulation points
+    int Nsim = (int) simulationTime/Rocket.samplingTime;
+    unsigned int n = controllers.size();
+
+    struct branch
+    {
+        plantDynamics<Model, Scalar> plant;         // Plant shared by the runs of the branch
+        std::vector<unsigned int> runs;             // Runs with identical control signals so far
+        VectorX<Scalar> y;                          // Output of the plant
+        int step;                                   // Next step
+        bool controlled;                            // Controllers already stepped for the next step
+    };
+
+    // Per run: control signal, error and streaming metrics
+    std::vector<VectorX<Scalar> > u( n, VectorX<Scalar>::Zero( nu ) );
+    std::vector<VectorX<Scalar> > e( n, VectorX<Scalar>::Zero( ny ) );
+    std::vector<apogeeMetric> runApogee( n );
+    std::vector<metricSet> runMetrics( n, metrics );
+
+    auto update = [&]( unsigned int m, const branch& b, float dt, bool saturated )
+    {
+        metricSample sample = { (float) b.plant.getTime(), dt, b.y.template cast<float>(), u[m].template cast<float>(),
+                                e[m].template cast<float>(), (float) b.plant.getOmega(), saturated };
+        runApogee[m].update( sample );
+        runMetrics[m].update( sample );
+    };
+
+    // All runs start on one branch
+    VectorX<Scalar> y = Rocket.getOutput();
+    std::vector<unsigned int> all( n );
+    for ( unsigned int m=0; m<n; ++m )
+        all[m] = m;
+
+    std::vector<branch> pending;
+    pending.push_back( { Rocket, all, y, 0, false } );
+
+    for ( unsigned int m=0; m<n; ++m )
+    {
+        controllers[m].init( y, Rocket.getTime() );
+        runApogee[m].reset();
+        runMetrics[m].reset();
+        update( m, pending[0], 0.0f, false );
+    }
+
+    // Branches are completed depth-first, so a run that split off is finished while its
+    // controller is still in cache
+    auto compare = [&]( unsigned int a, unsigned int c ) { return std::memcmp( u[a].data(), u[c].data(), nu*sizeof( Scalar ) ); };
+    plantSteps = 0;
+    while ( !pending.empty() )
+    {
+        branch current = pending.back();
+        pending.pop_back();
+        std::vector<unsigned int>& runs = current.runs;
+
+        for ( ; current.step < Nsim; current.step++ )
+        {
+            if ( !current.controlled )
+            {
+                for ( unsigned int m : runs )
+                {
+                    controllers[m].step( current.plant.getTime(), current.y );
+                    controllers[m].getU( u[m] );
+                    controllers[m].getError( e[m] );
+                }
+
+                // Group runs by bitwise identical control signal, every further group continues
+                // later from a copy of the plant
+                if ( runs.size() > 1 )
+                {
+                    std::sort( runs.begin(), runs.end(), [&]( unsigned int a, unsigned int c ) { return compare( a, c ) < 0; } );
+
+                    unsigned int end = runs.size();
+                    for ( unsigned int r=runs.size()-1; r>0; --r )
+                    {
+                        if ( compare( runs[r-1], runs[r] ) != 0 )
+                        {
+                            pending.push_back( { current.plant, std::vector<unsigned int>( runs.begin() + r, runs.begin() + end ),
+                                                 current.y, current.step, true } );
+                            end = r;
+                        }
+                    }
+                    runs.resize( end );
+                }
+            }
+            current.controlled = false;
+
+            current.plant.step( u[runs[0]], current.y );
+            plantSteps++;
+
+            for ( unsigned int m : runs )
+                update( m, current, current.plant.samplingTime, controllers[m].isSaturated() );
+        }
+    }
+
+    MatrixXf results( n, 2 + metrics.size() );
+    for ( unsigned int m=0; m<n; ++m )
+    {
+        VectorXf values;
+        runMetrics[m].getValues( values );
+        results.row(m) << runApogee[m].value(), runApogee[m].timeOfApogee(), values.transpose();
+    }
+    return results;
+}
+
+
+template <class Model, class Scalar>
+float closedLoopSimulator<Model, Scalar>::offsetDeviation( float altitudeOffset, float velocityOffset )
+{
+    /* Reset controller and dynamics */
+    VectorXf offsets = VectorXf::Zero( nx );        // State percentage offsets
+    offsets(1) = altitudeOffset;
+    offsets(3) = velocityOffset;
+
+    Rocket.resetDynamics( offsets );
+    PID.resetController();
+    PID.resetSaturator();
+
+    /* Closed-loop simulation */
+    return 3500 - simulateApogee( 20.0 );
+}
+
+
+template <class Model, class Scalar>
+void closedLoopSimulator<Model, Scalar>::closedLoop( float simulationTime, bool saveData, Map<MatrixXf>* trajectory, unsigned int decimation )
+{   
+    // Simulation points
+    int Nsim = (int) simulationTime/Rocket.samplingTime;
+
+    // Determine data saving
+    if (saveData)
+    {        
+        X = MatrixXf::Zero(nx+1, Nsim+1); X(seq(0, nx-1), 0) = Rocket.getState().template cast<float>();
+        Y = MatrixXf::Zero(ny, Nsim+1); Y.col(0) = Rocket.getOutput().template cast<float>();
+        U = MatrixXf::Zero(1, Nsim+1); U(0, 0) = 0.0;
+    }
+
+    // Control and output vectors
+    VectorX<Scalar> u = VectorX<Scalar>::Zero(nu);
+    VectorX<Scalar> y = Rocket.getOutput();
+    VectorX<Scalar> e = VectorX<Scalar>::Zero(ny);
+    
+    // Initialize controller
+    PID.init( y, Rocket.getTime() );
+
+    if ( trajectory )
+        trajectory->col(0) = Rocket.getState().template cast<float>();
+
+    // Initialize streaming metrics with the initial state
+    apogee.reset();
+    metrics.reset();
+    updateMetrics( Rocket.getTime(), 0.0f, y, u, e, Rocket.getOmega(), false );
+
+    // Run closed-loop simulation
+    for (int i = 0; i < Nsim; ++i)
+    {
+        PID.step( Rocket.getTime(), y );
+        PID.getU( u );
+        PID.getError( e );
+        Rocket.step( u,y );
+
+        updateMetrics( Rocket.getTime(), Rocket.samplingTime, y, u, e, Rocket.getOmega(), PID.isSaturated() );
+
+        if ( trajectory && (i+1)%decimation == 0 )
+            trajectory->col( (i+1)/decimation ) = Rocket.getState().template cast<float>();
+
+        if (saveData)
+        {
+            // Store data
+            X(seq(0, nx-1), i+1) = Rocket.getState().template cast<float>();
+            X(nx, i+1) = Rocket.getOmega();
+            Y(seq(0, ny-1), i+1) = y.template cast<float>();
+            U(0, i+1) = u(0);
+
+            if ((i+1)%25 == 0)
+            {
+                logger::debug( "Altitude: ", y(0), " Time: ", Rocket.getTime(), " iteration ", i+1, " out of ", Nsim );
+            }
+        } 
+    }
+
+    // Export data
+    if (saveData)
+    {
+        saveTrajectories(  );
+        printMetrics(  );
+    }
+}
+
+
+template <class Model, class Scalar>
+void closedLoopSimulator<Model, Scalar>::updateMetrics( Scalar time, float dt, const VectorX<Scalar>& y, const VectorX<Scalar>& u,
+                                                        const VectorX<Scalar>& error, Scalar omega, bool saturated )
+{
+    // Metrics are evaluated in single precision (no copies when Scalar is float)
+    metricSample sample = { (float) time, dt, y.template cast<float>(), u.template cast<float>(),
+                            error.template cast<float>(), (float) omega, saturated };
+
+    apogee.update( sample );
+    metrics.update( sample );
+}
+
+
+template <class Model, class Scalar>
+void closedLoopSimulator<Model, Scalar>::printMetrics(  ) const
+{
+    VectorXf values;
+    metrics.getValues( values );
+
+    // Prefixed by the output prefix, so lines of concurrent scenarios can be told apart
+    std::string run = "[" + outputPrefix + "] ";
+    logger::info( run, "Apogee: ", apogee.value() );
+    for ( unsigned int i=0; i<metrics.size(); ++i )
+        logger::info( run, metrics.getNames()[i], ": ", values(i) );
+}
+
+
+template <class Model, class Scalar>
+void closedLoopSimulator<Model, Scalar>::saveTrajectories(  )
+{
+    if ( trajectoryTolerance > 0.0f )
+    {
+        trajectoryCodec::save( outputPrefix + "state.trj", X, trajectoryTolerance );
+        trajectoryCodec::save( outputPrefix + "output.trj", Y, trajectoryTolerance );
+        trajectoryCodec::save( outputPrefix + "input.trj", U, trajectoryTolerance );
+    }
+    else
+    {
+        saveToFile(X, X.rows(), X.cols(), outputPrefix + "state.csv");
+        saveToFile(Y, Y.rows(), Y.cols(), outputPrefix + "output.csv");
+        saveToFile(U, U.rows(), U.cols(), outputPrefix + "input.csv");
+    }
+}
+
+
+template <class Model, class Scalar>
+void closedLoopSimulator<Model, Scalar>::saveMetrics( MatrixXf& table ) const
+{
+    if ( metrics.size() == 0 )
+        return;
+
+    saveToFile(table, table.rows(), table.cols(), outputPrefix + "metrics.csv");
+
+    ofstream File( outputPrefix + "metricNames.csv" );
+    for ( unsigned int i=0; i<metrics.size(); ++i )
+        File << metrics.getNames()[i] << ( i+1 < metrics.size() ? "," : "\n" );
+}
+
+
+template <class Model, class Scalar>
+void closedLoopSimulator<Model, Scalar>::saveStore( const std::vector<std::string>& inputNames, const MatrixXf& inputs,
+                                            const MatrixXf& deviations, const MatrixXf& metricTable ) const
+{
+    if ( storeFile.empty() )
+        return;
+
+    // Schema: inputs, deviation, metrics
+    std::vector<std::string> columns = inputNames;
+    columns.push_back( "deviation" );
+    columns.insert( columns.end(), metrics.getNames().begin(), metrics.getNames().end() );
+
+    MatrixXf rows( inputs.rows(), columns.size() );
+    rows << inputs, deviations, metricTable;
+
+    resultStore store;
+    store.create( storeFile, columns );
+    store.append( rows );
+    store.close();
+}
+
+
+template <class Model, class Scalar>
+MatrixXf closedLoopSimulator<Model, Scalar>::gridOffsets( unsigned int nPoints ) const
+{
+    // Robustness grid: 21 x 21 relative offsets of altitude and velocity in steps of 1%
+    MatrixXf offsets( nPoints, 2 );
+    for ( unsigned int k=0; k<nPoints; ++k )
+    {
+        offsets(k,0) = ( (int) k/21 - 10 )*0.10/10.0;
+        offsets(k,1) = ( (int) k%21 - 10 )*0.10/10.0;
+    }
+    return offsets;
+}
+
+
+template <class Model, class Scalar>
+std::string closedLoopSimulator<Model, Scalar>::shardFileName( unsigned int shardIndex, unsigned int nShards ) const
+{
+    return outputPrefix + "robustness.shard" + std::to_string( shardIndex ) + "of" + std::to_string( nShards ) + ".csv";
+}
+
+
+template <class Model, class Scalar>
+void closedLoopSimulator<Model, Scalar>::applyUncertainty( const std::vector<uncertainParameter>& parameters, const VectorXf& values,
+                                                           plantDynamics<Model, Scalar>& rocket, scalarPIDcontroller<Scalar>& controller,
+                                                           VectorXf& offsets )
+{
+    for ( unsigned int j=0; j<parameters.size(); ++j )
+    {
+        const uncertainParameter& p = parameters[j];
+        float value = values(j);
+
+        if ( p.name == "state" )
+        {
+            if ( p.index >= offsets.size() )
+                throw std::invalid_argument("Invalid index for state component given");
+            offsets( p.index ) = value;
+        }
+        else if ( p.name == "sensorBias" )
+            rocket.setBias( p.index, value );
+        else if ( p.name == "sensorNoise" )
+            rocket.setNoise( p.index, value );
+        else if ( p.name == "actuatorBias" )
+            controller.setBias( p.index, value );
+        else if ( p.name == "actuatorNoise" )
+            controller.setNoise( p.index, value );
+        else
+            rocket.setParameter( p.name, value );
+    }
+}
+
+
+template <class Model, class Scalar>
+void closedLoopSimulator<Model, Scalar>::applyTuning( const std::vector<tuningParameter>& parameters, const VectorXf& values,
+                                                      scalarPIDcontroller<Scalar>& controller )
+{
+    for ( unsigned int j=0; j<parameters.size(); ++j )
+    {
+        const tuningParameter& p = parameters[j];
+        float value = values(j);
+
+        if      ( p.name == "pGain" ) controller.setProportionalGains( p.index, value );
+        else if ( p.name == "iGain" ) controller.setIntegralGains( p.index, value );
+        else if ( p.name == "dGain" ) controller.setDerivativeGains( p.index, value );
+        else if ( p.name == "rateLimit" )
+        {
+            controller.setControlLowerRateLimit( p.index, -value );
+            controller.setControlUpperRateLimit( p.index, value );
+        }
+        else if ( p.name == "lowerRateLimit" ) controller.setControlLowerRateLimit( p.index, value );
+        else if ( p.name == "upperRateLimit" ) controller.setControlUpperRateLimit( p.index, value );
+        else if ( p.name == "lowerLimit" ) controller.setControlLowerLimit( p.index, value );
+        else if ( p.name == "upperLimit" ) controller.setControlUpperLimit( p.index, value );
+        else
+            throw std::invalid_argument("Unknown tuning parameter " + p.name);
+    }
+}
+
+
+template <class Model, class Scalar>
+std::vector<std::string> closedLoopSimulator<Model, Scalar>::getGeneratorStates(  ) const
+{
+    std::vector<std::string> states;
+    states.push_back( Rocket.getGeneratorState() );
+    states.push_back( PID.getGeneratorState() );
+    return states;
+}
+
+
+template <class Model, class Scalar>
+void closedLoopSimulator<Model, Scalar>::setGeneratorStates( const std::vector<std::string>& states )
+{
+    if ( states.size() != 2 )
+        throw std::invalid_argument("Incorrect number of generator states given");
+
+    Rocket.setGeneratorState( states[0] );
+    PID.setGeneratorState( states[1] );
+}
+
+
+
+//
+// EXPLICIT INSTANTIATIONS:
+//
+
+template class closedLoopSimulator<rocketModel, float>;
+template class closedLoopSimulator<rocketModel, double>;
+template class closedLoopSimulator<poweredAscentModel, float>;
+template class closedLoopSimulator<poweredAscentModel, double>;
@@ -0,0 +1,362 @@
+/**
+ *	\file src/surrogate.cpp
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#include "../header.h"    // #include header
+
+#include <functional>
+
+static const char surrogateMagic[8] = { 'R','S','U','R','R','0','0','1' };
+
+
+/** Legendre polynomials L_0 ... L_order at s (double precision, for fitting)
+ */
+static void legendre( double s, unsigned int order, double* L )
+{
+    L[0] = 1.0;
+    if ( order > 0 )
+        L[1] = s;
+    for ( unsigned int k=1; k<order; ++k )
+        L[k+1] = ( (2*k+1)*s*L[k] - k*L[k-1] )/(k+1);
+}
+
+
+//
+// PUBLIC MEMBER FUNCTIONS:
+//
+
+surrogateModel::surrogateModel(  ){}
+
+
+surrogateModel::~surrogateModel(  ){}
+
+
+void surrogateModel::fitRBF( const MatrixXf& inputs, const VectorXf& outputs, float _smoothing )
+{
+    checkData( inputs, outputs );
+    if ( _smoothing < 0.0f )
+        throw std::invalid_argument("RBF smoothing must be non-negative");
+
+    nInputs = inputs.cols();
+    setScaling( inputs );
+    MatrixXd X = scaledInputs( inputs );
+    unsigned int n = X.rows(), m = n + nInputs + 1;
+
+    // Interpolation system [ Phi + smoothing*I, P; P', 0 ] [ w; c ] = [ outputs; 0 ]
+    MatrixXd A = MatrixXd::Zero( m, m );
+    VectorXd b = VectorXd::Zero( m );
+    for ( unsigned int j=0; j<n; ++j )
+    {
+        for ( unsigned int k=0; k<j; ++k )
+        {
+            double r = ( X.row(j) - X.row(k) ).norm();
+            A(j,k) = A(k,j) = r*r*r;
+        }
+        A(j,j) = _smoothing;
+
+        A(j,n) = A(n,j) = 1.0;
+        for ( unsigned int i=0; i<nInputs; ++i )
+            A(j,n+1+i) = A(n+1+i,j) = X(j,i);
+        b(j) = outputs(j);
+    }
+
+    VectorXd solution = A.partialPivLu().solve( b );
+    if ( !solution.allFinite() )
+        throw std::runtime_error("RBF system is singular (duplicate training inputs?)");
+
+    type = RBF;
+    smoothing = _smoothing;
+    centers = X.cast<float>();
+    weights = solution.cast<float>();
+
+    order = 0;
+    multiIndices.resize( 0, 0 );
+    coefficients.resize( 0 );
+}
+
+
+void surrogateModel::fitPolynomialChaos( const MatrixXf& inputs, const VectorXf& outputs, unsigned int _order )
+{
+    checkData( inputs, outputs );
+    if ( _order > MAX_ORDER )
+        throw std::invalid_argument("Polynomial chaos order too large");
+
+    nInputs = inputs.cols();
+
+    // Multi-indices of total degree <= order, by increasing degree
+    std::vector<int> alpha( nInputs, 0 ), indices;
+    std::function<void( unsigned int, unsigned int )> enumerate = [&]( unsigned int i, unsigned int remaining )
+    {
+        if ( i == nInputs-1 )
+        {
+            alpha[i] = remaining;
+            indices.insert( indices.end(), alpha.begin(), alpha.end() );
+            return;
+        }
+        for ( int k=remaining; k>=0; --k )
+        {
+            alpha[i] = k;
+            enumerate( i+1, remaining-k );
+        }
+    };
+    for ( unsigned int degree=0; degree<=_order; ++degree )
+        enumerate( 0, degree );
+
+    unsigned int nTerms = indices.size()/nInputs;
+    if ( nTerms > inputs.rows() )
+        throw std::invalid_argument("Fewer training runs than polynomial chaos terms");
+
+    setScaling( inputs );
+    MatrixXd X = scaledInputs( inputs );
+
+    // Least squares over the basis evaluated at the training inputs
+    MatrixXd Psi( X.rows(), nTerms );
+    std::vector<double> L( nInputs*(_order+1) );
+    for ( unsigned int k=0; k<X.rows(); ++k )
+    {
+        for ( unsigned int i=0; i<nInputs; ++i )
+            legendre( X(k,i), _order, &L[i*(_order+1)] );
+
+        for ( unsigned int t=0; t<nTerms; ++t )
+        {
+            double value = 1.0;
+            for ( unsigned int i=0; i<nInputs; ++i )
+                value *= L[i*(_order+1) + indices[t*nInputs+i]];
+            Psi(k,t) = value;
+        }
+    }
+
+    type = POLYNOMIAL_CHAOS;
+    order = _order;
+    multiIndices = Map<MatrixXi>( indices.data(), nInputs, nTerms );
+    coefficients = Psi.colPivHouseholderQr().solve( outputs.cast<double>() ).cast<float>();
+
+    smoothing = 0.0;
+    centers.resize( 0, 0 );
+    weights.resize( 0 );
+}
+
+
+VectorXf surrogateModel::crossValidate( const MatrixXf& inputs, const VectorXf& outputs, unsigned int nFolds ) const
+{
+    checkData( inputs, outputs );
+    if ( type == NONE )
+        throw std::runtime_error("No surrogate representation fitted");
+    if ( nFolds < 2 || nFolds > inputs.rows() )
+        throw std::invalid_argument("Invalid number of folds given");
+
+    unsigned int n = inputs.rows();
+    VectorXf errors( n );
+
+    for ( unsigned int f=0; f<nFolds; ++f )
+    {
+        // Interleaved folds: run k is left out in fold k % nFolds
+        unsigned int nTest = ( n - f + nFolds - 1 )/nFolds;
+        MatrixXf trainInputs( n - nTest, inputs.cols() ), testInputs( nTest, inputs.cols() );
+        VectorXf trainOutputs( n - nTest );
+        std::vector<unsigned int> testRuns;
+
+        for ( unsigned int k=0, train=0; k<n; ++k )
+        {
+            if ( k % nFolds == f )
+            {
+                testInputs.row( testRuns.size() ) = inputs.row(k);
+                testRuns.push_back( k );
+            }
+            else
+            {
+                trainInputs.row( train ) = inputs.row(k);
+                trainOutputs( train++ ) = outputs(k);
+            }
+        }
+
+        surrogateModel model;
+        if ( type == RBF )
+            model.fitRBF( trainInputs, trainOutputs, smoothing );
+        else
+            model.fitPolynomialChaos( trainInputs, trainOutputs, order );
+
+        VectorXf predicted;
+        model.evaluate( testInputs, predicted );
+        for ( unsigned int j=0; j<testRuns.size(); ++j )
+            errors( testRuns[j] ) = predicted(j) - outputs( testRuns[j] );
+    }
+
+    VectorXf result( 2 );
+    result << sqrt( errors.squaredNorm()/n ), errors.cwiseAbs().maxCoeff();
+    return result;
+}
+
+
+void surrogateModel::evaluate( const MatrixXf& inputs, VectorXf& outputs ) const
+{
+    if ( inputs.cols() != nInputs )
+        throw std::invalid_argument("Number of inputs does not match surrogate model");
+
+    outputs.resize( inputs.rows() );
+    VectorXf x( nInputs );
+    for ( unsigned int k=0; k<inputs.rows(); ++k )
+    {
+        x = inputs.row(k).transpose();
+        outputs(k) = evaluate( x.data() );
+    }
+}
+
+
+void surrogateModel::save( const std::string& fileName ) const
+{
+    if ( type == NONE )
+        throw std::runtime_error("No surrogate representation fitted");
+
+    std::ofstream output( fileName, std::ios::binary );
+    if ( !output.is_open() )
+        throw std::runtime_error("Could not open file " + fileName);
+
+    uint32_t header[2] = { (uint32_t) type, nInputs };
+    output.write( surrogateMagic, 8 );
+    output.write( (const char*) header, 8 );
+    output.write( (const char*) offset.data(), 4*nInputs );
+    output.write( (const char*) scale.data(), 4*nInputs );
+
+    if ( type == RBF )
+    {
+        uint32_t nCenters = centers.rows();
+        output.write( (const char*) &nCenters, 4 );
+        output.write( (const char*) &smoothing, 4 );
+        output.write( (const char*) centers.data(), 4*centers.size() );
+        output.write( (const char*) weights.data(), 4*weights.size() );
+    }
+    else
+    {
+        uint32_t nTerms = coefficients.size();
+        std::vector<uint8_t> degrees( multiIndices.data(), multiIndices.data() + multiIndices.size() );
+        output.write( (const char*) &order, 4 );
+        output.write( (const char*) &nTerms, 4 );
+        output.write( (const char*) degrees.data(), degrees.size() );
+        output.write( (const char*) coefficients.data(), 4*coefficients.size() );
+    }
+
+    if ( !output.good() )
+        throw std::runtime_error("Could not write surrogate model " + fileName);
+}
+
+
+void surrogateModel::load( const std::string& fileName )
+{
+    std::ifstream input( fileName, std::ios::binary );
+    if ( !input.is_open() )
+        throw std::runtime_error("Could not open file " + fileName);
+
+    char magic[8];
+    uint32_t header[2];
+    input.read( magic, 8 );
+    input.read( (char*) header, 8 );
+    if ( !input.good() || memcmp( magic, surrogateMagic, 8 ) != 0 )
+        throw std::runtime_error("Not a surrogate model: " + fileName);
+    if ( ( header[0] != RBF && header[0] != POLYNOMIAL_CHAOS ) || header[1] == 0 || header[1] > MAX_INPUTS )
+        throw std::runtime_error("Corrupt surrogate model " + fileName);
+
+    surrogateModel model;
+    model.type = (representation) header[0];
+    model.nInputs = header[1];
+    model.offset.resize( model.nInputs );
+    model.scale.resize( model.nInputs );
+    input.read( (char*) model.offset.data(), 4*model.nInputs );
+    input.read( (char*) model.scale.data(), 4*model.nInputs );
+
+    if ( model.type == RBF )
+    {
+        uint32_t nCenters = 0;
+        input.read( (char*) &nCenters, 4 );
+        input.read( (char*) &model.smoothing, 4 );
+        if ( !input.good() || nCenters > ( 1u << 24 ) )
+            throw std::runtime_error("Corrupt surrogate model " + fileName);
+
+        model.centers.resize( nCenters, model.nInputs );
+        model.weights.resize( nCenters + model.nInputs + 1 );
+        input.read( (char*) model.centers.data(), 4*model.centers.size() );
+        input.read( (char*) model.weights.data(), 4*model.weights.size() );
+    }
+    else
+    {
+        uint32_t nTerms = 0;
+        input.read( (char*) &model.order, 4 );
+        input.read( (char*) &nTerms, 4 );
+        if ( !input.good() || model.order > MAX_ORDER || nTerms > ( 1u << 24 ) )
+            throw std::runtime_error("Corrupt surrogate model " + fileName);
+
+        std::vector<uint8_t> degrees( (size_t) model.nInputs*nTerms );
+        input.read( (char*) degrees.data(), degrees.size() );
+        model.multiIndices = Map<Matrix<uint8_t, Dynamic, Dynamic> >( degrees.data(), model.nInputs, nTerms ).cast<int>();
+        if ( model.multiIndices.size() > 0 && model.multiIndices.maxCoeff() > (int) model.order )
+            throw std::runtime_error("Corrupt surrogate model " + fileName);
+
+        model.coefficients.resize( nTerms );
+        input.read( (char*) model.coefficients.data(), 4*nTerms );
+    }
+
+    if ( !input.good() )
+        throw std::runtime_error("Truncated surrogate model " + fileName);
+
+    *this = model;
+}
+
+
+surrogateModel::representation surrogateModel::getType(  ) const
+{
+    return type;
+}
+
+
+unsigned int surrogateModel::getNumInputs(  ) const
+{
+    return nInputs;
+}
+
+
+unsigned int surrogateModel::getNumTerms(  ) const
+{
+    return ( type == RBF ) ? centers.rows() : coefficients.size();
+}
+
+
+
+//
+// PRIVATE MEMBER FUNCTIONS:
+//
+
+void surrogateModel::setScaling( const MatrixXf& inputs )
+{
+    VectorXf lower = inputs.colwise().minCoeff();
+    VectorXf upper = inputs.colwise().maxCoeff();
+
+    for ( unsigned int i=0; i<nInputs; ++i )
+        if ( !( upper(i) > lower(i) ) )
+            throw std::invalid_argument("Input " + std::to_string( i ) + " is constant in the training data");
+
+    offset = ( upper + lower )/2.0f;
+    scale = 2.0f/( upper - lower ).array();
+}
+
+
+MatrixXd surrogateModel::scaledInputs( const MatrixXf& inputs ) const
+{
+    MatrixXd X( inputs.rows(), nInputs );
+    for ( unsigned int i=0; i<nInputs; ++i )
+        X.col(i) = ( ( inputs.col(i).array() - offset(i) )*scale(i) ).cast<double>();
+    return X;
+}
+
+
+void surrogateModel::checkData( const MatrixXf& inputs, const VectorXf& outputs ) const
+{
+    if ( inputs.rows() != outputs.size() )
+        throw std::invalid_argument("Number of training inputs does not match number of outputs");
+    if ( inputs.cols() == 0 || inputs.cols() > MAX_INPUTS )
+        throw std::invalid_argument("Invalid number of surrogate inputs");
+    if ( inputs.rows() < inputs.cols() + 2 )
+        throw std::invalid_argument("Not enough training runs for surrogate model");
+}
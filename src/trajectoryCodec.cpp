@@ -0,0 +1,387 @@
+/**
+ *	\file src/trajectoryCodec.cpp
+ *	\author Mike Timmerman
+ *	\version 1.0
+ *	\date 2022
+ */
+
+#include "../header.h"    // #include header
+
+
+static const uint32_t TRAJECTORY_MAGIC = 0x314a5254;      // "TRJ1"
+static const double MAX_QUANTIZED = 1152921504606846976.0;  // 2^60: residuals fit in 63 bits
+static const unsigned int MINI_BLOCK = 32;                  // Residuals sharing one bit width
+
+
+/** Append bits to a byte buffer, least significant bit first
+ */
+struct bitWriter
+{
+    std::vector<unsigned char>& bytes;
+    uint64_t pending = 0;
+    unsigned int nPending = 0;
+
+    bitWriter( std::vector<unsigned char>& _bytes ) : bytes( _bytes ) {}
+
+    void put( uint64_t value, unsigned int width )
+    {
+        while ( width > 0 )
+        {
+            unsigned int n = std::min( width, 32u );
+            pending |= ( value & ( ( uint64_t( 1 ) << n ) - 1 ) ) << nPending;
+            nPending += n;
+            value >>= n;
+            width -= n;
+            for ( ; nPending >= 8; nPending -= 8, pending >>= 8 )
+                bytes.push_back( pending & 0xff );
+        }
+    }
+
+    void finish(  )
+    {
+        if ( nPending > 0 )
+            bytes.push_back( pending & 0xff );
+        pending = 0;
+        nPending = 0;
+    }
+};
+
+
+/** Read bits from a byte buffer, least significant bit first
+ */
+struct bitReader
+{
+    const unsigned char* bytes;
+    const unsigned char* end;
+    uint64_t pending = 0;
+    unsigned int nPending = 0;
+
+    bitReader( const unsigned char* _bytes, const unsigned char* _end ) : bytes( _bytes ), end( _end ) {}
+
+    uint64_t get( unsigned int width )
+    {
+        uint64_t value = 0;
+        for ( unsigned int shift=0; shift<width; )
+        {
+            unsigned int n = std::min( width - shift, 32u );
+            while ( nPending < n )
+            {
+                if ( bytes == end )
+                    throw std::runtime_error("Truncated trajectory block");
+                pending |= uint64_t( *bytes++ ) << nPending;
+                nPending += 8;
+            }
+            value |= ( pending & ( ( uint64_t( 1 ) << n ) - 1 ) ) << shift;
+            pending >>= n;
+            nPending -= n;
+            shift += n;
+        }
+        return value;
+    }
+
+    void finish(  )
+    {
+        pending = 0;
+        nPending = 0;
+    }
+};
+
+
+/** Prediction of sample k (k > 0) from the previous quantized values: constant (order 1) or
+ *  linear extrapolation (order 2)
+ */
+static int64_t predict( const int64_t* quantized, unsigned int k, unsigned int order )
+{
+    if ( order == 1 || k == 1 )
+        return quantized[k-1];
+    return 2*quantized[k-1] - quantized[k-2];
+}
+
+
+/** Number of bits of the largest of n values
+ */
+static unsigned int bitWidth( const uint64_t* values, unsigned int n )
+{
+    uint64_t all = 0;
+    for ( unsigned int j=0; j<n; ++j )
+        all |= values[j];
+
+    unsigned int width = 0;
+    while ( width < 64 && ( all >> width ) != 0 )
+        width++;
+    return width;
+}
+
+
+static uint64_t zigzag( int64_t value )
+{
+    return ( uint64_t( value ) << 1 ) ^ uint64_t( value >> 63 );
+}
+
+
+static int64_t unzigzag( uint64_t value )
+{
+    return int64_t( value >> 1 ) ^ -int64_t( value & 1 );
+}
+
+
+
+//
+// PUBLIC MEMBER FUNCTIONS:
+//
+
+trajectoryCodec::trajectoryCodec(  )
+{
+    nSignals = 0;
+    nSamples = 0;
+    blockSize = 0;
+}
+
+
+trajectoryCodec::~trajectoryCodec(  ){}
+
+
+void trajectoryCodec::save( const std::string& fileName, const MatrixXf& data, const VectorXf& tolerances,
+                            unsigned int blockSize )
+{
+    if ( tolerances.size() != data.rows() )
+        throw std::invalid_argument("Number of tolerances does not match number of signals");
+    if ( data.rows() > 0 && tolerances.minCoeff() <= 0.0f )
+        throw std::invalid_argument("Tolerances must be positive");
+    if ( blockSize < 2 )
+        throw std::invalid_argument("Block size must be at least two samples");
+
+    uint32_t header[4] = { TRAJECTORY_MAGIC, (uint32_t) data.rows(), (uint32_t) data.cols(), blockSize };
+    VectorXd steps = 2.0*tolerances.cast<double>();
+    unsigned int nBlocks = ( data.cols() + blockSize - 1 )/blockSize;
+
+    // Quantized values: rounding to the nearest step keeps the error within the tolerance
+    std::vector<int64_t> quantized( blockSize );
+    std::vector<uint64_t> residuals[2] = { std::vector<uint64_t>( blockSize ), std::vector<uint64_t>( blockSize ) };
+    std::vector<unsigned char> blocks;
+    std::vector<uint64_t> offsets( nBlocks + 1 );
+    bitWriter writer( blocks );
+
+    for ( unsigned int b=0; b<nBlocks; ++b )
+    {
+        offsets[b] = blocks.size();
+        unsigned int first = b*blockSize;
+        unsigned int count = std::min<unsigned int>( blockSize, data.cols() - first );
+
+        for ( unsigned int i=0; i<data.rows(); ++i )
+        {
+            for ( unsigned int k=0; k<count; ++k )
+            {
+                double scaled = std::round( data( i, first+k )/steps(i) );
+                if ( !( std::abs( scaled ) < MAX_QUANTIZED ) )
+                    throw std::invalid_argument("Trajectory value is not finite or too large for its tolerance");
+                quantized[k] = (int64_t) scaled;
+            }
+
+            // Residuals of both predictors, the one with the fewest bits is kept
+            unsigned int bestOrder = 1;
+            uint64_t bestBits = UINT64_MAX;
+            for ( unsigned int order=1; order<=2; ++order )
+            {
+                for ( unsigned int k=1; k<count; ++k )
+                    residuals[order-1][k] = zigzag( quantized[k] - predict( quantized.data(), k, order ) );
+
+                uint64_t bits = 0;
+                for ( unsigned int k=1; k<count; k+=MINI_BLOCK )
+                {
+                    unsigned int n = std::min( MINI_BLOCK, count - k );
+                    bits += 8 + n*bitWidth( residuals[order-1].data() + k, n );
+                }
+                if ( bits < bestBits )
+                {
+                    bestBits = bits;
+                    bestOrder = order;
+                }
+            }
+
+            writer.put( bestOrder, 8 );
+            writer.put( zigzag( quantized[0] ), 64 );
+            for ( unsigned int k=1; k<count; k+=MINI_BLOCK )
+            {
+                unsigned int n = std::min( MINI_BLOCK, count - k );
+                const uint64_t* r = residuals[bestOrder-1].data() + k;
+                unsigned int width = bitWidth( r, n );
+
+                writer.put( width, 8 );
+                for ( unsigned int j=0; j<n; ++j )
+                    writer.put( r[j], width );
+            }
+            writer.finish();
+        }
+    }
+    offsets[nBlocks] = blocks.size();
+
+    std::ofstream File( fileName, std::ios::binary );
+    if ( !File.is_open() )
+        throw std::runtime_error("Could not open file " + fileName);
+
+    File.write( (const char*) header, sizeof( header ) );
+    File.write( (const char*) steps.data(), steps.size()*sizeof( double ) );
+    File.write( (const char*) offsets.data(), offsets.size()*sizeof( uint64_t ) );
+    File.write( (const char*) blocks.data(), blocks.size() );
+
+    if ( !File )
+        throw std::runtime_error("Could not write trajectory file " + fileName);
+}
+
+
+void trajectoryCodec::save( const std::string& fileName, const MatrixXf& data, float tolerance, unsigned int blockSize )
+{
+    save( fileName, data, VectorXf::Constant( data.rows(), tolerance ), blockSize );
+}
+
+
+bool trajectoryCodec::isTrajectory( const std::string& fileName )
+{
+    std::ifstream File( fileName, std::ios::binary );
+    uint32_t magic = 0;
+    File.read( (char*) &magic, sizeof( magic ) );
+    return File && magic == TRAJECTORY_MAGIC;
+}
+
+
+void trajectoryCodec::open( const std::string& fileName )
+{
+    close();
+
+    file.open( fileName, std::ios::binary );
+    if ( !file.is_open() )
+        throw std::runtime_error("Could not open file " + fileName);
+
+    uint32_t header[4];
+    file.read( (char*) header, sizeof( header ) );
+    if ( !file || header[0] != TRAJECTORY_MAGIC )
+        throw std::runtime_error("Not a trajectory file: " + fileName);
+    if ( header[3] < 2 )
+        throw std::runtime_error("Corrupt trajectory file " + fileName);
+
+    nSignals = header[1];
+    nSamples = header[2];
+    blockSize = header[3];
+
+    unsigned int nBlocks = ( nSamples + blockSize - 1 )/blockSize;
+    steps.resize( nSignals );
+    offsets.resize( nBlocks + 1 );
+    file.read( (char*) steps.data(), nSignals*sizeof( double ) );
+    file.read( (char*) offsets.data(), offsets.size()*sizeof( uint64_t ) );
+    if ( !file )
+        throw std::runtime_error("Truncated trajectory file " + fileName);
+
+    // Block offsets are relative to the end of the index
+    uint64_t dataStart = file.tellg();
+    for ( unsigned int b=0; b<offsets.size(); ++b )
+        offsets[b] += dataStart;
+}
+
+
+void trajectoryCodec::close(  )
+{
+    if ( file.is_open() )
+        file.close();
+    file.clear();
+
+    nSignals = 0;
+    nSamples = 0;
+    offsets.clear();
+}
+
+
+unsigned int trajectoryCodec::getNumSignals(  ) const
+{
+    return nSignals;
+}
+
+
+unsigned int trajectoryCodec::getNumSamples(  ) const
+{
+    return nSamples;
+}
+
+
+MatrixXf trajectoryCodec::read(  )
+{
+    return read( 0, nSamples );
+}
+
+
+MatrixXf trajectoryCodec::read( unsigned int first, unsigned int count )
+{
+    if ( !file.is_open() )
+        throw std::runtime_error("Trajectory file is not open");
+    if ( (uint64_t) first + count > nSamples )
+        throw std::invalid_argument("Sample range exceeds trajectory");
+
+    MatrixXf data( nSignals, count );
+    if ( count == 0 )
+        return data;
+
+    // Blocks overlapping the range are decoded whole, the requested columns are kept
+    unsigned int firstBlock = first/blockSize;
+    unsigned int lastBlock = ( first + count - 1 )/blockSize;
+    MatrixXf block( nSignals, blockSize );
+
+    for ( unsigned int b=firstBlock; b<=lastBlock; ++b )
+    {
+        unsigned int blockFirst = b*blockSize;
+        unsigned int blockCount = std::min( blockSize, nSamples - blockFirst );
+
+        unsigned int from = std::max( first, blockFirst );
+        unsigned int to = std::min( first + count, blockFirst + blockCount );
+
+        if ( from == blockFirst && to == blockFirst + blockCount )
+            decodeBlock( b, data, blockFirst - first );
+        else
+        {
+            decodeBlock( b, block, 0 );
+            data.middleCols( from - first, to - from ) = block.middleCols( from - blockFirst, to - from );
+        }
+    }
+    return data;
+}
+
+
+
+//
+// PRIVATE MEMBER FUNCTIONS:
+//
+
+void trajectoryCodec::decodeBlock( unsigned int block, MatrixXf& data, unsigned int column )
+{
+    unsigned int count = std::min( blockSize, nSamples - block*blockSize );
+
+    buffer.resize( offsets[block+1] - offsets[block] );
+    file.seekg( offsets[block] );
+    file.read( (char*) buffer.data(), buffer.size() );
+    if ( !file )
+        throw std::runtime_error("Truncated trajectory file");
+
+    bitReader reader( buffer.data(), buffer.data() + buffer.size() );
+    std::vector<int64_t> quantized( count );
+    for ( unsigned int i=0; i<nSignals; ++i )
+    {
+        unsigned int order = reader.get( 8 );
+        if ( order < 1 || order > 2 )
+            throw std::runtime_error("Corrupt trajectory block");
+
+        quantized[0] = unzigzag( reader.get( 64 ) );
+        for ( unsigned int k=1; k<count; k+=MINI_BLOCK )
+        {
+            unsigned int n = std::min( MINI_BLOCK, count - k );
+            unsigned int width = reader.get( 8 );
+            if ( width > 64 )
+                throw std::runtime_error("Corrupt trajectory block");
+
+            for ( unsigned int j=k; j<k+n; ++j )
+                quantized[j] = predict( quantized.data(), j, order ) + unzigzag( reader.get( width ) );
+        }
+        reader.finish();
+
+        for ( unsigned int k=0; k<count; ++k )
+            data( i, column+k ) = quantized[k]*steps(i);
+    }
+}